@@ -0,0 +1,82 @@
+#ifndef SIXNIMMT_AGENT_PLUGIN_H
+#define SIXNIMMT_AGENT_PLUGIN_H
+
+/*
+ * C interface for agents built as shared libraries and loaded at run time
+ * (plugin_loader.h). A plugin exports sixnimmt_agent_plugin(), which returns
+ * its agents one index at a time and NULL past the last. Everything crossing
+ * the boundary is plain C: fixed-size structs, no allocation and no C++
+ * types, so a plugin does not have to be built with the same compiler or
+ * standard library as the contest.
+ *
+ * The loader rejects a plugin whose abi_version differs from its own; any
+ * change to the structs below bumps SIXNIMMT_PLUGIN_ABI_VERSION.
+ */
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SIXNIMMT_PLUGIN_ABI_VERSION 1
+
+#define SIXNIMMT_PLUGIN_ROWS 4
+#define SIXNIMMT_PLUGIN_ROW_LENGTH 5
+#define SIXNIMMT_PLUGIN_MAX_PLAYERS 10
+#define SIXNIMMT_PLUGIN_MAX_HAND 10
+
+/* The table as the deciding seat sees it; cards are numbers 1-104 */
+typedef struct SixNimmtPluginState {
+    uint8_t row_cards[SIXNIMMT_PLUGIN_ROWS][SIXNIMMT_PLUGIN_ROW_LENGTH];
+    uint8_t row_length[SIXNIMMT_PLUGIN_ROWS];
+    uint8_t row_penalty[SIXNIMMT_PLUGIN_ROWS];   /* bull heads in the row */
+    uint8_t hand[SIXNIMMT_PLUGIN_MAX_HAND];      /* ascending */
+    uint8_t hand_size;
+    uint8_t seat;
+    uint8_t num_players;
+    uint8_t round_number;                        /* 1-10 */
+    /* Card each seat revealed last: the previous round's during
+       choose_card, this round's during choose_row_to_take; 0 before the
+       first reveal */
+    uint8_t played_cards[SIXNIMMT_PLUGIN_MAX_PLAYERS];
+    int16_t scores[SIXNIMMT_PLUGIN_MAX_PLAYERS];
+} SixNimmtPluginState;
+
+/* One agent. The loader calls create once per game seat, then initialize,
+   then the decisions, and destroy at the end; calls for one instance never
+   overlap, but different instances run on different threads at once. */
+typedef struct SixNimmtAgentPlugin {
+    uint32_t abi_version;   /* SIXNIMMT_PLUGIN_ABI_VERSION */
+    const char* name;       /* registered agent name */
+
+    void* (*create)(void);
+    void (*destroy)(void* agent);
+
+    /* New game: the seat's random seed (draw only from it so games
+       replay), its seat and the initial hand, ascending */
+    void (*initialize)(void* agent, uint64_t seed, int seat, int num_players,
+                       const uint8_t* hand, int hand_size);
+
+    /* Index into state->hand of the card to play */
+    int (*choose_card)(void* agent, const SixNimmtPluginState* state);
+
+    /* Row (0-3) to take; NULL takes the row with the fewest bull heads */
+    int (*choose_row_to_take)(void* agent, const SixNimmtPluginState* state);
+} SixNimmtAgentPlugin;
+
+#if defined(_WIN32)
+#define SIXNIMMT_PLUGIN_EXPORT __declspec(dllexport)
+#else
+#define SIXNIMMT_PLUGIN_EXPORT __attribute__((visibility("default")))
+#endif
+
+/* Entry point every plugin defines: its index-th agent, NULL past the last */
+typedef const SixNimmtAgentPlugin* (*SixNimmtPluginEntry)(int index);
+#define SIXNIMMT_PLUGIN_ENTRY_NAME "sixnimmt_agent_plugin"
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SIXNIMMT_AGENT_PLUGIN_H */
@@ -0,0 +1,46 @@
+#pragma once
+
+#include "game.h"
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace SixNimmt {
+
+// Process-wide table of agent factories, keyed by Player::getName().
+// Agents register themselves from their own translation unit with
+// SIXNIMMT_REGISTER_AGENT, so tournaments can build fresh instances by name
+// without knowing the concrete types.
+class AgentRegistry {
+public:
+    using Factory = std::function<std::unique_ptr<Player>()>;
+
+    static AgentRegistry& instance();
+
+    // Register (or replace) the factory for an agent name. Always returns
+    // true so it can initialize a static variable.
+    bool add(const std::string& name, Factory factory);
+
+    // New instance of the named agent, or nullptr if the name is unknown
+    std::unique_ptr<Player> create(const std::string& name) const;
+
+    bool contains(const std::string& name) const;
+
+    // All registered names in alphabetical order
+    std::vector<std::string> names() const;
+
+private:
+    mutable std::mutex mutex;
+    std::map<std::string, Factory> factories;
+};
+
+} // namespace SixNimmt
+
+// Register a default-constructible Player subclass under its getName().
+// Use at namespace scope in the agent's source file.
+#define SIXNIMMT_REGISTER_AGENT(Type)                                              \
+    inline const bool Type##Registered = ::SixNimmt::AgentRegistry::instance().add( \
+        Type().getName(), [] { return std::unique_ptr<::SixNimmt::Player>(new Type()); })
@@ -0,0 +1,87 @@
+#pragma once
+
+#include "game.h"
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace SixNimmt {
+
+// State of many independent games in struct-of-arrays form. Every array is
+// indexed by game (rows: [row][game], seats: [seat * stride + game]) so one
+// operation can be applied to a run of games with SIMD. Rows are reduced to
+// what the rules need: last card, length and penalty.
+struct BatchState {
+    int numGames = 0;
+    int numPlayers = 0;
+    int stride = 0;          // numGames rounded up to the SIMD width
+    int roundNumber = 1;     // Current round (1-10)
+
+    std::vector<uint64_t> seeds;                                  // [game]
+    std::array<std::vector<uint8_t>, NUM_ROWS> rowTail;           // [row][game]
+    std::array<std::vector<uint8_t>, NUM_ROWS> rowLength;         // [row][game]
+    std::array<std::vector<uint8_t>, NUM_ROWS> rowPenalty;        // [row][game]
+
+    // Hands as the two words of a CardSet (bit n set if card n is held)
+    std::vector<uint64_t> handLow;    // [seat * stride + game]
+    std::vector<uint64_t> handHigh;   // [seat * stride + game]
+    std::vector<uint16_t> scores;     // [seat * stride + game]
+
+    size_t at(int seat, int game) const { return static_cast<size_t>(seat) * stride + game; }
+};
+
+// A policy that decides for one seat in every game of a batch at once.
+// Kernels are the batch counterpart of a Player: for the same seeds a kernel
+// must make exactly the choices its Player makes in Game::playGame.
+class BatchPolicy {
+public:
+    virtual ~BatchPolicy() = default;
+
+    // Called once before the first round
+    virtual void initialize(const BatchState& /*batch*/, int /*seat*/) {}
+
+    // Write the number of the card `seat` plays in every game to cards[game].
+    // The card must be in the seat's hand.
+    virtual void chooseCards(const BatchState& batch, int seat, uint8_t* cards) = 0;
+
+    // Row (0-3) taken when `seat`'s card fits nowhere in `game`. The default
+    // matches Player::chooseRowToTake: lowest penalty, first row on ties.
+    virtual int chooseRowToTake(const BatchState& batch, int seat, int game);
+};
+
+// Kernel for a registered agent name, or nullptr if the agent has none
+std::unique_ptr<BatchPolicy> createBatchPolicy(const std::string& agentName);
+
+// Plays numGames games in lockstep. Game i is dealt exactly like
+// Game(players, seeds[i]), so results match the single-game engine.
+class BatchEngine {
+public:
+    // One policy per seat (2-10 seats); the engine takes ownership
+    BatchEngine(std::vector<std::unique_ptr<BatchPolicy>>&& policies, const std::vector<uint64_t>& seeds);
+
+    // Play all 10 rounds of every game
+    void playGames();
+
+    const BatchState& getState() const { return state; }
+
+    int getScore(int seat, int game) const { return state.scores[state.at(seat, game)]; }
+
+private:
+    std::vector<std::unique_ptr<BatchPolicy>> policies;
+    BatchState state;
+
+    // Per-round scratch, [k * stride + game]
+    std::vector<uint8_t> playedCards;    // card played by each seat
+    std::vector<uint8_t> sortedCards;    // k-th lowest card of the round
+    std::vector<uint8_t> sortedSeats;    // seat that played it
+    std::vector<int8_t> targetRows;      // row the card goes to
+    std::vector<uint8_t> forcedTakes;    // 0xFF where the row is taken regardless of length
+    std::vector<uint8_t> takenPenalty;   // penalty collected by placing the card
+
+    void dealGames();
+    void playRound();
+};
+
+} // namespace SixNimmt
@@ -0,0 +1,75 @@
+#pragma once
+
+#include "game.h"
+#include "endgame_solver.h"
+#include "knowledge.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace SixNimmt {
+
+// Plays the last rounds of a 2-player game with the exact endgame solver.
+// The opponent's hand is hidden (the 80 undealt cards never show), so each
+// move solves a number of determinizations, opponent hands drawn from the
+// unseen cards, and plays the card with the lowest total margin. Earlier
+// rounds, and games with more players, play the card with the lowest
+// immediate penalty.
+class EndgameSolverAgent : public Player {
+private:
+    int playerId;
+    int numPlayers;
+
+    int endgameRounds;   // solve once the hand is down to this many cards
+    int samples;         // determinizations per move
+
+    EndgameSolver solver;
+    uint64_t agentSeed = 0;
+    int movesMade = 0;
+    KnowledgeState knowledge;   // unseen cards, updated from the game events
+
+    long solvedMoves = 0;
+    double solveSeconds = 0.0;
+
+    int solve(const GameState& state, Rng& rng);
+
+    // Penalty the card would collect if it were the only one played
+    int lowestImmediatePenalty(const GameState& state);
+
+public:
+    explicit EndgameSolverAgent(int endgameRounds = 6, int samples = 8)
+        : endgameRounds(endgameRounds), samples(samples) {}
+
+    void seed(uint64_t seed) override {
+        agentSeed = seed;
+    }
+
+    void initialize(int playerId, int numPlayers, const std::vector<Card>& initialHand) override;
+
+    // Keep the knowledge tracker in step with the game
+    void onGameStart(const GameState& state) override { knowledge.onGameStart(state); }
+    void onCardsRevealed(const GameState& state) override { knowledge.onCardsRevealed(state); }
+    void onRowTaken(const GameState& state, int seat, int row, const Row& taken) override {
+        knowledge.onRowTaken(state, seat, row, taken);
+    }
+    void onRoundEnd(const GameState& state) override { knowledge.onRoundEnd(state); }
+
+    int chooseCard(const GameState& state) override;
+
+    std::string getName() const override {
+        return "EndgameSolverAgent";
+    }
+
+    std::unique_ptr<Player> clone() const override {
+        return std::make_unique<EndgameSolverAgent>(endgameRounds, samples);
+    }
+
+    // Search statistics over the agent's lifetime
+    long getNodes() const { return solver.getNodes(); }
+    long getSolvedMoves() const { return solvedMoves; }
+    double getNodesPerSecond() const { return solveSeconds > 0 ? solver.getNodes() / solveSeconds : 0.0; }
+    double getHitRate() const { return solver.getHitRate(); }
+    double getAverageSolveMicroseconds() const { return solvedMoves ? solveSeconds * 1e6 / solvedMoves : 0.0; }
+};
+
+} // namespace SixNimmt
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "simulator.h"
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace SixNimmt {
+
+// Exact search of the remaining rounds of a 2-player game in which both hands
+// are known (the caller determinizes the opponent's hand). Rounds are
+// simultaneous, so the search is maximin: the solving seat commits to a card
+// and the opponent answers knowing it, which makes every value an upper
+// bound on the penalty margin the seat can guarantee. Forced takes use the
+// lowest-penalty row, the Player default.
+//
+// Positions are cached in a Zobrist-hashed transposition table keyed by the
+// row tails, lengths and penalties and both hands, which are all the rules
+// look at, so the table stays valid across moves and determinizations.
+class EndgameSolver {
+public:
+    // Transposition table of 2^tableBits entries of 16 bytes, allocated on
+    // the first solve: 1 MB by default, per solver. Every EndgameSolverAgent
+    // owns one and tournaments clone an agent per table and worker, so the
+    // default stays small; a 6-round endgame searches about 40k nodes per
+    // move and hits as often with 2^16 entries as with 2^20.
+    explicit EndgameSolver(int tableBits = 16);
+
+    // Margin (seat's penalty minus the opponent's, over the rest of the game)
+    // of every card in seat's hand, indexed by hand rank
+    std::array<int, HAND_SIZE> solveMoves(const SimState& sim, int seat);
+
+    // Drop all cached positions
+    void clear();
+
+    // Search statistics since construction
+    long getNodes() const { return nodes; }
+    long getProbes() const { return probes; }
+    long getHits() const { return hits; }
+    double getHitRate() const { return probes ? static_cast<double>(hits) / probes : 0.0; }
+
+private:
+    struct Entry {
+        uint64_t key = 0;
+        int16_t value = 0;
+        uint8_t bound = 0;      // Exact, Lower or Upper; 0 = empty
+        uint8_t bestCard = 0;   // solving seat's card that produced value
+    };
+
+    // Compact position from the solving seat's point of view
+    struct Node {
+        GameState table;   // only the rows are used
+        CardSet own;
+        CardSet opponent;
+    };
+
+    int tableBits;
+    std::vector<Entry> table;
+    uint64_t mask = 0;
+    long nodes = 0;
+    long probes = 0;
+    long hits = 0;
+
+    uint64_t hash(const Node& node) const;
+    int search(const Node& node, int alpha, int beta);
+    int answer(const Node& node, const std::array<int8_t, DECK_SIZE + 1>& target, int card, int alpha, int beta);
+};
+
+} // namespace SixNimmt
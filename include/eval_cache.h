@@ -0,0 +1,106 @@
+#pragma once
+
+#include "game.h"
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace SixNimmt {
+
+// Canonical form of a position for caching evaluations. Rows are sorted by
+// tail and reduced to what the placement rules read (tail, length, penalty),
+// so positions that differ only in row order share an entry. The order can
+// still matter when a forced take picks between rows of equal penalty, which
+// the cache accepts as noise. context carries whatever else the value
+// depends on (the unseen cards, the agent's settings), so different agents
+// can share one cache.
+struct EvalKey {
+    uint64_t rows = 0;        // 4 x 16 bits: tail (7), length (3), penalty (6)
+    CardSet hand;
+    uint64_t context = 0;
+    uint8_t roundNumber = 0;
+    uint8_t numPlayers = 0;
+
+    bool operator==(const EvalKey& other) const {
+        return rows == other.rows && hand == other.hand && context == other.context &&
+               roundNumber == other.roundNumber && numPlayers == other.numPlayers;
+    }
+
+    uint64_t hash() const {
+        return deriveSeed(rows ^ (uint64_t(roundNumber) << 56) ^ (uint64_t(numPlayers) << 48), hand.low(),
+                          hand.high(), context);
+    }
+};
+
+EvalKey makeEvalKey(const GameState& state, const CardSet& hand, uint64_t context = 0);
+
+// Value of every card in the hand, indexed by hand rank
+using EvalValues = std::array<float, HAND_SIZE>;
+
+// Bounded evaluation cache shared by any number of threads. Keys hash to one
+// of numShards shards, each a fixed open-addressing table behind its own
+// mutex, so threads only contend when they hit the same shard. A key lives
+// in one of the PROBE_WINDOW slots after its home slot; when they are all
+// taken, CLOCK (second chance) picks the victim: a slot read since the hand
+// last passed it is spared once.
+class EvalCache {
+public:
+    static constexpr int PROBE_WINDOW = 8;
+
+    struct Stats {
+        long lookups = 0;
+        long hits = 0;
+        long stores = 0;
+        long evictions = 0;
+        size_t entries = 0;
+        size_t capacity = 0;
+
+        double hitRate() const { return lookups ? static_cast<double>(hits) / lookups : 0.0; }
+    };
+
+    // Memory for entries is rounded down to a power of two slots per shard
+    explicit EvalCache(size_t maxBytes = size_t(64) << 20, int numShards = 64);
+
+    EvalCache(const EvalCache&) = delete;
+    EvalCache& operator=(const EvalCache&) = delete;
+
+    // Copies the cached values into values; false on a miss
+    bool lookup(const EvalKey& key, EvalValues& values);
+
+    void store(const EvalKey& key, const EvalValues& values);
+
+    void clear();
+
+    // Counters summed over the shards since construction or clear()
+    Stats getStats() const;
+
+    size_t capacity() const { return shards.size() * shardSlots; }
+    size_t memoryBytes() const { return capacity() * sizeof(Slot); }
+
+private:
+    struct Slot {
+        EvalKey key;
+        EvalValues values{};
+        bool used = false;
+        bool referenced = false;
+    };
+
+    struct Shard {
+        mutable std::mutex mutex;
+        std::vector<Slot> slots;
+        size_t entries = 0;
+        unsigned clockHand = 0;   // where the next eviction sweep starts
+        long lookups = 0;
+        long hits = 0;
+        long stores = 0;
+        long evictions = 0;
+    };
+
+    std::vector<std::unique_ptr<Shard>> shards;
+    size_t shardSlots = 0;
+    int shardBits = 0;
+};
+
+} // namespace SixNimmt
@@ -1,26 +1,56 @@
 #pragma once
 
 #include <vector>
+#include <array>
+#include <cstdint>
+#include <cstddef>
+#include <iterator>
 #include <memory>
 #include <random>
 #include <iostream>
 #include <algorithm>
 #include <cassert>
+#include <chrono>
+#include "rng.h"
+#include "latency_histogram.h"
+#include "instrument.h"
 
 namespace SixNimmt {
 
+// Table size limits
+constexpr int NUM_ROWS = 4;
+constexpr int MAX_ROW_LENGTH = 5;   // placing a 6th card takes the row
+constexpr int MAX_PLAYERS = 10;
+constexpr int HAND_SIZE = 10;
+constexpr int DECK_SIZE = 104;
+
+// Bull heads of a card number according to the game rules
+constexpr int bullHeadsOf(int num) {
+    if (num == 55) return 7;
+    if (num % 11 == 0) return 5;
+    if (num % 10 == 0) return 3;
+    if (num % 5 == 0) return 2;
+    return 1;
+}
+
+// bullHeadsOf for every card number (index 0 unused), built at compile time
+inline constexpr std::array<uint8_t, DECK_SIZE + 1> BULL_HEADS = [] {
+    std::array<uint8_t, DECK_SIZE + 1> table{};
+    for (int number = 1; number <= DECK_SIZE; ++number) {
+        table[number] = static_cast<uint8_t>(bullHeadsOf(number));
+    }
+    return table;
+}();
+
 // Card representation: number (1-104) with bull heads (1-7)
 struct Card {
     int number;
     int bullHeads;
 
-    Card(int num) : number(num) {
-        // Calculate bull heads based on game rules
-        if (num == 55) bullHeads = 7;
-        else if (num % 11 == 0) bullHeads = 5;
-        else if (num % 10 == 0) bullHeads = 3;
-        else if (num % 5 == 0) bullHeads = 2;
-        else bullHeads = 1;
+    // Numbers outside 1-104 are a bug in the caller; release builds give
+    // them 0 bull heads (table slot 0) rather than read past the table
+    Card(int num) : number(num), bullHeads(BULL_HEADS[num >= 1 && num <= DECK_SIZE ? num : 0]) {
+        assert(num >= 1 && num <= DECK_SIZE && "Card numbers run from 1 to 104");
     }
 
     bool operator<(const Card& other) const {
@@ -28,16 +58,392 @@ struct Card {
     }
 };
 
+// Set of card numbers as a 128-bit mask: bit n is card n, so cards 1-63 live
+// in the low word and 64-104 in the high word. Membership, counting and
+// ordered queries are a few bit operations, and iteration visits cards in
+// ascending order.
+class CardSet {
+public:
+    class const_iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = Card;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = Card;
+
+        const_iterator(uint64_t low, uint64_t high) : low(low), high(high) {}
+        Card operator*() const { return Card(low ? __builtin_ctzll(low) : 64 + __builtin_ctzll(high)); }
+        const_iterator& operator++() {
+            if (low) low &= low - 1;
+            else high &= high - 1;
+            return *this;
+        }
+        bool operator!=(const const_iterator& other) const { return low != other.low || high != other.high; }
+        bool operator==(const const_iterator& other) const { return !(*this != other); }
+    private:
+        uint64_t low;
+        uint64_t high;
+    };
+
+    constexpr CardSet() = default;
+    constexpr CardSet(uint64_t low, uint64_t high) : lowBits(low), highBits(high) {}
+
+    // Implicit so agents can keep assigning their initial hand vector
+    CardSet(const std::vector<Card>& cards) {
+        for (const Card& card : cards) insert(card.number);
+    }
+
+    // All 104 cards
+    static constexpr CardSet fullDeck() { return CardSet(~uint64_t(1), (uint64_t(1) << (DECK_SIZE - 63)) - 1); }
+
+    // Cards numbered below `number`
+    static constexpr CardSet below(int number) {
+        return number <= 0 ? CardSet()
+             : number < 64 ? CardSet(((uint64_t(1) << number) - 1) & ~uint64_t(1), 0)
+             : number <= DECK_SIZE ? CardSet(~uint64_t(1), (uint64_t(1) << (number - 64)) - 1)
+             : fullDeck();
+    }
+
+    // Cards numbered in [first, last]
+    static constexpr CardSet range(int first, int last) {
+        return first > last ? CardSet() : below(last + 1) - below(first);
+    }
+
+    uint64_t low() const { return lowBits; }
+    uint64_t high() const { return highBits; }
+
+    constexpr bool contains(int number) const {
+        return number < 64 ? (lowBits >> number) & 1 : (highBits >> (number - 64)) & 1;
+    }
+    constexpr void insert(int number) {
+        if (number < 64) lowBits |= uint64_t(1) << number;
+        else highBits |= uint64_t(1) << (number - 64);
+    }
+    constexpr void erase(int number) {
+        if (number < 64) lowBits &= ~(uint64_t(1) << number);
+        else highBits &= ~(uint64_t(1) << (number - 64));
+    }
+
+    int size() const { return __builtin_popcountll(lowBits) + __builtin_popcountll(highBits); }
+    bool empty() const { return (lowBits | highBits) == 0; }
+
+    // Lowest and highest card number; the set must not be empty
+    int lowest() const { return lowBits ? __builtin_ctzll(lowBits) : 64 + __builtin_ctzll(highBits); }
+    int highest() const { return highBits ? 127 - __builtin_clzll(highBits) : 63 - __builtin_clzll(lowBits); }
+
+    // Number of cards in the set below `number`, i.e. its index if present
+    int rank(int number) const { return (*this & below(number)).size(); }
+
+    // Number of the index-th lowest card (0-based); index < size()
+    int select(int index) const {
+        uint64_t bits = lowBits;
+        int offset = 0;
+        int lowCount = __builtin_popcountll(lowBits);
+        if (index >= lowCount) {
+            index -= lowCount;
+            bits = highBits;
+            offset = 64;
+        }
+        for (int i = 0; i < index; ++i) bits &= bits - 1;
+        return offset + __builtin_ctzll(bits);
+    }
+
+    Card operator[](int index) const { return Card(select(index)); }
+
+    const_iterator begin() const { return const_iterator(lowBits, highBits); }
+    const_iterator end() const { return const_iterator(0, 0); }
+
+    std::vector<Card> toVector() const { return std::vector<Card>(begin(), end()); }
+
+    constexpr CardSet operator|(const CardSet& other) const { return CardSet(lowBits | other.lowBits, highBits | other.highBits); }
+    constexpr CardSet operator&(const CardSet& other) const { return CardSet(lowBits & other.lowBits, highBits & other.highBits); }
+    constexpr CardSet operator-(const CardSet& other) const { return CardSet(lowBits & ~other.lowBits, highBits & ~other.highBits); }
+    // Complement within the deck
+    constexpr CardSet operator~() const { return fullDeck() - *this; }
+    CardSet& operator|=(const CardSet& other) { return *this = *this | other; }
+    CardSet& operator&=(const CardSet& other) { return *this = *this & other; }
+    CardSet& operator-=(const CardSet& other) { return *this = *this - other; }
+    constexpr bool operator==(const CardSet& other) const { return lowBits == other.lowBits && highBits == other.highBits; }
+    constexpr bool operator!=(const CardSet& other) const { return !(*this == other); }
+
+private:
+    uint64_t lowBits = 0;
+    uint64_t highBits = 0;
+};
+
+// Cards worth exactly `bullHeads` penalty points
+constexpr CardSet cardsWithBullHeads(int bullHeads) {
+    CardSet set;
+    for (int number = 1; number <= DECK_SIZE; ++number) {
+        if (bullHeadsOf(number) == bullHeads) set.insert(number);
+    }
+    return set;
+}
+
+// cardsWithBullHeads for 0-7, precomputed
+inline constexpr std::array<CardSet, 8> BULL_HEAD_CLASSES = {
+    cardsWithBullHeads(0), cardsWithBullHeads(1), cardsWithBullHeads(2), cardsWithBullHeads(3),
+    cardsWithBullHeads(4), cardsWithBullHeads(5), cardsWithBullHeads(6), cardsWithBullHeads(7)};
+
+// One row on the table, stored inline as one-byte card numbers. The penalty
+// and the last card are cached so agents and the engine can read them
+// without walking the row.
+struct Row {
+    std::array<uint8_t, MAX_ROW_LENGTH> cards{};
+    uint8_t length = 0;
+    uint8_t bullHeads = 0;   // sum of bull heads of all cards in the row
+    uint8_t tail = 0;        // number of the last card
+
+    class const_iterator {
+    public:
+        explicit const_iterator(const uint8_t* pos) : pos(pos) {}
+        Card operator*() const { return Card(*pos); }
+        const_iterator& operator++() { ++pos; return *this; }
+        bool operator!=(const const_iterator& other) const { return pos != other.pos; }
+        bool operator==(const const_iterator& other) const { return pos == other.pos; }
+    private:
+        const uint8_t* pos;
+    };
+
+    int size() const { return length; }
+    bool empty() const { return length == 0; }
+    Card operator[](int index) const { return Card(cards[index]); }
+    Card front() const { return Card(cards[0]); }
+    Card back() const { return Card(tail); }
+    int penalty() const { return bullHeads; }
+    const_iterator begin() const { return const_iterator(cards.data()); }
+    const_iterator end() const { return const_iterator(cards.data() + length); }
+
+    // Append a card; the caller takes the row before it would overflow
+    void push(const Card& card) {
+        assert(length < MAX_ROW_LENGTH);
+        cards[length++] = static_cast<uint8_t>(card.number);
+        bullHeads += card.bullHeads;
+        tail = static_cast<uint8_t>(card.number);
+    }
+
+    // Replace the whole row with a single card
+    void reset(const Card& card) {
+        cards[0] = static_cast<uint8_t>(card.number);
+        length = 1;
+        bullHeads = static_cast<uint8_t>(card.bullHeads);
+        tail = static_cast<uint8_t>(card.number);
+    }
+};
+
+// Everything visible on the table. Fixed-size and trivially copyable, so the
+// engine keeps one instance and hands it to agents by const reference.
 struct GameState {
-    std::vector<std::vector<Card>> rows;  // 4 rows of cards on table
-    int roundNumber;                      // Current round (1-10)
-    std::vector<int> scores;              // Current scores for all players
+    std::array<Row, NUM_ROWS> rows;       // 4 rows of cards on table
+    int roundNumber = 1;                  // Current round (1-10)
+    int numPlayers = 0;                   // Number of valid entries in scores
+    std::array<int, MAX_PLAYERS> scores{}; // Current scores for all players
+
+    // Card number each seat revealed in the latest reveal: the previous
+    // round's cards during chooseCard, this round's during chooseRowToTake
+    // and the observer calls; 0 before the first reveal
+    std::array<uint8_t, MAX_PLAYERS> playedCards{};
+};
+
+// Row a card goes to: the one whose last card is the closest below it, or -1
+// if the card is lower than every row. Branchless over the four tails.
+inline int findBestRow(const GameState& state, int number) {
+    // Key = distance * 4 + row, with 255 as distance for rows that don't fit;
+    // the minimum key picks the closest row, ties are impossible
+    int best = 255 * 4;
+    for (int i = 0; i < NUM_ROWS; ++i) {
+        int difference = number - state.rows[i].tail;
+        int key = (difference > 0 ? difference : 255) * 4 + i;
+        best = key < best ? key : best;
+    }
+    return best >= 255 * 4 ? -1 : best & 3;
+}
+
+// findBestRow for every card number, kept up to date as row tails change so
+// that a lookup is one load. A tail only moves the targets between it and
+// the next higher tail, so an update rewrites that range. It pays off where
+// many cards are looked up per table change, such as agents scoring whole
+// hands or unseen sets; the engine places one card per change, and there
+// the branchless findBestRow is cheaper than the update.
+class PlacementTable {
+public:
+    PlacementTable() { tailRow.fill(-1); }
+    explicit PlacementTable(const GameState& state) : PlacementTable() { rebuild(state); }
+
+    void rebuild(const GameState& state) {
+        tailRow.fill(-1);
+        for (int row = 0; row < NUM_ROWS; ++row) {
+            tails[row] = state.rows[row].tail;
+            tailRow[tails[row]] = static_cast<int8_t>(row);
+        }
+        refill(0, DECK_SIZE);
+    }
+
+    // Row card number goes to, or -1 if it is lower than every tail
+    int targetRow(int number) const { return target[number]; }
+
+    // row's last card changed from oldTail to newTail
+    void moveTail(int row, int oldTail, int newTail) {
+        tailRow[oldTail] = -1;
+        tailRow[newTail] = static_cast<int8_t>(row);
+        tails[row] = newTail;
+        int high = std::max(oldTail, newTail) + 1;
+        while (high <= DECK_SIZE && tailRow[high] == -1) ++high;
+        refill(std::min(oldTail, newTail), std::min(high, DECK_SIZE));
+    }
+
+private:
+    std::array<int8_t, DECK_SIZE + 1> target{};    // by card number
+    std::array<int8_t, DECK_SIZE + 1> tailRow{};   // row ending in a number, or -1
+    std::array<int, NUM_ROWS> tails{};
+
+    // Recompute targets of (low, high]: each card goes to the row of the
+    // highest tail below it
+    void refill(int low, int high) {
+        int current = -1;
+        for (int row = 0; row < NUM_ROWS; ++row) {
+            if (tails[row] <= low && (current == -1 || tails[row] > tails[current])) current = row;
+        }
+        for (int number = low + 1; number <= high; ++number) {
+            target[number] = static_cast<int8_t>(current);
+            if (tailRow[number] != -1) current = tailRow[number];
+        }
+    }
+};
+
+// Where every card of a set would go on the current table
+struct RowPlacement {
+    std::array<CardSet, NUM_ROWS> byRow;   // cards that would be placed on each row
+    CardSet forcedTake;                    // cards below every row
+};
+
+// Splits a whole set of cards (a hand, the unseen cards, ...) by target row
+// with one mask operation per row: a row receives the cards between its
+// tail and the next higher tail.
+inline RowPlacement placeCards(const GameState& state, const CardSet& cards) {
+    RowPlacement placement;
+    int lowestTail = DECK_SIZE + 1;
+    for (int i = 0; i < NUM_ROWS; ++i) {
+        int tail = state.rows[i].tail;
+        int nextTail = DECK_SIZE + 1;
+        for (int j = 0; j < NUM_ROWS; ++j) {
+            int other = state.rows[j].tail;
+            if (other > tail && other < nextTail) nextTail = other;
+        }
+        placement.byRow[i] = cards & CardSet::range(tail + 1, nextTail - 1);
+        if (tail < lowestTail) lowestTail = tail;
+    }
+    placement.forcedTake = cards & CardSet::below(lowestTail);
+    return placement;
+}
+
+// Row with the fewest bull heads, the first of equals: the row a seat takes
+// by default when its card is below every row
+inline int lowestPenaltyRow(const GameState& state) {
+    int best = 0;
+    for (int i = 1; i < NUM_ROWS; ++i) {
+        if (state.rows[i].bullHeads < state.rows[best].bullHeads) best = i;
+    }
+    return best;
+}
+
+// Card numbers played by each seat in one round
+using RoundCards = std::array<uint8_t, MAX_PLAYERS>;
+
+// The cards of one round in placement order, without sorting: the cards are
+// distinct, so as a CardSet they iterate in ascending order, and a table
+// indexed by card number gives back the seat. Fixed size, no heap.
+class RevealBuffer {
+public:
+    void add(int seat, int number) {
+        cards.insert(number);
+        owners[number] = static_cast<uint8_t>(seat);
+    }
+
+    const CardSet& getCards() const { return cards; }
+    int ownerOf(int number) const { return owners[number]; }
+
+    // visit(card, seat) for every card, lowest first
+    template <typename Visit>
+    void forEach(Visit visit) const {
+        for (Card card : cards) visit(card, static_cast<int>(owners[card.number]));
+    }
+
+private:
+    CardSet cards;
+    std::array<uint8_t, DECK_SIZE + 1> owners;   // valid for the cards in the set only
+};
+
+// Resolves one round on table the way Game does, with no agents, hands or
+// observers involved: the cards (one per seat) become table.playedCards and
+// are placed lowest first, penalties go to table.scores, and the round
+// number advances. A seat whose card is below every row takes row
+// chooseRow(table, seat), called on the table as it is at that point.
+// Search agents resolve hypothetical rounds with it on a copy of the table.
+template <typename ChooseRow>
+void resolveRound(GameState& table, const RoundCards& cards, ChooseRow chooseRow) {
+    RevealBuffer reveal;
+    for (int seat = 0; seat < table.numPlayers; ++seat) {
+        reveal.add(seat, cards[seat]);
+        table.playedCards[seat] = cards[seat];
+    }
+
+    reveal.forEach([&](Card card, int seat) {
+        int row = findBestRow(table, card.number);
+        if (row == -1) {
+            row = chooseRow(static_cast<const GameState&>(table), seat);
+            table.scores[seat] += table.rows[row].bullHeads;
+            table.rows[row].reset(card);
+        } else if (table.rows[row].length == MAX_ROW_LENGTH) {
+            table.scores[seat] += table.rows[row].bullHeads;
+            table.rows[row].reset(card);
+        } else {
+            table.rows[row].push(card);
+        }
+    });
+
+    table.roundNumber++;
+}
+
+// Forced takes take the lowest-penalty row (the Player default)
+inline void resolveRound(GameState& table, const RoundCards& cards) {
+    resolveRound(table, cards, [](const GameState& state, int) { return lowestPenaltyRow(state); });
+}
+
+// The table after the round, leaving state untouched
+inline GameState resolvedRound(const GameState& state, const RoundCards& cards) {
+    GameState table = state;
+    resolveRound(table, cards);
+    return table;
+}
+
+// Receives the events of a game as they happen, so trackers (see
+// knowledge.h) can update incrementally instead of rescanning the table.
+// Every call gets the game's current state; all default to doing nothing.
+class GameObserver {
+public:
+    virtual ~GameObserver() = default;
+
+    // Hands are dealt and the four rows are on the table
+    virtual void onGameStart(const GameState& /*state*/) {}
+
+    // Everyone has chosen; state.playedCards holds the cards, none placed yet
+    virtual void onCardsRevealed(const GameState& /*state*/) {}
+
+    // seat collected taken (the row as it was) and row now holds only the
+    // card that took it; state.scores already includes the penalty
+    virtual void onRowTaken(const GameState& /*state*/, int /*seat*/, int /*row*/, const Row& /*taken*/) {}
+
+    // Every card of the round has been placed
+    virtual void onRoundEnd(const GameState& /*state*/) {}
 };
 
-// Abstract base class for all player agents
-class Player {
+// Abstract base class for all player agents. The Game also notifies its
+// players as observers, after initialize() and before each decision.
+class Player : public GameObserver {
 protected:
-    std::vector<Card> hand;
+    CardSet hand;   // sorted, so index i is the i-th lowest card
     int playerId;
     int numPlayers;
 
@@ -127,6 +533,10 @@ protected:
         return bestRow;
     }
 
+    int calculateRowPenalty(const Row& row) {
+        return row.penalty();
+    }
+
     int calculateRowPenalty(const std::vector<Card>& row) {
         int penalty = 0;
         for (const Card& card : row) {
@@ -138,6 +548,11 @@ protected:
 public:
     virtual ~Player() = default;
 
+    // Called by the game before initialize() with a seed for this seat's
+    // random stream. Agents that use randomness must draw only from a
+    // generator seeded here so games replay exactly.
+    virtual void seed(uint64_t /*seed*/) {}
+
     // Called at the start of each game - player receives their hand
     virtual void initialize(int playerId, int numPlayers, const std::vector<Card>& initialHand) = 0;
 
@@ -152,26 +567,57 @@ public:
         return choseLowestPenaltyRowToTake(state);
     }
 
+    // A decision over the game's move time limit (Game::setMoveTimeLimit)
+    // was replaced: choice, the default move, was played instead of the
+    // returned one. It is a hand index for chooseCard, still valid at this
+    // point, or a row for chooseRowToTake. Agents that track their own moves
+    // can resync here or from state.playedCards in onCardsRevealed.
+    virtual void onMoveReplaced(const GameState& /*state*/, int /*choice*/) {}
+
     virtual std::string getName() const = 0;
 
-    const std::vector<Card>& getHand() const { return hand; }
+    // Fresh, uninitialized instance of the same agent for another game.
+    // The default looks getName() up in the AgentRegistry and returns
+    // nullptr for unregistered agents; override it to carry over settings.
+    virtual std::unique_ptr<Player> clone() const;
+
+    const CardSet& getHand() const { return hand; }
 
     void removeCard(int index) {
-        hand.erase(hand.begin() + index);
+        hand.erase(hand.select(index));
+    }
+};
+
+class GameRecorder;
+
+// Wall-clock cost of one agent's decisions; see Game::setDecisionStats
+struct DecisionStats {
+    LatencyHistogram chooseCard;
+    LatencyHistogram chooseRowToTake;
+    long timeouts = 0;   // decisions over the time limit, replaced by the default move
+
+    void add(const DecisionStats& other) {
+        chooseCard.add(other.chooseCard);
+        chooseRowToTake.add(other.chooseRowToTake);
+        timeouts += other.timeouts;
     }
 };
 
+// 64 bits from std::random_device, for runs that do not ask for a seed
+uint64_t randomSeed();
+
 // Main game engine
 class Game {
 private:
     std::vector<std::unique_ptr<Player>> players;
     std::vector<Card> deck;
-    std::vector<std::vector<Card>> rows;
-    std::vector<int> scores;
-    int currentRound;
-    std::mt19937 rng;
+    GameState state;   // rows, scores and round number
+    uint64_t gameSeed;
+    GameRecorder* recorder = nullptr;
+    std::vector<GameObserver*> observers;   // besides the players
+    std::array<DecisionStats*, MAX_PLAYERS> decisionStats{};
+    std::chrono::nanoseconds moveTimeLimit{0};
 
-    void initializeDeck();
     void dealCards();
     void initializeRows();
     void playRound();
@@ -179,17 +625,75 @@ private:
     int findBestRow(const Card& card) const;
     void takeRow(int playerId, int rowIndex);
     void printGameState() const;
+    int lowestPenaltyRow() const;
+
+    // Calls event(observer) for every player, then every added observer
+    template <typename Event>
+    void notify(Event event);
+
+    template <typename Decide>
+    int timeDecision(int playerId, LatencyHistogram DecisionStats::*histogram, int fallback, Decide decide);
+
+    // Benchmark access to processCard and the undealt deck
+    friend class GameProbe;
 
 public:
+    // Deck order and every agent's random stream are derived from seed,
+    // so the same seed and agents always produce the same game
+    Game(std::vector<std::unique_ptr<Player>>&& players, uint64_t seed);
+
+    // Seeded from std::random_device
     Game(std::vector<std::unique_ptr<Player>>&& players);
 
+    // Plays a given deal: seat i gets deck[10i .. 10i + 9], the next four
+    // cards start the rows. deck must hold every card once, or this throws
+    // std::invalid_argument. Agents are still seeded from seed, so
+    // Game(players, shuffledDeck(seed), seed) is the same game as
+    // Game(players, seed).
+    Game(std::vector<std::unique_ptr<Player>>&& players, std::vector<Card> deck, uint64_t seed);
+
+    // The deck order Game(players, seed) deals from
+    static std::vector<Card> shuffledDeck(uint64_t seed);
+
+    uint64_t getSeed() const { return gameSeed; }
+
+    // Log this game to recorder (see game_log.h); call before playGame
+    void setRecorder(GameRecorder* recorder) { this->recorder = recorder; }
+
+    // Notify observer of every event of this game (players are notified
+    // anyway); call before playGame. The observer must outlive the game.
+    void addObserver(GameObserver* observer) { observers.push_back(observer); }
+
+    // Time seat's chooseCard and chooseRowToTake calls on the steady clock
+    // into stats, which the caller owns; call before playGame
+    void setDecisionStats(int seat, DecisionStats* stats) { decisionStats[seat] = stats; }
+
+    // Per-decision limit (zero, the default, means none), enforced after the
+    // fact: a call that ran longer has its result replaced by the default
+    // move, the lowest card or the lowest-penalty row, the player is told
+    // through onMoveReplaced and the seat's timeouts count it. It is not a
+    // budget. Agents share the engine's thread and cannot be interrupted, so
+    // a slow or hung call still holds up the game, and a limit makes results
+    // depend on machine speed.
+    void setMoveTimeLimit(std::chrono::nanoseconds limit) { moveTimeLimit = limit; }
+
     // Run a complete game and return final scores
     std::vector<int> playGame(bool verbose = false);
 
-    GameState getGameState() const;
+    // Hand the players back once the game is over so they can be reused;
+    // initialize() resets them for the next game
+    std::vector<std::unique_ptr<Player>> releasePlayers() { return std::move(players); }
+
+    // Current table state; stays valid (and is updated in place) for the lifetime of the game
+    const GameState& getGameState() const {
+        SIXNIMMT_COUNT(GetGameState);
+        return state;
+    }
 
     // Public access to scores for debugging
-    const std::vector<int>& getScores() const { return scores; }
+    std::vector<int> getScores() const {
+        return std::vector<int>(state.scores.begin(), state.scores.begin() + state.numPlayers);
+    }
 };
 
 } // namespace SixNimmt
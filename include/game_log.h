@@ -0,0 +1,131 @@
+#pragma once
+
+#include "game.h"
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace SixNimmt {
+
+// Binary game log. A file is an 8-byte header ("6NGL", uint16 version,
+// uint16 reserved) followed by variable-length records, one per game:
+//
+//   uint16  record size in bytes, including this field
+//   uint64  game seed
+//   uint8   number of players P
+//   uint8   number of forced row takes T
+//   uint8   starting card of each row [4]
+//   uint8   dealt hands, ascending per seat [P * 10]
+//   uint4   hand index played, per round and seat [10 * P], two per byte
+//   uint2   row taken by each forced take, in resolution order [T], four per byte
+//   uint8   final score per seat [P]
+//
+// Multi-byte fields are little-endian. A 2-player game takes about 50 bytes.
+constexpr uint32_t GAME_LOG_MAGIC = 0x4c474e36;   // "6NGL"
+constexpr uint16_t GAME_LOG_VERSION = 1;
+constexpr size_t GAME_LOG_HEADER_SIZE = 8;
+
+// Appends finished games to a log file through a large write buffer. Game
+// calls the hooks while it plays; nothing is written until a game ends. A
+// recorder is not thread-safe: use one per thread (and file).
+class GameRecorder {
+public:
+    // Opens (or creates) path for appending
+    explicit GameRecorder(const std::string& path, size_t bufferSize = 1 << 20);
+    ~GameRecorder();
+
+    GameRecorder(const GameRecorder&) = delete;
+    GameRecorder& operator=(const GameRecorder&) = delete;
+
+    bool isOpen() const { return file != nullptr; }
+
+    // Hooks called by Game
+    void beginGame(uint64_t seed, const GameState& state, const std::array<CardSet, MAX_PLAYERS>& hands);
+    void recordChoice(int seat, int cardIndex);
+    void recordForcedTake(int row);
+    void endGame(const GameState& state);
+
+    // Write everything buffered so far to the file
+    void flush();
+
+    long getGamesRecorded() const { return gamesRecorded; }
+
+private:
+    std::FILE* file = nullptr;
+    std::vector<uint8_t> buffer;
+    size_t bufferSize;
+    long gamesRecorded = 0;
+
+    // Game in progress
+    uint64_t seed = 0;
+    int numPlayers = 0;
+    std::array<uint8_t, NUM_ROWS> rowCards{};
+    std::array<uint8_t, MAX_PLAYERS * HAND_SIZE> dealtCards{};
+    std::array<uint8_t, MAX_PLAYERS * HAND_SIZE> choices{};
+    std::array<uint8_t, MAX_PLAYERS * HAND_SIZE> forcedTakes{};
+    int numChoices = 0;
+    int numForcedTakes = 0;
+};
+
+// Read-only view of one record inside a mapped log
+class GameRecordView {
+public:
+    explicit GameRecordView(const uint8_t* data) : data(data) {}
+
+    size_t size() const { return data[0] | (data[1] << 8); }
+    uint64_t seed() const;
+    int numPlayers() const { return data[10]; }
+    int numForcedTakes() const { return data[11]; }
+    int rowCard(int row) const { return data[12 + row]; }
+    CardSet hand(int seat) const;
+    int choice(int round, int seat) const;   // round is 0-based
+    int forcedTake(int index) const;
+    int score(int seat) const;
+
+private:
+    const uint8_t* data;
+
+    size_t choicesOffset() const { return 16 + numPlayers() * HAND_SIZE; }
+    size_t takesOffset() const { return choicesOffset() + (numPlayers() * HAND_SIZE + 1) / 2; }
+    size_t scoresOffset() const { return takesOffset() + (numForcedTakes() + 3) / 4; }
+};
+
+// Memory-maps a log file and iterates its records without copying them
+class GameLogReader {
+public:
+    class const_iterator {
+    public:
+        explicit const_iterator(const uint8_t* pos) : pos(pos) {}
+        GameRecordView operator*() const { return GameRecordView(pos); }
+        const_iterator& operator++() { pos += GameRecordView(pos).size(); return *this; }
+        bool operator!=(const const_iterator& other) const { return pos != other.pos; }
+    private:
+        const uint8_t* pos;
+    };
+
+    explicit GameLogReader(const std::string& path);
+    ~GameLogReader();
+
+    GameLogReader(const GameLogReader&) = delete;
+    GameLogReader& operator=(const GameLogReader&) = delete;
+
+    // False if the file could not be mapped or has a bad header
+    bool isOpen() const { return data != nullptr; }
+
+    const_iterator begin() const { return const_iterator(data ? data + GAME_LOG_HEADER_SIZE : nullptr); }
+    const_iterator end() const { return const_iterator(data ? data + validSize : nullptr); }
+
+private:
+    const uint8_t* data = nullptr;
+    size_t mappedSize = 0;
+    size_t validSize = 0;   // end of the last complete record
+};
+
+// Replays a recorded game through Game with the recorded deal, seed and
+// choices, and checks that the final scores come out the same. The deal is
+// rebuilt from the recorded hands and rows, so games dealt from a given deck
+// replay as well as seeded ones.
+bool replayMatchesRecord(const GameRecordView& record);
+
+} // namespace SixNimmt
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+
+// Hot-path instrumentation, switched at compile time with the
+// SIXNIMMT_INSTRUMENT CMake option. Enabled, SIXNIMMT_PROBE(Name) times the
+// rest of the enclosing scope and SIXNIMMT_COUNT(Name) counts a call; every
+// thread writes its own counters, so nothing is locked or shared on the hot
+// path. Disabled, both macros expand to nothing and the engine compiles
+// exactly as without them.
+
+#ifdef SIXNIMMT_INSTRUMENT
+#define SIXNIMMT_PROBE_CONCAT2(a, b) a##b
+#define SIXNIMMT_PROBE_CONCAT(a, b) SIXNIMMT_PROBE_CONCAT2(a, b)
+#define SIXNIMMT_PROBE(name) \
+    ::SixNimmt::Instrument::ScopedProbe SIXNIMMT_PROBE_CONCAT(sixnimmtProbe, __LINE__)(::SixNimmt::Instrument::Probe::name)
+#define SIXNIMMT_COUNT(name) ::SixNimmt::Instrument::count(::SixNimmt::Instrument::Probe::name)
+#else
+#define SIXNIMMT_PROBE(name) ((void)0)
+#define SIXNIMMT_COUNT(name) ((void)0)
+#endif
+
+namespace SixNimmt {
+namespace Instrument {
+
+#ifdef SIXNIMMT_INSTRUMENT
+constexpr bool ENABLED = true;
+#else
+constexpr bool ENABLED = false;
+#endif
+
+// Instrumented points of the engine
+enum class Probe : uint8_t {
+    PlayRound,
+    ProcessCard,
+    TakeRow,
+    GetGameState,      // counted only: it just returns a reference
+    ChooseCard,        // agent callbacks
+    ChooseRowToTake,
+    Count
+};
+
+constexpr int NUM_PROBES = static_cast<int>(Probe::Count);
+
+const char* probeName(Probe probe);
+
+// Totals of one probe over all threads. Times are inclusive: playRound
+// contains its processCard calls, which contain takeRow.
+struct ProbeTotals {
+    uint64_t calls = 0;
+    uint64_t nanoseconds = 0;
+};
+
+// Counters of one thread. Only the owning thread writes them; the atomics
+// (relaxed loads and stores, no read-modify-write) only make it safe for
+// another thread to read them while they change.
+struct ThreadCounters {
+    std::array<std::atomic<uint64_t>, NUM_PROBES> calls{};
+    std::array<std::atomic<uint64_t>, NUM_PROBES> nanoseconds{};
+    int threadIndex = 0;
+};
+
+// Creates the calling thread's counters on first use
+ThreadCounters& registerThread();
+
+inline ThreadCounters& threadCounters() {
+    thread_local ThreadCounters& counters = registerThread();
+    return counters;
+}
+
+// Appends a complete event to this thread's trace buffer while tracing
+void recordEvent(Probe probe, std::chrono::steady_clock::time_point start, std::chrono::steady_clock::duration elapsed);
+
+extern std::atomic<bool> tracing;
+
+inline void count(Probe probe) {
+    std::atomic<uint64_t>& calls = threadCounters().calls[static_cast<int>(probe)];
+    calls.store(calls.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
+class ScopedProbe {
+public:
+    explicit ScopedProbe(Probe probe) : probe(probe), start(std::chrono::steady_clock::now()) {}
+
+    ~ScopedProbe() {
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        ThreadCounters& counters = threadCounters();
+        int index = static_cast<int>(probe);
+        uint64_t nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+        counters.calls[index].store(counters.calls[index].load(std::memory_order_relaxed) + 1,
+                                    std::memory_order_relaxed);
+        counters.nanoseconds[index].store(counters.nanoseconds[index].load(std::memory_order_relaxed) + nanoseconds,
+                                          std::memory_order_relaxed);
+        if (tracing.load(std::memory_order_relaxed)) recordEvent(probe, start, elapsed);
+    }
+
+    ScopedProbe(const ScopedProbe&) = delete;
+    ScopedProbe& operator=(const ScopedProbe&) = delete;
+
+private:
+    Probe probe;
+    std::chrono::steady_clock::time_point start;
+};
+
+// Sums of every thread's counters, including threads that have exited
+std::array<ProbeTotals, NUM_PROBES> totals();
+
+// Zero all counters and drop recorded trace events
+void reset();
+
+// Record up to maxEventsPerThread timed events per thread from now on, for
+// writeChromeTrace; events past the cap are dropped. Write the trace after
+// stopTrace, once the instrumented threads are idle.
+void startTrace(size_t maxEventsPerThread = 1 << 20);
+void stopTrace();
+
+// Calls, total and mean time per probe
+void writeSummary(std::ostream& out);
+
+// Recorded events in the Chrome trace event format (chrome://tracing,
+// Perfetto): one complete ("X") event per probe scope, one track per thread
+void writeChromeTrace(std::ostream& out);
+
+} // namespace Instrument
+} // namespace SixNimmt
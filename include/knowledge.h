@@ -0,0 +1,79 @@
+#pragma once
+
+#include "game.h"
+#include <array>
+
+namespace SixNimmt {
+
+// What one seat knows about a game, kept up to date from the Game's observer
+// events so that agents query it in O(1) instead of rescanning the rows and
+// their own history on every decision. An agent owns one, calls begin() from
+// initialize() and forwards the GameObserver calls to it.
+//
+// The only hidden information is who holds the unseen cards: every reveal is
+// public, so all opponents share the same candidate set, and what tells them
+// apart is what each has played. The risk table is recomputed once per round
+// (onGameStart, onRoundEnd), between the decisions that read it.
+class KnowledgeState : public GameObserver {
+public:
+    void begin(int seat, int numPlayers, const CardSet& hand);
+
+    void onGameStart(const GameState& state) override;
+    void onCardsRevealed(const GameState& state) override;
+    void onRowTaken(const GameState& state, int seat, int row, const Row& taken) override;
+    void onRoundEnd(const GameState& state) override;
+
+    int getSeat() const { return seat; }
+    const CardSet& getHand() const { return hand; }
+
+    // Cards dealt to an opponent or left undealt, i.e. neither in our hand
+    // nor ever shown on the table
+    const CardSet& getUnseen() const { return unseen; }
+
+    // Cards a seat may still hold: our hand for our own seat, the unseen
+    // cards for an opponent
+    const CardSet& possibleCards(int seat) const { return seat == this->seat ? hand : unseen; }
+
+    // Cards a seat is known not to hold
+    CardSet knownNotHeld(int seat) const { return ~possibleCards(seat); }
+
+    // Cards a seat has revealed so far, and rows it has collected
+    const CardSet& getPlayedBy(int seat) const { return playedBy[seat]; }
+    int getRowsTaken(int seat) const { return rowsTaken[seat]; }
+
+    // Cards the row accepts before the next one becomes its 6th
+    int roomLeft(int row) const { return MAX_ROW_LENGTH - rows[row].size(); }
+
+    // Row a card would go to on the current table, -1 if it forces a take
+    int targetRow(int card) const { return placement.targetRow(card); }
+
+    // Unseen cards that would go to a row this round, and those that force
+    // a take
+    int unseenOnRow(int row) const { return unseenPerRow[row]; }
+    int unseenForcedTakes() const { return unseenForced; }
+
+    // Estimated chance that playing card this round collects a row: 1 for a
+    // forced take, otherwise the chance that exactly enough opponents play
+    // cards between the row's tail and card to make it a 6th. Each unseen
+    // card counts as played with probability opponents / unseen cards.
+    double takeRisk(int card) const { return risk[card]; }
+
+private:
+    int seat = 0;
+    int numPlayers = 0;
+    CardSet hand;
+    CardSet unseen;
+    std::array<CardSet, MAX_PLAYERS> playedBy;
+    std::array<int, MAX_PLAYERS> rowsTaken{};
+
+    std::array<Row, NUM_ROWS> rows;
+    PlacementTable placement;
+    std::array<int, NUM_ROWS> unseenPerRow{};
+    int unseenForced = 0;
+    std::array<double, DECK_SIZE + 1> risk{};
+
+    void see(const Row& row);
+    void rebuildTables(const GameState& state);
+};
+
+} // namespace SixNimmt
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+
+namespace SixNimmt {
+
+// Log-linear histogram of durations in nanoseconds: exact below 16 ns, then
+// 8 buckets per power of two (at most 12.5% relative error) up to ~2^40 ns.
+// Fixed size and mergeable, so workers can keep one each and sum them.
+class LatencyHistogram {
+public:
+    static constexpr int NUM_BUCKETS = 16 + 37 * 8;
+
+    void add(uint64_t nanoseconds) {
+        counts[bucketOf(nanoseconds)]++;
+        total++;
+        maximum = std::max(maximum, nanoseconds);
+    }
+
+    void add(const LatencyHistogram& other) {
+        for (int i = 0; i < NUM_BUCKETS; ++i) counts[i] += other.counts[i];
+        total += other.total;
+        maximum = std::max(maximum, other.maximum);
+    }
+
+    uint64_t count() const { return total; }
+    uint64_t max() const { return maximum; }
+
+    // Upper edge of the bucket holding the p-th percentile (0-100), capped
+    // at the largest value seen
+    uint64_t percentile(double p) const {
+        if (total == 0) return 0;
+        uint64_t rank = static_cast<uint64_t>(p / 100.0 * (total - 1)) + 1;
+        uint64_t seen = 0;
+        for (int i = 0; i < NUM_BUCKETS; ++i) {
+            seen += counts[i];
+            if (seen >= rank) return std::min(upperEdge(i), maximum);
+        }
+        return maximum;
+    }
+
+private:
+    std::array<uint32_t, NUM_BUCKETS> counts{};
+    uint64_t total = 0;
+    uint64_t maximum = 0;
+
+    static int bucketOf(uint64_t value) {
+        if (value < 16) return static_cast<int>(value);
+        int exponent = 63 - __builtin_clzll(value);   // >= 4
+        int bucket = 16 + (exponent - 4) * 8 + static_cast<int>((value >> (exponent - 3)) & 7);
+        return std::min(bucket, NUM_BUCKETS - 1);
+    }
+
+    static uint64_t upperEdge(int bucket) {
+        if (bucket < 16) return bucket;
+        int exponent = (bucket - 16) / 8 + 4;
+        uint64_t step = uint64_t(1) << (exponent - 3);
+        return (uint64_t(8 + (bucket - 16) % 8) << (exponent - 3)) + step - 1;
+    }
+};
+
+} // namespace SixNimmt
@@ -0,0 +1,82 @@
+#pragma once
+
+#include "game.h"
+#include "eval_cache.h"
+#include "knowledge.h"
+#include "thread_pool.h"
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace SixNimmt {
+
+// Determinized Monte Carlo search. For every move it samples the opponents'
+// hidden hands from the cards it has not seen, plays the round with each
+// candidate card and finishes the game with random rollouts. The card with
+// the lowest average penalty margin (own points minus the opponents' mean)
+// is played. Playouts run on a thread pool within a playout and/or time
+// budget. With an EvalCache the estimates are shared between instances (and
+// games): a position seen before with the same unseen cards is not searched
+// again.
+class MonteCarloAgent : public Player {
+private:
+    int playerId;
+    int numPlayers;
+
+    int playoutsPerMove;
+    std::chrono::microseconds timeBudget;   // 0 = playout budget only
+    int numThreads;
+    std::shared_ptr<EvalCache> cache;
+
+    std::unique_ptr<ThreadPool> pool;
+    uint64_t agentSeed = 0;
+    int movesMade = 0;
+    KnowledgeState knowledge;   // unseen cards, updated from the game events
+
+    long totalPlayouts = 0;
+    double totalSeconds = 0.0;
+
+    // One determinized playout with `card` played now; returns the final
+    // penalty margin: our points minus the opponents' average, scaled by
+    // the number of opponents to stay integral
+    int playout(const GameState& state, const CardSet& unseen, int card, Rng& rng) const;
+
+public:
+    // With a time budget the result depends on machine speed; with a
+    // playout budget only it is reproducible for any thread count
+    explicit MonteCarloAgent(int playoutsPerMove = 1000, std::chrono::microseconds timeBudget = std::chrono::microseconds(0),
+                             int numThreads = 1, std::shared_ptr<EvalCache> cache = nullptr)
+        : playoutsPerMove(playoutsPerMove), timeBudget(timeBudget), numThreads(numThreads), cache(std::move(cache)) {}
+
+    void seed(uint64_t seed) override {
+        agentSeed = seed;
+    }
+
+    void initialize(int playerId, int numPlayers, const std::vector<Card>& initialHand) override;
+
+    // Keep the knowledge tracker in step with the game
+    void onGameStart(const GameState& state) override { knowledge.onGameStart(state); }
+    void onCardsRevealed(const GameState& state) override { knowledge.onCardsRevealed(state); }
+    void onRowTaken(const GameState& state, int seat, int row, const Row& taken) override {
+        knowledge.onRowTaken(state, seat, row, taken);
+    }
+    void onRoundEnd(const GameState& state) override { knowledge.onRoundEnd(state); }
+
+    int chooseCard(const GameState& state) override;
+
+    std::string getName() const override {
+        return "MonteCarloAgent";
+    }
+
+    // Clones share the cache
+    std::unique_ptr<Player> clone() const override {
+        return std::make_unique<MonteCarloAgent>(playoutsPerMove, timeBudget, numThreads, cache);
+    }
+
+    // Search throughput over the agent's lifetime
+    long getTotalPlayouts() const { return totalPlayouts; }
+    double getPlayoutsPerSecond() const { return totalSeconds > 0 ? totalPlayouts / totalSeconds : 0.0; }
+};
+
+} // namespace SixNimmt
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "game.h"
+#include "agent_plugin.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace SixNimmt {
+
+// Agents loaded from shared libraries through the C interface in
+// agent_plugin.h. Loading a plugin registers each of its agents in the
+// AgentRegistry under the name it reports, replacing any agent of that
+// name, so tournaments and the contest use them like built-in agents.
+
+// An open plugin library; closed when the last agent using it is gone
+class PluginLibrary;
+
+// Player that forwards to a plugin agent. The GameState is copied into one
+// fixed SixNimmtPluginState per decision; nothing is allocated per call.
+class PluginAgent : public Player {
+public:
+    PluginAgent(std::shared_ptr<const PluginLibrary> library, const SixNimmtAgentPlugin* plugin);
+    ~PluginAgent() override;
+
+    PluginAgent(const PluginAgent&) = delete;
+    PluginAgent& operator=(const PluginAgent&) = delete;
+
+    void seed(uint64_t seed) override { agentSeed = seed; }
+    void initialize(int playerId, int numPlayers, const std::vector<Card>& initialHand) override;
+    // Throw std::runtime_error if the plugin answers out of range
+    int chooseCard(const GameState& state) override;
+    int chooseRowToTake(const GameState& state) override;
+
+    std::string getName() const override { return plugin->name; }
+    std::unique_ptr<Player> clone() const override { return std::make_unique<PluginAgent>(library, plugin); }
+
+private:
+    std::shared_ptr<const PluginLibrary> library;
+    const SixNimmtAgentPlugin* plugin;
+    void* instance;
+    uint64_t agentSeed = 0;
+    SixNimmtPluginState flat{};
+
+    const SixNimmtPluginState& flatten(const GameState& state);
+};
+
+// Loads the library at path and registers its agents; returns their names.
+// Throws std::invalid_argument if it cannot be opened, lacks the entry
+// point, or was built for another ABI version.
+std::vector<std::string> loadAgentPlugin(const std::string& path);
+
+// loadAgentPlugin for every .so file in directory, in name order
+std::vector<std::string> loadAgentPlugins(const std::string& directory);
+
+// "plugins" next to the running program, given argv[0]
+std::string defaultPluginDirectory(const char* program);
+
+} // namespace SixNimmt
@@ -0,0 +1,107 @@
+#pragma once
+
+#include "game.h"
+#include <iosfwd>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace SixNimmt {
+
+// Learned card-choice policies: a linear model or an MLP with one ReLU
+// hidden layer, scoring each card in the hand from a compact encoding of
+// the position; the highest score is played. All cards of a hand are scored
+// in one forward pass over a feature-major batch, so the inner loops run
+// over cards and vectorize with AVX2 (8 cards per register) where the CPU
+// has it.
+
+// Per-card inputs; penalties are scaled by 1/10 and counts to about 0-1
+constexpr int POLICY_CARD = 0;             // card number / 104
+constexpr int POLICY_BULL_HEADS = 1;       // bull heads / 7
+constexpr int POLICY_FORCED = 2;           // 1 if below every row
+constexpr int POLICY_FORCED_COST = 3;      // cheapest row's penalty if forced, else 0
+constexpr int POLICY_SIXTH = 4;            // 1 if it would be its row's 6th card
+constexpr int POLICY_SIXTH_COST = 5;       // that row's penalty if so, else 0
+constexpr int POLICY_GAP = 6;              // distance above the target row's tail / 104
+constexpr int POLICY_ROW_LENGTH = 7;       // target row length / 5
+constexpr int POLICY_ROW_PENALTY = 8;      // target row penalty
+constexpr int POLICY_UNSEEN_BETWEEN = 9;   // unseen cards between the tail and the card / 10
+constexpr int POLICY_RISK = 10;            // those cards over the room left in the row, at most 1
+constexpr int POLICY_UNSEEN_BELOW = 11;    // unseen cards below the card / 104
+constexpr int POLICY_RANK = 12;            // index in the hand / hand size
+constexpr int POLICY_HAND_SIZE = 13;       // cards in hand / 10
+constexpr int POLICY_OPPONENTS = 14;       // opponents / 9
+constexpr int POLICY_CHEAPEST_ROW = 15;    // penalty of the cheapest row
+constexpr int POLICY_INPUTS = 16;
+
+constexpr int POLICY_BATCH = 16;           // card slots per forward pass (>= HAND_SIZE)
+
+struct PolicyWeights {
+    std::string name = "PolicyAgent";   // the agent's getName()
+    int hidden = 0;                     // hidden units; 0 = linear policy
+
+    // MLP: hidden x POLICY_INPUTS, one row per hidden unit. Linear: empty.
+    std::vector<float> inputWeights;
+    std::vector<float> hiddenBias;      // hidden
+    // MLP: one per hidden unit. Linear: one per input.
+    std::vector<float> outputWeights;
+    float outputBias = 0.0f;
+};
+
+// The weights built into PolicyAgent (constexpr arrays in policy_agent.cpp):
+// a small hand-set MLP that prices forced takes, sixth cards and crowded
+// rows, as a starting point for trained weights
+PolicyWeights defaultPolicyWeights();
+
+// Text format: "6NPOLICY 1", "inputs 16", "hidden H", then the input
+// weights, hidden biases, output weights and output bias as whitespace-
+// separated numbers. Throws std::invalid_argument on malformed input.
+PolicyWeights readPolicyWeights(std::istream& in);
+void writePolicyWeights(std::ostream& out, const PolicyWeights& weights);
+
+// Whether this CPU runs the AVX2 forward pass
+bool policyHasAvx2();
+
+// Scores of the POLICY_BATCH card slots. inputs is feature-major
+// [POLICY_INPUTS][POLICY_BATCH], 32-byte aligned; unused slots are scored
+// too and ignored by the caller. The scalar path gives the same scores up
+// to rounding (it does not fuse multiply-adds).
+void evaluatePolicy(const PolicyWeights& weights, const float* inputs, float* scores, bool useAvx2);
+
+// Player running a policy; takes rows with the Player default. Instances
+// cloned from one share its weights.
+class PolicyAgent : public Player {
+public:
+    // The built-in weights, shared by all default instances
+    PolicyAgent();
+    explicit PolicyAgent(std::shared_ptr<const PolicyWeights> weights);
+
+    void initialize(int playerId, int numPlayers, const std::vector<Card>& initialHand) override;
+    int chooseCard(const GameState& state) override;
+
+    void onGameStart(const GameState& state) override;
+    void onCardsRevealed(const GameState& state) override;
+
+    std::string getName() const override { return weights->name; }
+    std::unique_ptr<Player> clone() const override { return std::make_unique<PolicyAgent>(weights); }
+
+    // Force the scalar path, for comparison
+    void setUseAvx2(bool use) { useAvx2 = use && policyHasAvx2(); }
+
+    // The inputs of every card in the hand, as passed to evaluatePolicy
+    const float* encode(const GameState& state);
+
+private:
+    std::shared_ptr<const PolicyWeights> weights;
+    bool useAvx2;
+    CardSet unseen;   // neither in the hand nor ever shown
+
+    alignas(32) float inputs[POLICY_INPUTS * POLICY_BATCH] = {};
+    alignas(32) float scores[POLICY_BATCH] = {};
+};
+
+// Agent built from a weights file; its name is "policy:" and the path.
+// Throws std::invalid_argument if the file cannot be read.
+std::unique_ptr<Player> loadPolicyAgent(const std::string& path);
+
+} // namespace SixNimmt
@@ -0,0 +1,199 @@
+#pragma once
+
+#include "game.h"
+#include "batch_engine.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace SixNimmt {
+
+// Out-of-process agents. A host process (sixnimmt_agent_host) serves one
+// registered agent; the contest talks to it through a shared memory region
+// (a memfd mapped by both processes) holding a request ring and a response
+// ring of fixed-size slots, plus a socket used only as a doorbell. A round
+// trip writes any number of requests, rings once, and waits for the host to
+// answer them all, so many games' decisions share one pair of wake-ups.
+//
+// Each request is addressed to a game id; the host keeps one agent instance
+// per id. Events and Init need no answer, so RemoteAgent queues them and
+// sends them ahead of its next decision in the same round trip.
+
+enum class RequestKind : uint8_t {
+    Hello,          // check the host serves a known agent; answer 0 or -1
+    Init,           // seed, seat, numPlayers and hand of a new game
+    GameStart,      // observer events, with the state they carry
+    CardsRevealed,
+    RowTaken,       // seat took row; the taken cards are in taken*
+    RoundEnd,
+    ChooseCard,     // answer: the card number played
+    ChooseRow,      // answer: the row taken (0-3)
+    Close           // forget the game id
+};
+
+// Fixed 104-byte encoding of a request and the GameState it refers to.
+// Rows travel as length, penalty and cards; a sender that only knows the
+// tail (BatchState) leaves the other cards 0.
+struct WireRequest {
+    uint64_t handLow = 0;    // the seat's hand as a CardSet
+    uint64_t handHigh = 0;
+    uint64_t seed = 0;       // Init
+    uint32_t game = 0;
+    RequestKind kind = RequestKind::Hello;
+    uint8_t seat = 0;
+    uint8_t numPlayers = 0;
+    uint8_t roundNumber = 0;
+    uint8_t rowLength[NUM_ROWS] = {};
+    uint8_t rowPenalty[NUM_ROWS] = {};
+    uint8_t rowCards[NUM_ROWS][MAX_ROW_LENGTH] = {};
+    uint8_t playedCards[MAX_PLAYERS] = {};
+    uint16_t scores[MAX_PLAYERS] = {};
+    uint8_t takenRow = 0;
+    uint8_t takenLength = 0;
+    uint8_t takenCards[MAX_ROW_LENGTH] = {};
+    uint8_t reserved[7] = {};
+};
+static_assert(sizeof(WireRequest) == 104, "WireRequest layout is part of the protocol");
+
+struct WireResponse {
+    uint32_t game = 0;
+    int32_t choice = -1;     // card number, row, or 0 / -1 for success / failure
+};
+
+constexpr uint32_t AGENT_PROTOCOL_MAGIC = 0x50414e36;   // "6NAP"
+constexpr uint32_t AGENT_PROTOCOL_VERSION = 1;
+constexpr uint32_t AGENT_RING_SLOTS = 1024;              // requests per round trip
+
+// Copy state (and hand) into a request, and back
+void encodeState(const GameState& state, const CardSet& hand, WireRequest& request);
+GameState decodeState(const WireRequest& request);
+
+// Shared memory layout, defined in remote_agent.cpp
+struct AgentRing;
+
+// sixnimmt_agent_host next to the running program, given argv[0]
+std::string defaultAgentHostPath(const char* program);
+
+// Client end of one host process. Thread-safe: while one thread's round
+// trip is in flight, other threads queue their requests, and the next round
+// trip carries all of them (flat combining), so concurrent games batch up
+// without any thread waiting for a timer.
+class AgentConnection {
+public:
+    // Starts hostPath serving agentName. Throws std::invalid_argument if the
+    // host cannot be started or does not know the agent.
+    AgentConnection(const std::string& hostPath, const std::string& agentName);
+    ~AgentConnection();
+
+    AgentConnection(const AgentConnection&) = delete;
+    AgentConnection& operator=(const AgentConnection&) = delete;
+
+    const std::string& getAgentName() const { return agentName; }
+
+    uint32_t newGameId() { return nextGame++; }
+
+    // Sends the requests and waits for their responses, in the same order.
+    // Throws std::runtime_error if the host fails or exits.
+    void exchange(const WireRequest* requests, size_t count, WireResponse* responses);
+
+    // Round trips so far and the requests they carried
+    long getRoundTrips() const { return roundTrips; }
+    long getRequests() const { return requestsSent; }
+
+private:
+    // A thread's requests waiting for a round trip
+    struct Submission {
+        const WireRequest* requests;
+        size_t count;
+        WireResponse* responses;
+        bool done = false;
+        std::exception_ptr error;
+    };
+
+    std::string agentName;
+    int pid = -1;
+    int memfd = -1;
+    int doorbell = -1;   // our end of the socket pair
+    AgentRing* ring = nullptr;
+    std::atomic<uint32_t> nextGame{0};
+
+    std::mutex mutex;
+    std::condition_variable finished;
+    std::deque<Submission*> queue;
+    bool inFlight = false;
+    long roundTrips = 0;
+    long requestsSent = 0;
+
+    // Writes the submissions to the ring in chunks of at most
+    // AGENT_RING_SLOTS and collects the answers; called without the mutex
+    void roundTrip(const std::vector<Submission*>& batch);
+    void ringAndWait(size_t count);
+    void shutdown();
+};
+
+// Player whose decisions are made by a host process. Instances cloned from
+// one share its connection (and process); each game gets its own agent
+// instance in the host.
+class RemoteAgent : public Player {
+public:
+    explicit RemoteAgent(std::shared_ptr<AgentConnection> connection);
+    ~RemoteAgent() override;
+
+    void seed(uint64_t seed) override { agentSeed = seed; }
+    void initialize(int playerId, int numPlayers, const std::vector<Card>& initialHand) override;
+    int chooseCard(const GameState& state) override;
+    int chooseRowToTake(const GameState& state) override;
+
+    void onGameStart(const GameState& state) override;
+    void onCardsRevealed(const GameState& state) override;
+    void onRowTaken(const GameState& state, int seat, int row, const Row& taken) override;
+    void onRoundEnd(const GameState& state) override;
+
+    // "remote:" and the hosted agent's name
+    std::string getName() const override { return "remote:" + connection->getAgentName(); }
+    std::unique_ptr<Player> clone() const override { return std::make_unique<RemoteAgent>(connection); }
+
+private:
+    std::shared_ptr<AgentConnection> connection;
+    uint32_t game;
+    uint64_t agentSeed = 0;
+    std::vector<WireRequest> pending;   // queued ahead of the next decision
+    std::vector<WireResponse> responses;
+
+    WireRequest& queue(RequestKind kind, const GameState* state);
+    int decide(RequestKind kind, const GameState& state);
+};
+
+// BatchEngine policy served by a host process: every game's chooseCards
+// request for a seat goes in one round trip (per AGENT_RING_SLOTS games).
+// The host sees rows reduced to tail, length and penalty as in BatchState,
+// no previous reveal, and no observer events.
+class RemoteBatchPolicy : public BatchPolicy {
+public:
+    explicit RemoteBatchPolicy(std::shared_ptr<AgentConnection> connection) : connection(std::move(connection)) {}
+    ~RemoteBatchPolicy() override;
+
+    void initialize(const BatchState& batch, int seat) override;
+    void chooseCards(const BatchState& batch, int seat, uint8_t* cards) override;
+    int chooseRowToTake(const BatchState& batch, int seat, int game) override;
+
+private:
+    std::shared_ptr<AgentConnection> connection;
+    std::vector<uint32_t> games;   // host game id per batch game
+    std::vector<WireRequest> requests;
+    std::vector<WireResponse> responses;
+
+    void encode(const BatchState& batch, int seat, int game, RequestKind kind, WireRequest& request) const;
+};
+
+// Host side: serves agentName over an inherited memfd and doorbell socket
+// until the client closes the socket; returns the process exit code
+int serveAgent(const std::string& agentName, int memfd, int doorbell);
+
+} // namespace SixNimmt
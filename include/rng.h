@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstdint>
+#include <iterator>
+#include <utility>
+
+namespace SixNimmt {
+
+// SplitMix64 finalizer: a bijective scrambling of 64 bits
+constexpr uint64_t mixBits(uint64_t z) {
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+// Seed of an independent stream identified by coordinates under a base seed,
+// e.g. deriveSeed(tournamentSeed, matchup, game). Different coordinates give
+// unrelated streams, so work can be split across threads or machines and
+// still replay exactly.
+constexpr uint64_t deriveSeed(uint64_t base, uint64_t a, uint64_t b = 0, uint64_t c = 0) {
+    uint64_t h = mixBits(base + 0x9e3779b97f4a7c15ULL);
+    h = mixBits(h ^ (a + 0x632be59bd9b4e019ULL));
+    h = mixBits(h ^ (b + 0x8cb92ba72f3d8dd7ULL));
+    h = mixBits(h ^ (c + 0xd1b54a32d192ed03ULL));
+    return h;
+}
+
+// Counter-based SplitMix64 generator. The whole state is one 64-bit counter,
+// so construction is free compared to std::mt19937's 5KB state. Satisfies
+// UniformRandomBitGenerator and can be used with <random> distributions.
+class Rng {
+public:
+    using result_type = uint64_t;
+
+    explicit Rng(uint64_t seed = 0) : counter(seed) {}
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return ~result_type(0); }
+
+    result_type operator()() {
+        counter += 0x9e3779b97f4a7c15ULL;
+        return mixBits(counter);
+    }
+
+    // Uniform integer in [0, bound) (Lemire's multiply-shift with rejection)
+    uint32_t below(uint32_t bound) {
+        uint64_t product = static_cast<uint64_t>(static_cast<uint32_t>((*this)() >> 32)) * bound;
+        uint32_t low = static_cast<uint32_t>(product);
+        if (low < bound) {
+            uint32_t threshold = -bound % bound;
+            while (low < threshold) {
+                product = static_cast<uint64_t>(static_cast<uint32_t>((*this)() >> 32)) * bound;
+                low = static_cast<uint32_t>(product);
+            }
+        }
+        return static_cast<uint32_t>(product >> 32);
+    }
+
+    // Uniform double in [0, 1)
+    double uniform() {
+        return ((*this)() >> 11) * 0x1.0p-53;
+    }
+
+private:
+    uint64_t counter;
+};
+
+// Fisher-Yates shuffle driven by Rng::below. Unlike std::shuffle the result
+// does not depend on the standard library implementation, so shuffles are
+// bit-identical across platforms.
+template <typename RandomIt>
+void shuffleRange(RandomIt first, RandomIt last, Rng& rng) {
+    auto n = std::distance(first, last);
+    for (auto i = n - 1; i > 0; --i) {
+        auto j = rng.below(static_cast<uint32_t>(i + 1));
+        using std::swap;
+        swap(first[i], first[j]);
+    }
+}
+
+} // namespace SixNimmt
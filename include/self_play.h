@@ -0,0 +1,85 @@
+#pragma once
+
+#include "game.h"
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace SixNimmt {
+
+// Self-play training data. Games are played by registered agents through
+// Game; every chooseCard decision becomes one fixed-width record holding
+// what the deciding seat could see, the card it played and how its game
+// ended. Records go to NPY files (one structured array per chunk of games)
+// that numpy.load reads directly.
+
+// Feature layout: one byte each, at these offsets
+constexpr int FEATURE_ROW_TAILS = 0;          // [4] last card of each row
+constexpr int FEATURE_ROW_LENGTHS = 4;        // [4]
+constexpr int FEATURE_ROW_PENALTIES = 8;      // [4] bull heads in each row
+constexpr int FEATURE_HAND = 12;              // [104] 1 if card i + 1 is in the hand
+constexpr int FEATURE_UNSEEN = 116;           // [104] 1 if card i + 1 was never shown
+                                              //       and is not in the hand
+constexpr int FEATURE_SCORES = 220;           // [10] penalty points per seat, at most 255
+constexpr int FEATURE_ROWS_TAKEN = 230;       // [10] rows collected per seat
+constexpr int FEATURE_ROUND = 240;            // round number, 1-10
+constexpr int FEATURE_NUM_PLAYERS = 241;
+constexpr int FEATURE_SEAT = 242;             // deciding seat; per-seat features are
+                                              // indexed by absolute seat
+constexpr int SELF_PLAY_FEATURES = 243;
+
+// One decision, written as is (little-endian, no padding)
+struct SelfPlayRecord {
+    uint32_t game = 0;         // index of the game in the run
+    int16_t finalScore = 0;    // the seat's penalty points at the end
+    int16_t finalMargin = 0;   // finalScore * (players - 1) minus the others'; lower is better
+    uint8_t action = 0;        // card number played
+    uint8_t features[SELF_PLAY_FEATURES] = {};
+};
+static_assert(sizeof(SelfPlayRecord) == 252, "SelfPlayRecord layout is part of the file format");
+
+// What a seat has seen of a game, beyond the table itself
+struct SeatView {
+    int seat = 0;
+    CardSet hand;
+    CardSet unseen;                                  // never shown and not in the hand
+    std::array<uint8_t, MAX_PLAYERS> rowsTaken{};
+};
+
+// The features of a chooseCard decision
+void encodeFeatures(const GameState& state, const SeatView& view, uint8_t* features);
+
+// NPY (format 1.0) header for a file of `records` SelfPlayRecords
+std::string selfPlayNpyHeader(size_t records);
+
+struct SelfPlaySettings {
+    std::vector<std::string> agents;   // registered names; seat s of game g plays
+                                       // agents[(g + s) % agents.size()]
+    int numPlayers = 4;
+    long numGames = 10000;
+    long gamesPerChunk = 1000;         // games per output file
+    int numThreads = 0;                // 0 = all hardware threads
+    uint64_t seed = 0;                 // game g is Game(players, deriveSeed(seed, g))
+    std::string outputPrefix;          // chunk c goes to <prefix>_<c, 5 digits>.npy
+    int maxPendingChunks = 0;          // finished chunks waiting for the writer
+                                       // before workers block; 0 = 2 per thread
+};
+
+struct SelfPlaySummary {
+    long games = 0;
+    long decisions = 0;
+    std::vector<std::string> files;   // in chunk order
+};
+
+// Plays the games on a thread pool, one chunk per task, while a background
+// thread writes finished chunks. A chunk's content depends only on its
+// index, so the files are byte-identical for any thread count. Throws
+// std::invalid_argument for bad settings and std::runtime_error if a file
+// cannot be written.
+SelfPlaySummary generateSelfPlay(const SelfPlaySettings& settings);
+
+// Name of chunk c's file
+std::string selfPlayChunkPath(const std::string& prefix, long chunk);
+
+} // namespace SixNimmt
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "game.h"
+#include <array>
+#include <cstdint>
+
+namespace SixNimmt {
+
+// Complete, copyable snapshot of a game: the table plus every hand. It owns
+// no heap memory, so search agents can clone it freely (a copy is a few
+// hundred bytes) instead of building a Game with its player objects.
+struct SimState {
+    GameState table;
+    std::array<CardSet, MAX_PLAYERS> hands;
+
+    int numPlayers() const { return table.numPlayers; }
+    int roundsLeft() const { return hands[0].size(); }
+};
+
+// Resolve one round the way Game::playRound does: the cards leave their
+// owners' hands and are placed with resolveRound (game.h), so a seat that
+// must take a row takes the one with the fewest bull heads.
+void playRound(SimState& sim, const RoundCards& cards);
+
+// Card choice used in simulated rounds: returns a card number from seat's hand
+using RolloutPolicy = int (*)(const SimState& sim, int seat, Rng& rng);
+
+// Uniformly random card
+int randomRolloutCard(const SimState& sim, int seat, Rng& rng);
+
+// Play the remaining rounds with the same policy for every seat
+void playOut(SimState& sim, RolloutPolicy policy, Rng& rng);
+
+} // namespace SixNimmt
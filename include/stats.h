@@ -0,0 +1,150 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <iosfwd>
+#include <vector>
+
+namespace SixNimmt {
+
+// Streaming mean and variance (Welford's update). Two accumulators merge
+// exactly (Chan et al.), so each thread can keep its own.
+class RunningStats {
+public:
+    void add(double value);
+    void add(const RunningStats& other);
+
+    long count() const { return n; }
+    double mean() const { return average; }
+    double variance() const { return n > 1 ? squares / (n - 1) : 0.0; }   // sample variance
+    double stddev() const;
+    double standardError() const;
+    double min() const { return minimum; }
+    double max() const { return maximum; }
+
+private:
+    long n = 0;
+    double average = 0.0;
+    double squares = 0.0;   // sum of squared deviations from the mean
+    double minimum = 0.0;
+    double maximum = 0.0;
+};
+
+// Distribution of one agent's penalty points per game. Scores are small
+// integers, so exact counts give the mean, variance and percentiles without
+// rounding, whatever order the accumulators are merged in.
+class ScoreHistogram {
+public:
+    static constexpr int MAX_BIN = 127;   // higher scores share the last bin
+
+    void add(int score, long weight = 1);
+    void add(const ScoreHistogram& other);
+
+    long count() const { return total; }
+    double mean() const { return total ? static_cast<double>(sum) / total : 0.0; }
+    double variance() const;
+    double stddev() const;
+
+    // Lowest score with at least p percent (0-100) of the games at or below it
+    int percentile(double p) const;
+
+    long binCount(int score) const { return counts[score]; }
+
+private:
+    std::array<long, MAX_BIN + 1> counts{};
+    long total = 0;
+    long sum = 0;
+    long squares = 0;
+
+    friend class TournamentStats;
+};
+
+// Head-to-head results between agents, from finishing positions: in a game
+// of any size every agent beats each agent with a higher score and ties
+// those with the same score. Points are kept in halves (win 2, tie 1) so
+// all counts stay integral.
+class PairwiseMatrix {
+public:
+    explicit PairwiseMatrix(int numAgents = 0) : agents(numAgents), halfPoints(numAgents * numAgents, 0) {}
+
+    int size() const { return agents; }
+
+    // One game: agent and score per seat; weight counts it several times
+    void addGame(const int* seatAgents, const int* scores, int numSeats, long weight = 1);
+    void add(const PairwiseMatrix& other);
+
+    long getHalfPoints(int agent, int opponent) const { return halfPoints[agent * agents + opponent]; }
+    long games(int agent, int opponent) const {
+        return (getHalfPoints(agent, opponent) + getHalfPoints(opponent, agent)) / 2;
+    }
+    // Share of the points agent took from opponent, 0.5 if they never met
+    double score(int agent, int opponent) const;
+
+    // Bradley-Terry strengths fitted by maximum likelihood (minorization-
+    // maximization), on the Elo scale (400 log10 strength) with mean 0. Each
+    // pair that met gets one extra virtual tie, so an agent that never won
+    // still gets a finite rating.
+    std::vector<double> eloRatings() const;
+
+private:
+    int agents;
+    std::vector<long> halfPoints;   // [agent * agents + opponent]
+
+    friend class TournamentStats;
+};
+
+// Streaming summary of a tournament: per-agent score histograms, the
+// pairwise matrix and a Poisson bootstrap. Instead of storing the games
+// for resampling, each game enters every bootstrap replicate with a
+// Poisson(1) weight drawn from a seed, which approximates resampling with
+// replacement and keeps the replicates mergeable. Everything is an integer
+// sum, so per-thread accumulators merge in any order to the same result.
+class TournamentStats {
+public:
+    struct Interval {
+        double low = 0.0;
+        double high = 0.0;
+    };
+
+    TournamentStats() = default;
+    TournamentStats(int numAgents, int bootstrapReplicates);
+
+    int numAgents() const { return agents; }
+    int getReplicates() const { return replicates; }
+
+    // One game: agent and score per seat. Games with the same resampleSeed
+    // get the same bootstrap weights, so the replays of a duplicate deal
+    // are resampled together.
+    void addGame(const int* seatAgents, const int* scores, int numSeats, uint64_t resampleSeed);
+
+    // Both must have the same agents and replicates
+    void add(const TournamentStats& other);
+
+    const ScoreHistogram& getScores(int agent) const { return scores[agent]; }
+    const PairwiseMatrix& getPairwise() const { return pairwise; }
+    std::vector<double> eloRatings() const { return pairwise.eloRatings(); }
+
+    // Central bootstrap intervals, e.g. level 0.95, and the bootstrap
+    // standard error of the ratings; zero-width without replicates
+    std::vector<Interval> eloIntervals(double level = 0.95) const;
+    std::vector<double> eloStandardErrors() const;
+    std::vector<Interval> averageScoreIntervals(double level = 0.95) const;
+
+    // Whitespace-separated integers, for tournament shard files
+    void write(std::ostream& out) const;
+    // Throws std::invalid_argument on malformed input
+    static TournamentStats read(std::istream& in);
+
+private:
+    int agents = 0;
+    int replicates = 0;
+    std::vector<ScoreHistogram> scores;              // per agent
+    PairwiseMatrix pairwise;
+    std::vector<PairwiseMatrix> replicatePairwise;   // per replicate
+    std::vector<long> replicateScoreSums;            // [replicate * agents + agent]
+    std::vector<long> replicateGames;
+
+    std::vector<std::vector<double>> replicateElo() const;
+};
+
+} // namespace SixNimmt
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace SixNimmt {
+
+// Fixed-size pool of worker threads running index-based parallel loops.
+// The calling thread takes part as worker 0, so a pool of size 1 runs
+// everything inline without spawning any threads.
+class ThreadPool {
+public:
+    // Task signature: (workerIndex, taskIndex). workerIndex is in [0, size())
+    // and is stable for the duration of a parallelFor call, so tasks can use
+    // it to address per-worker scratch state without locking.
+    using Task = std::function<void(int, size_t)>;
+
+    // numThreads <= 0 uses std::thread::hardware_concurrency()
+    explicit ThreadPool(int numThreads = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    int size() const { return static_cast<int>(queues.size()); }
+
+    // Run task(worker, i) for every i in [0, numTasks) and block until all
+    // of them have finished. Indices are dealt out to the workers as
+    // contiguous blocks; a worker that runs dry steals the upper half of
+    // the largest remaining block. The first exception thrown by a task is
+    // rethrown here after all workers have stopped.
+    void parallelFor(size_t numTasks, const Task& task);
+
+private:
+    // Remaining task indices [begin, end) owned by one worker
+    struct WorkQueue {
+        std::mutex mutex;
+        size_t begin = 0;
+        size_t end = 0;
+    };
+
+    std::vector<std::unique_ptr<WorkQueue>> queues;
+    std::vector<std::thread> threads;
+
+    std::mutex mutex;
+    std::condition_variable wakeWorkers;
+    std::condition_variable jobDone;
+    const Task* currentTask = nullptr;
+    unsigned long generation = 0;
+    int activeWorkers = 0;
+    bool stopping = false;
+    std::exception_ptr firstError;
+
+    void workerLoop(int workerIndex);
+    void runWorker(int workerIndex, const Task& task);
+    bool popTask(int workerIndex, size_t& taskIndex);
+    bool stealTasks(int workerIndex);
+};
+
+} // namespace SixNimmt
@@ -0,0 +1,208 @@
+#pragma once
+
+#include "game.h"
+#include "stats.h"
+#include <chrono>
+#include <cstdint>
+#include <iosfwd>
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace SixNimmt {
+
+// Totals for one agent, over one table or the whole tournament. Counts are
+// per seat played, so an agent seated twice in a game counts twice.
+struct AgentStats {
+    long games = 0;
+    long wins = 0;         // strictly lowest score at the table
+    long totalScore = 0;
+    long totalRank = 0;    // 1 = lowest score; tied agents share the better rank
+
+    // Duplicate mode: per deal, the agent's penalty margin summed over all
+    // replays of the deal (own points times the number of opponents minus
+    // the opponents' points). The deal's luck cancels out of the margin, so
+    // it separates agents with far fewer games than raw scores; negative is
+    // better.
+    long deals = 0;
+    long marginSum = 0;
+    long marginSquares = 0;
+
+    void add(const AgentStats& other);
+    void addDeal(long margin);
+
+    double winRate() const { return games ? static_cast<double>(wins) / games : 0.0; }
+    double averageScore() const { return games ? static_cast<double>(totalScore) / games : 0.0; }
+    double averageRank() const { return games ? static_cast<double>(totalRank) / games : 0.0; }
+    double averageMargin() const { return deals ? static_cast<double>(marginSum) / deals : 0.0; }
+    double marginStandardError() const;
+};
+
+// One table of the schedule. Deal d seats lineup[(s + d) % lineup.size()] in
+// seat s, so agents rotate through the seats (and, with more agents than
+// seats, take turns sitting out).
+struct TableResult {
+    std::vector<int> lineup;          // agent indices
+    std::vector<AgentStats> stats;    // per lineup position
+    int games = 0;                    // games played at this table
+    int deals = 0;                    // distinct deals (games unless duplicate)
+
+    // Early stopping (pairs only): the lineup position the SPRT found
+    // stronger (-1 if none), or whether it found neither stronger by delta;
+    // with neither, the budget ran out first and the pairing is undecided.
+    // llr[i] is the log-likelihood ratio of position i being the stronger.
+    int leader = -1;
+    bool noDifference = false;
+    std::array<double, 2> llr{};
+
+    bool decided() const { return leader >= 0 || noDifference; }
+};
+
+struct TournamentResult {
+    uint64_t seed = 0;
+    int numSeats = 2;
+    int gamesPerTable = 0;
+    int numThreads = 1;
+    bool earlyStopping = false;
+    bool duplicate = false;
+    bool timed = false;
+    std::chrono::nanoseconds moveTimeLimit{0};
+    std::vector<std::string> agentNames;
+
+    // Deals of the schedule this result covers, [firstDeal, endDeal) of
+    // scheduleDeals; the whole schedule unless the run was a shard
+    long firstDeal = 0;
+    long endDeal = 0;
+    long scheduleDeals = 0;
+
+    std::vector<TableResult> tables;
+    std::vector<AgentStats> standings;   // per agent, summed over all tables
+    std::vector<DecisionStats> decisions;   // per agent, when timed
+
+    // Ratings, score distributions and bootstrap intervals, when collected
+    bool detailedStats = false;
+    TournamentStats statistics;
+};
+
+// Sequential probability ratio test for a pairing: one SPRT per direction
+// over the decisive games, each testing H0 "even, p = 0.5" against H1 "this
+// agent wins with p = 0.5 + delta". A pairing stops when either test accepts
+// H1 (that agent is stronger) or both accept H0 (no difference of delta).
+// alpha bounds the chance of naming a stronger agent in an even pairing (half
+// per direction) and beta the chance of missing a real edge of delta.
+struct SprtSettings {
+    double delta = 0.05;
+    double alpha = 0.05;
+    double beta = 0.05;
+    int batchSize = 100;   // games per pairing between two looks at the data
+};
+
+// Of one direction: wins of the agent under test, then of its opponent
+double sprtLogLikelihoodRatio(const SprtSettings& settings, long wins, long losses);
+double sprtUpperBound(const SprtSettings& settings);   // accept H1 at or above
+double sprtLowerBound(const SprtSettings& settings);   // accept H0 at or below
+
+enum class OutputFormat { Table, Csv, Json, Shard };
+
+// Parses "table", "csv", "json" or "shard"; false for anything else
+bool parseOutputFormat(const std::string& text, OutputFormat& format);
+
+// Table: the per-table lines and standings for people. Csv: one row per
+// table and agent plus "all" rows for the standings. Json: one document.
+// Shard: the settings and raw per-table counts, which readShard() loads
+// back for mergeShards().
+void writeResults(std::ostream& out, const TournamentResult& result, OutputFormat format);
+
+// Shard file format (text, whitespace separated):
+//
+//   6NSHARD 1
+//   seed <seed> seats <n> games_per_table <n> duplicate <0|1>
+//   deals <first> <end> <schedule deals>
+//   agents <count>, then one name per line
+//   tables <count>, then per table:
+//     table <games> <deals> <lineup size> <agent index...>
+//     <games> <wins> <score> <rank> <deals> <margin sum> <margin squares>   per lineup position
+//   statistics 0, or statistics 1 followed by TournamentStats::write()
+//
+// Version 1 files end before the statistics line. Latency statistics are
+// not stored; shards cannot be timed.
+constexpr int SHARD_FORMAT_VERSION = 2;
+
+// Throws std::invalid_argument on a malformed file
+TournamentResult readShard(std::istream& in);
+
+// Sums shards of one tournament into the result a single run with the same
+// settings and seed gives. The shards must come from the same settings and
+// together cover every deal of the schedule exactly once, in any order;
+// throws std::invalid_argument otherwise.
+TournamentResult mergeShards(const std::vector<TournamentResult>& shards);
+
+// Plays every table of a schedule on a thread pool
+class Tournament {
+public:
+    // Agents must be clonable (registered or overriding Player::clone())
+    void addPlayer(std::unique_ptr<Player> player);
+
+    size_t size() const { return players.size(); }
+
+    // Stop round-robin pairings early once the SPRT decides them. The total
+    // budget stays gamesPerTable per pairing, and what decided pairings leave
+    // unused is spent on the close ones. Free-for-all tables ignore this.
+    void setEarlyStopping(const SprtSettings& settings) { sprt = settings; }
+
+    // Duplicate mode: every deal is replayed with the lineup rotated through
+    // all seats (both seatings for a pair), so each agent plays each hand,
+    // and results include the paired margins. gamesPerTable still counts
+    // games, i.e. gamesPerTable / lineup size deals.
+    void setDuplicate(bool enabled) { duplicate = enabled; }
+
+    // Time every agent decision and report chooseCard / chooseRowToTake
+    // latency percentiles per agent. With a nonzero limit, a decision that
+    // takes longer is replaced by the default move (see
+    // Game::setMoveTimeLimit) and counted as a timeout; results then depend
+    // on machine load, not just the seed.
+    void setDecisionTiming(std::chrono::nanoseconds limit = std::chrono::nanoseconds(0)) {
+        timeDecisions = true;
+        moveTimeLimit = limit;
+    }
+
+    // Collect a TournamentStats over all games: score histograms, the
+    // head-to-head matrix, Bradley-Terry (Elo scale) ratings and Poisson
+    // bootstrap intervals with the given number of replicates. A deal's
+    // bootstrap weights are derived from its seed, so the statistics are
+    // as reproducible as the games.
+    void setStatistics(int bootstrapReplicates = 100) {
+        collectStats = true;
+        this->bootstrapReplicates = bootstrapReplicates;
+    }
+
+    // Play only deals [firstDeal, endDeal) of the schedule, so that a long
+    // tournament can be split over processes or machines and the shards
+    // combined with mergeShards(). The schedule lists the deals of table 0,
+    // then table 1 and so on; it has tables * max(1, gamesPerTable / deal
+    // size) deals, where a deal is one game, or one game per lineup rotation
+    // in duplicate mode. endDeal is capped at the schedule's end. Cannot be
+    // combined with early stopping or decision timing.
+    void setShard(long firstDeal, long endDeal) { shard = std::make_pair(firstDeal, endDeal); }
+
+    // numSeats 2 plays a round-robin of every pair of agents; 3-10 plays one
+    // free-for-all table with all agents in rotation. Deal d of table t is
+    // seeded with deriveSeed(seed, t, d), so a run is reproducible from its
+    // seed regardless of the thread count. Throws std::invalid_argument if
+    // the schedule cannot be played.
+    TournamentResult run(int numSeats, int gamesPerTable, int numThreads = 1, uint64_t seed = randomSeed());
+
+private:
+    std::vector<std::unique_ptr<Player>> players;
+    std::optional<SprtSettings> sprt;
+    std::optional<std::pair<long, long>> shard;
+    bool duplicate = false;
+    bool timeDecisions = false;
+    std::chrono::nanoseconds moveTimeLimit{0};
+    bool collectStats = false;
+    int bootstrapReplicates = 0;
+};
+
+} // namespace SixNimmt
@@ -0,0 +1,38 @@
+#include "remote_agent.h"
+#include "agent_registry.h"
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+// Serves one registered agent to a contest process over the shared memory
+// protocol in remote_agent.h. Started by AgentConnection, which passes the
+// inherited descriptors; not meant to be run by hand.
+
+int main(int argc, char* argv[]) {
+    std::string agentName;
+    int memfd = -1;
+    int doorbell = -1;
+
+    try {
+        for (int i = 1; i + 1 < argc; i += 2) {
+            std::string option = argv[i];
+            if (option == "--agent") {
+                agentName = argv[i + 1];
+            } else if (option == "--memfd") {
+                memfd = std::stoi(argv[i + 1]);
+            } else if (option == "--doorbell") {
+                doorbell = std::stoi(argv[i + 1]);
+            } else {
+                throw std::invalid_argument("unknown option " + option);
+            }
+        }
+        if (agentName.empty() || memfd < 0 || doorbell < 0) {
+            throw std::invalid_argument("usage: --agent NAME --memfd FD --doorbell FD");
+        }
+    } catch (const std::exception& e) {
+        std::cerr << argv[0] << ": " << e.what() << std::endl;
+        return 1;
+    }
+
+    return SixNimmt::serveAgent(agentName, memfd, doorbell);
+}
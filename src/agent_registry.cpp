@@ -0,0 +1,45 @@
+#include "agent_registry.h"
+
+namespace SixNimmt {
+
+AgentRegistry& AgentRegistry::instance() {
+    static AgentRegistry registry;
+    return registry;
+}
+
+bool AgentRegistry::add(const std::string& name, Factory factory) {
+    std::lock_guard<std::mutex> lock(mutex);
+    factories[name] = std::move(factory);
+    return true;
+}
+
+std::unique_ptr<Player> AgentRegistry::create(const std::string& name) const {
+    Factory factory;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = factories.find(name);
+        if (it == factories.end()) return nullptr;
+        factory = it->second;
+    }
+    return factory();
+}
+
+bool AgentRegistry::contains(const std::string& name) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return factories.count(name) != 0;
+}
+
+std::vector<std::string> AgentRegistry::names() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::vector<std::string> result;
+    for (const auto& entry : factories) {
+        result.push_back(entry.first);
+    }
+    return result;
+}
+
+std::unique_ptr<Player> Player::clone() const {
+    return AgentRegistry::instance().create(getName());
+}
+
+} // namespace SixNimmt
@@ -0,0 +1,335 @@
+#include "batch_engine.h"
+#include "rng.h"
+#include <algorithm>
+#include <numeric>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace SixNimmt {
+
+namespace {
+
+constexpr int SIMD_WIDTH = 16;   // uint8 lanes per SSE register
+
+// Hand of a seat in one game
+inline CardSet handOf(const BatchState& batch, int seat, int game) {
+    size_t i = batch.at(seat, game);
+    return CardSet(batch.handLow[i], batch.handHigh[i]);
+}
+
+// For every game find the row whose last card is the closest one below the
+// played card, or -1 if the card is lower than all of them
+void findBestRows(const BatchState& batch, const uint8_t* cards, int8_t* rows) {
+    int game = 0;
+#if defined(__SSE2__)
+    const __m128i allOnes = _mm_set1_epi8(-1);
+    for (; game + SIMD_WIDTH <= batch.stride; game += SIMD_WIDTH) {
+        __m128i card = _mm_loadu_si128(reinterpret_cast<const __m128i*>(cards + game));
+        __m128i best = allOnes;
+        __m128i bestRow = _mm_setzero_si128();
+        for (int row = 0; row < NUM_ROWS; ++row) {
+            __m128i tail = _mm_loadu_si128(reinterpret_cast<const __m128i*>(batch.rowTail[row].data() + game));
+            // card - tail, saturating to 0 when the tail is higher; cards are
+            // distinct, so 0 means "does not fit" and becomes 0xFF
+            __m128i diff = _mm_subs_epu8(card, tail);
+            diff = _mm_or_si128(diff, _mm_cmpeq_epi8(diff, _mm_setzero_si128()));
+            __m128i smaller = _mm_xor_si128(_mm_cmpeq_epi8(_mm_min_epu8(diff, best), best), allOnes);
+            best = _mm_min_epu8(diff, best);
+            bestRow = _mm_or_si128(_mm_andnot_si128(smaller, bestRow), _mm_and_si128(smaller, _mm_set1_epi8(row)));
+        }
+        // No fitting row leaves best at 0xFF, which is -1 as int8
+        bestRow = _mm_or_si128(bestRow, _mm_cmpeq_epi8(best, allOnes));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(rows + game), bestRow);
+    }
+#endif
+    for (; game < batch.stride; ++game) {
+        int bestRow = -1;
+        int bestDifference = 1000;
+        for (int row = 0; row < NUM_ROWS; ++row) {
+            int difference = cards[game] - batch.rowTail[row][game];
+            if (difference > 0 && difference < bestDifference) {
+                bestDifference = difference;
+                bestRow = row;
+            }
+        }
+        rows[game] = static_cast<int8_t>(bestRow);
+    }
+}
+
+// Put every card on its target row. A row is taken (its penalty moved to
+// taken[game] and the row restarted with the card) when it already holds 5
+// cards or when forced[game] is set.
+void placeCards(BatchState& batch, const uint8_t* cards, const int8_t* rows, const uint8_t* forced, uint8_t* taken) {
+    int game = 0;
+#if defined(__SSE2__)
+    const __m128i one = _mm_set1_epi8(1);
+    const __m128i fullLength = _mm_set1_epi8(MAX_ROW_LENGTH);
+    alignas(16) uint8_t bulls[SIMD_WIDTH];
+    for (; game + SIMD_WIDTH <= batch.stride; game += SIMD_WIDTH) {
+        for (int lane = 0; lane < SIMD_WIDTH; ++lane) {
+            bulls[lane] = BULL_HEADS[cards[game + lane]];
+        }
+        __m128i card = _mm_loadu_si128(reinterpret_cast<const __m128i*>(cards + game));
+        __m128i bull = _mm_load_si128(reinterpret_cast<const __m128i*>(bulls));
+        __m128i target = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rows + game));
+        __m128i force = _mm_loadu_si128(reinterpret_cast<const __m128i*>(forced + game));
+        __m128i penalty = _mm_setzero_si128();
+
+        for (int row = 0; row < NUM_ROWS; ++row) {
+            __m128i* tailPtr = reinterpret_cast<__m128i*>(batch.rowTail[row].data() + game);
+            __m128i* lengthPtr = reinterpret_cast<__m128i*>(batch.rowLength[row].data() + game);
+            __m128i* penaltyPtr = reinterpret_cast<__m128i*>(batch.rowPenalty[row].data() + game);
+            __m128i tail = _mm_loadu_si128(tailPtr);
+            __m128i length = _mm_loadu_si128(lengthPtr);
+            __m128i rowPenalty = _mm_loadu_si128(penaltyPtr);
+
+            __m128i here = _mm_cmpeq_epi8(target, _mm_set1_epi8(row));
+            __m128i take = _mm_or_si128(force, _mm_cmpeq_epi8(length, fullLength));
+            __m128i takeHere = _mm_and_si128(here, take);
+
+            penalty = _mm_or_si128(penalty, _mm_and_si128(takeHere, rowPenalty));
+
+            __m128i newLength = _mm_or_si128(_mm_and_si128(take, one), _mm_andnot_si128(take, _mm_add_epi8(length, one)));
+            __m128i newPenalty = _mm_or_si128(_mm_and_si128(take, bull), _mm_andnot_si128(take, _mm_add_epi8(rowPenalty, bull)));
+
+            _mm_storeu_si128(tailPtr, _mm_or_si128(_mm_and_si128(here, card), _mm_andnot_si128(here, tail)));
+            _mm_storeu_si128(lengthPtr, _mm_or_si128(_mm_and_si128(here, newLength), _mm_andnot_si128(here, length)));
+            _mm_storeu_si128(penaltyPtr, _mm_or_si128(_mm_and_si128(here, newPenalty), _mm_andnot_si128(here, rowPenalty)));
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(taken + game), penalty);
+    }
+#endif
+    for (; game < batch.stride; ++game) {
+        int row = rows[game];
+        int bull = BULL_HEADS[cards[game]];
+        if (forced[game] || batch.rowLength[row][game] == MAX_ROW_LENGTH) {
+            taken[game] = batch.rowPenalty[row][game];
+            batch.rowLength[row][game] = 1;
+            batch.rowPenalty[row][game] = static_cast<uint8_t>(bull);
+        } else {
+            taken[game] = 0;
+            batch.rowLength[row][game]++;
+            batch.rowPenalty[row][game] += static_cast<uint8_t>(bull);
+        }
+        batch.rowTail[row][game] = cards[game];
+    }
+}
+
+class LowestCardFirstKernel : public BatchPolicy {
+public:
+    void chooseCards(const BatchState& batch, int seat, uint8_t* cards) override {
+        for (int game = 0; game < batch.numGames; ++game) {
+            cards[game] = static_cast<uint8_t>(handOf(batch, seat, game).lowest());
+        }
+    }
+};
+
+class HighestCardFirstKernel : public BatchPolicy {
+public:
+    void chooseCards(const BatchState& batch, int seat, uint8_t* cards) override {
+        for (int game = 0; game < batch.numGames; ++game) {
+            cards[game] = static_cast<uint8_t>(handOf(batch, seat, game).highest());
+        }
+    }
+};
+
+// Most bull heads, lowest number among equals (the first such card of a sorted hand)
+class BullsHeadsFirstKernel : public BatchPolicy {
+public:
+    void chooseCards(const BatchState& batch, int seat, uint8_t* cards) override {
+        for (int game = 0; game < batch.numGames; ++game) {
+            CardSet hand = handOf(batch, seat, game);
+            int card = hand.lowest();
+            for (int bullHeads : {7, 5, 3, 2}) {
+                CardSet candidates = hand & BULL_HEAD_CLASSES[bullHeads];
+                if (!candidates.empty()) {
+                    card = candidates.lowest();
+                    break;
+                }
+            }
+            cards[game] = static_cast<uint8_t>(card);
+        }
+    }
+};
+
+// Draws from the same per-seat stream as RandomAgent
+class RandomKernel : public BatchPolicy {
+private:
+    std::vector<Rng> rngs;
+
+public:
+    void initialize(const BatchState& batch, int seat) override {
+        rngs.clear();
+        for (int game = 0; game < batch.numGames; ++game) {
+            rngs.emplace_back(deriveSeed(batch.seeds[game], seat + 1));
+        }
+    }
+
+    void chooseCards(const BatchState& batch, int seat, uint8_t* cards) override {
+        for (int game = 0; game < batch.numGames; ++game) {
+            CardSet hand = handOf(batch, seat, game);
+            int index = static_cast<int>(rngs[game].below(hand.size()));
+            cards[game] = static_cast<uint8_t>(hand.select(index));
+        }
+    }
+};
+
+} // namespace
+
+int BatchPolicy::chooseRowToTake(const BatchState& batch, int /*seat*/, int game) {
+    int bestRow = 0;
+    for (int row = 1; row < NUM_ROWS; ++row) {
+        if (batch.rowPenalty[row][game] < batch.rowPenalty[bestRow][game]) {
+            bestRow = row;
+        }
+    }
+    return bestRow;
+}
+
+std::unique_ptr<BatchPolicy> createBatchPolicy(const std::string& agentName) {
+    if (agentName == "LowestCardFirstAgent") return std::make_unique<LowestCardFirstKernel>();
+    if (agentName == "HighestCardFirstAgent") return std::make_unique<HighestCardFirstKernel>();
+    if (agentName == "BullsHeadsFirstAgent") return std::make_unique<BullsHeadsFirstKernel>();
+    if (agentName == "RandomAgent") return std::make_unique<RandomKernel>();
+    return nullptr;
+}
+
+BatchEngine::BatchEngine(std::vector<std::unique_ptr<BatchPolicy>>&& policies, const std::vector<uint64_t>& seeds)
+    : policies(std::move(policies)) {
+    assert(this->policies.size() >= 2 && "Must have at least 2 players");
+    assert(this->policies.size() <= MAX_PLAYERS && "Cannot have more than 10 players");
+
+    state.numGames = static_cast<int>(seeds.size());
+    state.numPlayers = static_cast<int>(this->policies.size());
+    state.stride = (state.numGames + SIMD_WIDTH - 1) / SIMD_WIDTH * SIMD_WIDTH;
+    state.seeds = seeds;
+
+    // Padding games past numGames are never dealt or scored; they only keep
+    // the SIMD loops free of tail handling
+    for (int row = 0; row < NUM_ROWS; ++row) {
+        state.rowTail[row].assign(state.stride, 0);
+        state.rowLength[row].assign(state.stride, 1);
+        state.rowPenalty[row].assign(state.stride, 0);
+    }
+    size_t seatSlots = static_cast<size_t>(state.numPlayers) * state.stride;
+    state.handLow.assign(seatSlots, 0);
+    state.handHigh.assign(seatSlots, 0);
+    state.scores.assign(seatSlots, 0);
+
+    playedCards.assign(seatSlots, 0);
+    sortedCards.assign(seatSlots, 0);
+    sortedSeats.assign(seatSlots, 0);
+    targetRows.assign(state.stride, 0);
+    forcedTakes.assign(state.stride, 0);
+    takenPenalty.assign(state.stride, 0);
+
+    dealGames();
+}
+
+void BatchEngine::dealGames() {
+    std::array<uint8_t, DECK_SIZE> deck;
+
+    for (int game = 0; game < state.numGames; ++game) {
+        // Same stream and shuffle as Game, so deck order matches exactly
+        std::iota(deck.begin(), deck.end(), 1);
+        Rng rng(deriveSeed(state.seeds[game], 0));
+        shuffleRange(deck.begin(), deck.end(), rng);
+
+        int cardIndex = 0;
+        for (int seat = 0; seat < state.numPlayers; ++seat) {
+            CardSet hand;
+            for (int card = 0; card < HAND_SIZE; ++card) {
+                hand.insert(deck[cardIndex++]);
+            }
+            size_t i = state.at(seat, game);
+            state.handLow[i] = hand.low();
+            state.handHigh[i] = hand.high();
+        }
+
+        for (int row = 0; row < NUM_ROWS; ++row) {
+            int number = deck[cardIndex++];
+            state.rowTail[row][game] = static_cast<uint8_t>(number);
+            state.rowLength[row][game] = 1;
+            state.rowPenalty[row][game] = BULL_HEADS[number];
+        }
+    }
+
+    for (int seat = 0; seat < state.numPlayers; ++seat) {
+        policies[seat]->initialize(state, seat);
+    }
+}
+
+void BatchEngine::playGames() {
+    for (int round = 1; round <= HAND_SIZE; ++round) {
+        playRound();
+    }
+}
+
+void BatchEngine::playRound() {
+    int numPlayers = state.numPlayers;
+    int stride = state.stride;
+
+    for (int seat = 0; seat < numPlayers; ++seat) {
+        uint8_t* cards = playedCards.data() + state.at(seat, 0);
+        policies[seat]->chooseCards(state, seat, cards);
+        for (int game = 0; game < state.numGames; ++game) {
+            CardSet hand = handOf(state, seat, game);
+            assert(hand.contains(cards[game]));
+            hand.erase(cards[game]);
+            size_t i = state.at(seat, game);
+            state.handLow[i] = hand.low();
+            state.handHigh[i] = hand.high();
+        }
+    }
+
+    // Per game, order the played cards by insertion sort (at most 10 cards)
+    for (int game = 0; game < state.numGames; ++game) {
+        for (int seat = 0; seat < numPlayers; ++seat) {
+            uint8_t card = playedCards[state.at(seat, game)];
+            int k = seat;
+            while (k > 0 && sortedCards[state.at(k - 1, game)] > card) {
+                sortedCards[state.at(k, game)] = sortedCards[state.at(k - 1, game)];
+                sortedSeats[state.at(k, game)] = sortedSeats[state.at(k - 1, game)];
+                k--;
+            }
+            sortedCards[state.at(k, game)] = card;
+            sortedSeats[state.at(k, game)] = static_cast<uint8_t>(seat);
+        }
+    }
+
+    // Resolve the k-th lowest card of every game at once
+    for (int k = 0; k < numPlayers; ++k) {
+        const uint8_t* cards = sortedCards.data() + static_cast<size_t>(k) * stride;
+        const uint8_t* seats = sortedSeats.data() + static_cast<size_t>(k) * stride;
+
+        findBestRows(state, cards, targetRows.data());
+
+        for (int game = 0; game < state.numGames; ++game) {
+            if (targetRows[game] < 0) {
+                int row = policies[seats[game]]->chooseRowToTake(state, seats[game], game);
+                assert(row >= 0 && row < NUM_ROWS);
+                targetRows[game] = static_cast<int8_t>(row);
+                forcedTakes[game] = 0xFF;
+            } else {
+                forcedTakes[game] = 0;
+            }
+        }
+        // Padding lanes keep row 0 and are never scored
+        for (int game = state.numGames; game < stride; ++game) {
+            targetRows[game] = 0;
+            forcedTakes[game] = 0;
+        }
+
+        placeCards(state, cards, targetRows.data(), forcedTakes.data(), takenPenalty.data());
+
+        for (int game = 0; game < state.numGames; ++game) {
+            state.scores[state.at(seats[game], game)] += takenPenalty[game];
+        }
+    }
+
+    state.roundNumber++;
+}
+
+} // namespace SixNimmt
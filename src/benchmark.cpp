@@ -0,0 +1,523 @@
+#include "game.h"
+#include "agent_registry.h"
+#include "batch_engine.h"
+#include "monte_carlo_agent.h"
+#include "endgame_agent.h"
+#include "eval_cache.h"
+#include "remote_agent.h"
+#include "plugin_loader.h"
+#include "self_play.h"
+#include "policy_agent.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <sstream>
+
+// Counting allocator hook: every heap allocation in the process goes through
+// these, so the counters around a piece of code give the allocations it made
+namespace {
+std::atomic<long> allocationCount{0};
+std::atomic<long> allocatedBytes{0};
+}
+
+void* operator new(std::size_t size) {
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    allocatedBytes.fetch_add(static_cast<long>(size), std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+namespace SixNimmt {
+
+using Clock = std::chrono::steady_clock;
+
+// Access to Game internals for per-call measurements
+class GameProbe {
+public:
+    static const std::vector<Card>& undealtCards(const Game& game) { return game.deck; }
+    static void processCard(Game& game, const Card& card, int playerId) { game.processCard(card, playerId); }
+};
+
+// Timing samples in nanoseconds, summarized as percentiles
+class Samples {
+private:
+    std::vector<double> values;
+
+public:
+    void add(double nanoseconds) { values.push_back(nanoseconds); }
+
+    double percentile(double p) {
+        if (values.empty()) return 0.0;
+        std::sort(values.begin(), values.end());
+        return values[static_cast<size_t>(p / 100.0 * (values.size() - 1) + 0.5)];
+    }
+
+    std::string toJson() {
+        std::ostringstream out;
+        out << std::fixed << std::setprecision(1)
+            << "{\"p50\": " << percentile(50) << ", \"p90\": " << percentile(90) << ", \"p99\": " << percentile(99)
+            << ", \"max\": " << percentile(100) << ", \"samples\": " << values.size() << "}";
+        return out.str();
+    }
+};
+
+double nanosecondsSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+}
+
+// Deterministic heuristics fill the benchmark seats, alternating
+const std::vector<std::string> HEURISTIC_AGENTS = {"LowestCardFirstAgent", "BullsHeadsFirstAgent"};
+
+std::vector<std::unique_ptr<Player>> makeHeuristicPlayers(int numPlayers) {
+    std::vector<std::unique_ptr<Player>> players;
+    for (int i = 0; i < numPlayers; ++i) {
+        players.push_back(AgentRegistry::instance().create(HEURISTIC_AGENTS[i % HEURISTIC_AGENTS.size()]));
+    }
+    return players;
+}
+
+// Whole games through Game::playGame, timed in blocks of 100 games. The
+// allocation counts include creating the players.
+std::string benchmarkPlayGame(int numPlayers, int numGames) {
+    const int blockSize = 100;
+    Samples nsPerGame;
+    long checksum = 0;
+    long allocations = allocationCount.load();
+    long bytes = allocatedBytes.load();
+    auto start = Clock::now();
+
+    for (int first = 0; first < numGames; first += blockSize) {
+        int last = std::min(numGames, first + blockSize);
+        auto blockStart = Clock::now();
+        for (int gameNum = first; gameNum < last; ++gameNum) {
+            Game game(makeHeuristicPlayers(numPlayers), deriveSeed(numPlayers, gameNum));
+            for (int score : game.playGame(false)) {
+                checksum += score;
+            }
+        }
+        nsPerGame.add(nanosecondsSince(blockStart) / (last - first));
+    }
+
+    double seconds = nanosecondsSince(start) * 1e-9;
+    allocations = allocationCount.load() - allocations;
+    bytes = allocatedBytes.load() - bytes;
+
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(1)
+        << "{\"players\": " << numPlayers
+        << ", \"games_per_sec\": " << numGames / seconds
+        << ", \"ns_per_game\": " << nsPerGame.toJson()
+        << ", \"allocations_per_game\": " << static_cast<double>(allocations) / numGames
+        << ", \"bytes_allocated_per_game\": " << static_cast<double>(bytes) / numGames
+        << ", \"checksum\": " << checksum << "}";
+    return out.str();
+}
+
+// Same matchup played by the batch engine in lockstep batches
+std::string benchmarkBatchEngine(int numPlayers, int numGames, int batchSize = 4096) {
+    long checksum = 0;
+    auto start = Clock::now();
+
+    for (int first = 0; first < numGames; first += batchSize) {
+        std::vector<uint64_t> seeds;
+        for (int gameNum = first; gameNum < std::min(numGames, first + batchSize); ++gameNum) {
+            seeds.push_back(deriveSeed(numPlayers, gameNum));
+        }
+
+        std::vector<std::unique_ptr<BatchPolicy>> policies;
+        for (int i = 0; i < numPlayers; ++i) {
+            policies.push_back(createBatchPolicy(HEURISTIC_AGENTS[i % HEURISTIC_AGENTS.size()]));
+        }
+
+        BatchEngine batch(std::move(policies), seeds);
+        batch.playGames();
+        for (int i = 0; i < numPlayers; ++i) {
+            checksum += batch.getScore(i, 0);
+        }
+    }
+
+    double seconds = nanosecondsSince(start) * 1e-9;
+
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(1)
+        << "{\"players\": " << numPlayers << ", \"batch_size\": " << batchSize
+        << ", \"games_per_sec\": " << numGames / seconds << ", \"checksum\": " << checksum << "}";
+    return out.str();
+}
+
+// Engine calls on fresh 2-player games. A single call is shorter than the
+// clock resolution, so each sample is the mean over a run of calls.
+std::string benchmarkEngineCalls(int numGames) {
+    Samples getGameState;
+    Samples findBestRow;
+    Samples processCard;
+    long checksum = 0;
+
+    for (int gameNum = 0; gameNum < numGames; ++gameNum) {
+        Game game(makeHeuristicPlayers(2), deriveSeed(0, gameNum));
+
+        // Copying the state, as an agent that keeps it would
+        const int repeats = 64;
+        auto start = Clock::now();
+        for (int i = 0; i < repeats; ++i) {
+            GameState copy = game.getGameState();
+            checksum += copy.rows[i % NUM_ROWS].tail;
+        }
+        getGameState.add(nanosecondsSince(start) / repeats);
+
+        // The 80 cards left in the deck after the deal
+        std::vector<Card> undealt = GameProbe::undealtCards(game);
+
+        start = Clock::now();
+        for (const Card& card : undealt) {
+            checksum += SixNimmt::findBestRow(game.getGameState(), card.number);
+        }
+        findBestRow.add(nanosecondsSince(start) / undealt.size());
+
+        // Place 40 of them, with the forced takes and 6th-card takes they cause
+        const int numPlaced = 40;
+        start = Clock::now();
+        for (int i = 0; i < numPlaced; ++i) {
+            GameProbe::processCard(game, undealt[i], i % 2);
+        }
+        processCard.add(nanosecondsSince(start) / numPlaced);
+        checksum += game.getGameState().scores[0];
+    }
+
+    std::ostringstream out;
+    out << "{\"getGameState\": " << getGameState.toJson()
+        << ", \"findBestRow\": " << findBestRow.toJson()
+        << ", \"processCard\": " << processCard.toJson()
+        << ", \"checksum\": " << checksum << "}";
+    return out.str();
+}
+
+// Seats an agent and times each of its chooseCard calls
+class TimedPlayer : public Player {
+private:
+    std::unique_ptr<Player> agent;
+    Samples& samples;
+
+public:
+    TimedPlayer(std::unique_ptr<Player> agent, Samples& samples) : agent(std::move(agent)), samples(samples) {}
+
+    void seed(uint64_t seed) override {
+        agent->seed(seed);
+    }
+
+    void initialize(int playerId, int numPlayers, const std::vector<Card>& initialHand) override {
+        hand = initialHand;
+        agent->initialize(playerId, numPlayers, initialHand);
+    }
+
+    int chooseCard(const GameState& state) override {
+        auto start = Clock::now();
+        int index = agent->chooseCard(state);
+        samples.add(nanosecondsSince(start));
+        agent->removeCard(index);
+        return index;
+    }
+
+    int chooseRowToTake(const GameState& state) override {
+        return agent->chooseRowToTake(state);
+    }
+
+    void onGameStart(const GameState& state) override { agent->onGameStart(state); }
+    void onCardsRevealed(const GameState& state) override { agent->onCardsRevealed(state); }
+    void onRowTaken(const GameState& state, int seat, int row, const Row& taken) override {
+        agent->onRowTaken(state, seat, row, taken);
+    }
+    void onRoundEnd(const GameState& state) override { agent->onRoundEnd(state); }
+    void onMoveReplaced(const GameState& state, int choice) override { agent->onMoveReplaced(state, choice); }
+
+    std::string getName() const override {
+        return agent->getName();
+    }
+};
+
+// chooseCard latency of every registered agent in seat 0 of a 4-player game
+std::string benchmarkChooseCard(int numGames) {
+    std::ostringstream out;
+    out << "{";
+
+    const char* separator = "";
+    for (const std::string& name : AgentRegistry::instance().names()) {
+        // Search agents take milliseconds per move; fewer games suffice
+        int games = name == "MonteCarloAgent" ? std::max(1, numGames / 500) : numGames;
+
+        Samples samples;
+        for (int gameNum = 0; gameNum < games; ++gameNum) {
+            std::vector<std::unique_ptr<Player>> players = makeHeuristicPlayers(4);
+            players[0] = std::make_unique<TimedPlayer>(AgentRegistry::instance().create(name), samples);
+            Game(std::move(players), deriveSeed(1, gameNum)).playGame(false);
+        }
+
+        out << separator << "\"" << name << "\": " << samples.toJson();
+        separator = ", ";
+    }
+
+    out << "}";
+    return out.str();
+}
+
+// Playout throughput of a single-threaded MonteCarloAgent against heuristics
+std::string benchmarkPlayouts(int numPlayers, int numGames) {
+    double playoutsPerSecond = 0.0;
+    for (int gameNum = 0; gameNum < numGames; ++gameNum) {
+        std::vector<std::unique_ptr<Player>> players = makeHeuristicPlayers(numPlayers);
+        players[0] = std::make_unique<MonteCarloAgent>();
+
+        Game game(std::move(players), deriveSeed(numPlayers, gameNum));
+        game.playGame(false);
+        playoutsPerSecond += static_cast<MonteCarloAgent&>(*game.releasePlayers()[0]).getPlayoutsPerSecond();
+    }
+
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(1)
+        << "{\"players\": " << numPlayers << ", \"playouts_per_sec\": " << playoutsPerSecond / numGames << "}";
+    return out.str();
+}
+
+// Endgame solver throughput in 2-player games against a heuristic
+std::string benchmarkEndgameSolver(int numGames) {
+    long nodes = 0;
+    long moves = 0;
+    double nodesPerSecond = 0.0;
+    double hitRate = 0.0;
+    double solveMicroseconds = 0.0;
+    for (int gameNum = 0; gameNum < numGames; ++gameNum) {
+        std::vector<std::unique_ptr<Player>> players = makeHeuristicPlayers(2);
+        players[0] = std::make_unique<EndgameSolverAgent>();
+
+        Game game(std::move(players), deriveSeed(2, gameNum));
+        game.playGame(false);
+        const auto& agent = static_cast<const EndgameSolverAgent&>(*game.releasePlayers()[0]);
+        nodes += agent.getNodes();
+        moves += agent.getSolvedMoves();
+        nodesPerSecond += agent.getNodesPerSecond();
+        hitRate += agent.getHitRate();
+        solveMicroseconds += agent.getAverageSolveMicroseconds();
+    }
+
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(1)
+        << "{\"nodes_per_move\": " << static_cast<double>(nodes) / moves
+        << ", \"nodes_per_sec\": " << nodesPerSecond / numGames
+        << ", \"hit_rate\": " << std::setprecision(3) << hitRate / numGames
+        << ", \"us_per_move\": " << std::setprecision(1) << solveMicroseconds / numGames << "}";
+    return out.str();
+}
+
+// Shared EvalCache under concurrent load: every worker looks keys up from a
+// working set twice the capacity and stores its misses, so about half the
+// lookups can hit. Then the hit rate a shared cache gives MonteCarloAgent
+// when it plays every deal twice, against each heuristic: the positions
+// repeat until the opponents' different play makes them diverge.
+std::string benchmarkEvalCache(int numThreads, int opsPerThread, int numDeals) {
+    EvalCache cache(size_t(1) << 20);
+    const uint64_t workingSet = 2 * cache.capacity();
+
+    ThreadPool pool(numThreads);
+    auto start = Clock::now();
+    pool.parallelFor(pool.size(), [&](int /*worker*/, size_t task) {
+        Rng rng(deriveSeed(18, task));
+        EvalValues values{};
+        for (int op = 0; op < opsPerThread; ++op) {
+            EvalKey key;
+            key.context = rng.below(workingSet);
+            if (!cache.lookup(key, values)) cache.store(key, values);
+        }
+    });
+    double nanosecondsPerOp = nanosecondsSince(start) / (static_cast<double>(pool.size()) * opsPerThread);
+    EvalCache::Stats stats = cache.getStats();
+
+    auto shared = std::make_shared<EvalCache>(size_t(16) << 20);
+    for (int deal = 0; deal < numDeals; ++deal) {
+        for (const std::string& opponent : HEURISTIC_AGENTS) {
+            std::vector<std::unique_ptr<Player>> players;
+            players.push_back(std::make_unique<MonteCarloAgent>(200, std::chrono::microseconds(0), 1, shared));
+            players.push_back(AgentRegistry::instance().create(opponent));
+            Game(std::move(players), deriveSeed(19, deal)).playGame(false);
+        }
+    }
+
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(1) << "{\"threads\": " << pool.size()
+        << ", \"capacity\": " << stats.capacity << ", \"ns_per_op\": " << nanosecondsPerOp
+        << ", \"hit_rate\": " << std::setprecision(3) << stats.hitRate()
+        << ", \"evictions\": " << stats.evictions
+        << ", \"monte_carlo_duplicate_hit_rate\": " << shared->getStats().hitRate() << "}";
+    return out.str();
+}
+
+// PolicyAgent's chooseCard with the AVX2 and the scalar forward pass, next
+// to LowestCardFirstAgent's as the floor, in seat 0 of a 4-player game
+std::string benchmarkPolicyAgent(int numGames) {
+    auto timeAgent = [&](auto makeAgent) {
+        Samples samples;
+        for (int gameNum = 0; gameNum < numGames; ++gameNum) {
+            std::vector<std::unique_ptr<Player>> players = makeHeuristicPlayers(4);
+            players[0] = std::make_unique<TimedPlayer>(makeAgent(), samples);
+            Game(std::move(players), deriveSeed(1, gameNum)).playGame(false);
+        }
+        return samples.toJson();
+    };
+
+    std::ostringstream out;
+    out << "{\"avx2\": " << (policyHasAvx2() ? "true" : "false") << ", \"lowest_card_first_ns\": "
+        << timeAgent([] { return AgentRegistry::instance().create("LowestCardFirstAgent"); })
+        << ", \"policy_avx2_ns\": " << timeAgent([] { return std::make_unique<PolicyAgent>(); })
+        << ", \"policy_scalar_ns\": " << timeAgent([] {
+               auto agent = std::make_unique<PolicyAgent>();
+               agent->setUseAvx2(false);
+               return agent;
+           })
+        << "}";
+    return out.str();
+}
+
+// Self-play data generation with the heuristic agents on one thread, files
+// written to a temporary directory by the background writer
+std::string benchmarkSelfPlay(int numPlayers, int numGames) {
+    char directory[] = "/tmp/sixnimmt_bench_XXXXXX";
+    if (!mkdtemp(directory)) return "null";
+
+    SelfPlaySettings settings;
+    settings.agents = {"RandomAgent", "LowestCardFirstAgent", "HighestCardFirstAgent", "BullsHeadsFirstAgent"};
+    settings.numPlayers = numPlayers;
+    settings.numGames = numGames;
+    settings.gamesPerChunk = std::max(1, numGames / 4);
+    settings.numThreads = 1;
+    settings.seed = 1;
+    settings.outputPrefix = std::string(directory) + "/bench";
+
+    auto start = Clock::now();
+    SelfPlaySummary summary = generateSelfPlay(settings);
+    double seconds = nanosecondsSince(start) / 1e9;
+    for (const std::string& path : summary.files) std::remove(path.c_str());
+    std::remove(directory);
+
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(1) << "{\"players\": " << numPlayers
+        << ", \"games_per_sec\": " << summary.games / seconds
+        << ", \"decisions_per_sec\": " << summary.decisions / seconds
+        << ", \"mb_per_sec\": " << summary.decisions * sizeof(SelfPlayRecord) / seconds / 1e6 << "}";
+    return out.str();
+}
+
+// LowestCardFirstAgent served by a host process against a local copy: one
+// round trip per decision through Game, against one per seat and round for
+// a whole batch through BatchEngine
+std::string benchmarkRemoteAgent(const std::string& hostPath, int numGames) {
+    auto connection = std::make_shared<AgentConnection>(hostPath, "LowestCardFirstAgent");
+
+    auto start = Clock::now();
+    for (int game = 0; game < numGames; ++game) {
+        std::vector<std::unique_ptr<Player>> players;
+        players.push_back(std::make_unique<RemoteAgent>(connection));
+        players.push_back(AgentRegistry::instance().create("LowestCardFirstAgent"));
+        Game(std::move(players), deriveSeed(21, game)).playGame(false);
+    }
+    double gameSeconds = nanosecondsSince(start) / 1e9;
+    long gameRoundTrips = connection->getRoundTrips();
+    long gameRequests = connection->getRequests();
+
+    std::vector<uint64_t> seeds;
+    for (int game = 0; game < numGames; ++game) seeds.push_back(deriveSeed(21, game));
+    std::vector<std::unique_ptr<BatchPolicy>> policies;
+    policies.push_back(std::make_unique<RemoteBatchPolicy>(connection));
+    policies.push_back(createBatchPolicy("LowestCardFirstAgent"));
+    start = Clock::now();
+    BatchEngine batch(std::move(policies), seeds);
+    batch.playGames();
+    double batchSeconds = nanosecondsSince(start) / 1e9;
+
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(0) << "{\"game_games_per_sec\": " << numGames / gameSeconds
+        << ", \"game_us_per_round_trip\": " << std::setprecision(2) << gameSeconds * 1e6 / gameRoundTrips
+        << ", \"game_requests_per_round_trip\": " << std::setprecision(1)
+        << static_cast<double>(gameRequests) / gameRoundTrips
+        << ", \"batch_games_per_sec\": " << std::setprecision(0) << numGames / batchSeconds
+        << ", \"batch_requests_per_round_trip\": " << std::setprecision(1)
+        << static_cast<double>(connection->getRequests() - gameRequests) / (connection->getRoundTrips() - gameRoundTrips)
+        << "}";
+    return out.str();
+}
+
+// Cost of one clock read; every chooseCard sample includes it
+double timerOverheadNanoseconds() {
+    const int repeats = 100000;
+    auto start = Clock::now();
+    for (int i = 0; i < repeats; ++i) {
+        auto now = Clock::now();
+        (void)now;
+    }
+    return nanosecondsSince(start) / repeats;
+}
+
+} // namespace SixNimmt
+
+// Prints a single JSON document so results can be diffed between commits.
+// Usage: sixnimmt_bench [gamesPerConfiguration]
+int main(int argc, char* argv[]) {
+    using namespace SixNimmt;
+
+    int numGames = argc > 1 ? std::atoi(argv[1]) : 20000;
+    if (numGames <= 0) {
+        std::cerr << "Usage: " << argv[0] << " [gamesPerConfiguration]" << std::endl;
+        return 1;
+    }
+
+    // The example plugin's agents join choose_card_ns, next to the built-in
+    // agents they mirror
+    try {
+        loadAgentPlugins(defaultPluginDirectory(argv[0]));
+    } catch (const std::invalid_argument& e) {
+        std::cerr << argv[0] << ": " << e.what() << std::endl;
+    }
+
+    std::cout << "{\n";
+    std::cout << "  \"games_per_configuration\": " << numGames << ",\n";
+    // Instrumented builds (SIXNIMMT_INSTRUMENT) are slower; flag them so their numbers are not compared
+    std::cout << "  \"instrumented\": " << (Instrument::ENABLED ? "true" : "false") << ",\n";
+    std::cout << std::fixed << std::setprecision(1) << "  \"timer_overhead_ns\": " << timerOverheadNanoseconds() << ",\n";
+
+    std::cout << "  \"play_game\": [\n";
+    for (int numPlayers = 2; numPlayers <= MAX_PLAYERS; ++numPlayers) {
+        std::cout << "    " << benchmarkPlayGame(numPlayers, numGames) << (numPlayers < MAX_PLAYERS ? ",\n" : "\n");
+    }
+    std::cout << "  ],\n";
+
+    std::cout << "  \"batch_engine\": [\n";
+    for (int numPlayers = 2; numPlayers <= MAX_PLAYERS; ++numPlayers) {
+        std::cout << "    " << benchmarkBatchEngine(numPlayers, numGames) << (numPlayers < MAX_PLAYERS ? ",\n" : "\n");
+    }
+    std::cout << "  ],\n";
+
+    std::cout << "  \"engine_calls_ns\": " << benchmarkEngineCalls(std::max(1, numGames / 10)) << ",\n";
+    std::cout << "  \"choose_card_ns\": " << benchmarkChooseCard(std::max(1, numGames / 10)) << ",\n";
+
+    std::cout << "  \"monte_carlo\": [\n";
+    std::cout << "    " << benchmarkPlayouts(2, 10) << ",\n";
+    std::cout << "    " << benchmarkPlayouts(4, 10) << ",\n";
+    std::cout << "    " << benchmarkPlayouts(10, 10) << "\n";
+    std::cout << "  ],\n";
+
+    std::cout << "  \"endgame_solver\": " << benchmarkEndgameSolver(20) << ",\n";
+    std::cout << "  \"eval_cache\": " << benchmarkEvalCache(4, std::max(1000, numGames * 10), 10) << ",\n";
+    std::cout << "  \"policy_agent\": " << benchmarkPolicyAgent(std::max(1, numGames / 10)) << ",\n";
+    std::cout << "  \"self_play\": " << benchmarkSelfPlay(4, numGames) << ",\n";
+    std::cout << "  \"remote_agent\": " << benchmarkRemoteAgent(defaultAgentHostPath(argv[0]), numGames) << "\n";
+    std::cout << "}" << std::endl;
+
+    return 0;
+}
@@ -1,4 +1,5 @@
 #include "game.h"
+#include "agent_registry.h"
 #include <algorithm>
 
 namespace SixNimmt {
@@ -16,18 +17,16 @@ public:
     }
 
     int chooseCard(const GameState& state) override {
-        // Find the card with the most bull heads in our hand
-        int maxBullsIndex = 0;
-        int maxBulls = hand[0].bullHeads;
-
-        for (int i = 1; i < hand.size(); ++i) {
-            if (hand[i].bullHeads > maxBulls) {
-                maxBulls = hand[i].bullHeads;
-                maxBullsIndex = i;
+        // Find the card with the most bull heads in our hand, checking the
+        // penalty classes from the top; the lowest such card wins ties
+        for (int bullHeads : {7, 5, 3, 2}) {
+            CardSet candidates = hand & BULL_HEAD_CLASSES[bullHeads];
+            if (!candidates.empty()) {
+                return hand.rank(candidates.lowest());
             }
         }
 
-        return maxBullsIndex;
+        return 0;
     }
 
     std::string getName() const override {
@@ -35,4 +34,6 @@ public:
     }
 };
 
+SIXNIMMT_REGISTER_AGENT(BullsHeadsFirstAgent);
+
 } // namespace SixNimmt
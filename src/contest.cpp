@@ -1,185 +1,254 @@
 #include "game.h"
-#include "random_agent.cpp"
-#include "lowest_card_first_agent.cpp"
-#include "highest_card_first_agent.cpp"
-#include "bulls_heads_first_agent.cpp"
+#include "agent_registry.h"
+#include "tournament.h"
+#include "remote_agent.h"
+#include "plugin_loader.h"
+#include "policy_agent.h"
 #include <iostream>
 #include <vector>
 #include <memory>
-#include <iomanip>
 #include <algorithm>
-#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <chrono>
+#include <fstream>
 
 namespace SixNimmt {
 
-class Contest {
-private:
-    std::vector<std::unique_ptr<Player>> players;
-    std::map<std::string, int> wins;
-    std::map<std::string, int> totalScore;
-    std::map<std::string, int> gamesPlayed;
+void runSingleGame(std::vector<std::unique_ptr<Player>> players, bool verbose = true) {
+    if (players.empty()) {
+        std::cout << "No players added!" << std::endl;
+        return;
+    }
+
+    // Play the game
+    Game game(std::move(players));
+    std::vector<int> scores = game.playGame(verbose);
 
-public:
-    void addPlayer(std::unique_ptr<Player> player) {
-        players.push_back(std::move(player));
+    // Show results
+    std::cout << "\n=== Final Results ===" << std::endl;
+    std::vector<std::pair<std::string, int>> results;
+    for (int i = 0; i < scores.size(); ++i) {
+        results.emplace_back("Player " + std::to_string(i), scores[i]);
     }
 
-    void runTournament(int gamesPerMatchup = 100) {
-        std::cout << "Starting \"6 nimmt!\" Tournament" << std::endl;
-        std::cout << "Players: " << players.size() << std::endl;
-        std::cout << "Games per matchup: " << gamesPerMatchup << std::endl;
-        std::cout << std::string(50, '=') << std::endl;
-
-        // Initialize statistics
-        for (const auto& player : players) {
-            wins[player->getName()] = 0;
-            totalScore[player->getName()] = 0;
-            gamesPlayed[player->getName()] = 0;
-        }
+    std::sort(results.begin(), results.end(),
+             [](const auto& a, const auto& b) { return a.second < b.second; });
 
-        // Play round-robin tournament
-        for (int i = 0; i < players.size(); ++i) {
-            for (int j = i + 1; j < players.size(); ++j) {
-                std::cout << "\n" << players[i]->getName() << " vs " << players[j]->getName() << std::endl;
-
-                int player1Wins = 0;
-                int player2Wins = 0;
-
-                for (int gameNum = 0; gameNum < gamesPerMatchup; ++gameNum) {
-                    std::vector<std::unique_ptr<Player>> gamePlayers;
-
-                    // Might need a clone method
-                    // For now, let's create new instances
-                    if (players[i]->getName() == "RandomAgent") {
-                        gamePlayers.push_back(std::make_unique<RandomAgent>());
-                    } else if (players[i]->getName() == "LowestCardFirstAgent") {
-                        gamePlayers.push_back(std::make_unique<LowestCardFirstAgent>());
-                    } else if (players[i]->getName() == "HighestCardFirstAgent") {
-                        gamePlayers.push_back(std::make_unique<HighestCardFirstAgent>());
-                    } else if (players[i]->getName() == "BullsHeadsFirstAgent") {
-                        gamePlayers.push_back(std::make_unique<BullsHeadsFirstAgent>());
-                    }
-
-                    if (players[j]->getName() == "RandomAgent") {
-                        gamePlayers.push_back(std::make_unique<RandomAgent>());
-                    } else if (players[j]->getName() == "LowestCardFirstAgent") {
-                        gamePlayers.push_back(std::make_unique<LowestCardFirstAgent>());
-                    } else if (players[j]->getName() == "HighestCardFirstAgent") {
-                        gamePlayers.push_back(std::make_unique<HighestCardFirstAgent>());
-                    } else if (players[j]->getName() == "BullsHeadsFirstAgent") {
-                        gamePlayers.push_back(std::make_unique<BullsHeadsFirstAgent>());
-                    }
-
-                    // Initialize players (hands will be set by game)
-                    gamePlayers[0]->initialize(0, 2, {});
-                    gamePlayers[1]->initialize(1, 2, {});
-
-                    // Play game
-                    Game game(std::move(gamePlayers));
-                    std::vector<int> scores = game.playGame(false);
-
-                    // Update statistics
-                    totalScore[players[i]->getName()] += scores[0];
-                    totalScore[players[j]->getName()] += scores[1];
-                    gamesPlayed[players[i]->getName()]++;
-                    gamesPlayed[players[j]->getName()]++;
-
-                    if (scores[0] < scores[1]) {
-                        wins[players[i]->getName()]++;
-                        player1Wins++;
-                    } else if (scores[1] < scores[0]) {
-                        wins[players[j]->getName()]++;
-                        player2Wins++;
-                    }
-                    // Tie - no winner
-                }
+    for (int i = 0; i < results.size(); ++i) {
+        std::cout << (i + 1) << ". " << results[i].first
+                 << ": " << results[i].second << " points" << std::endl;
+    }
+}
 
-                std::cout << "  " << players[i]->getName() << ": " << player1Wins << " wins" << std::endl;
-                std::cout << "  " << players[j]->getName() << ": " << player2Wins << " wins" << std::endl;
-            }
-        }
+void printUsage(const char* program) {
+    std::cout << "Usage: " << program << " [options]\n"
+              << "Without options the contest asks interactively what to run.\n\n"
+              << "  --agents A,B,...   Registered agents to include (default: all); remote:NAME runs\n"
+              << "                     NAME in its own sixnimmt_agent_host process, policy:FILE runs\n"
+              << "                     PolicyAgent with the weights in FILE\n"
+              << "  --agent-host PATH  Host program for remote agents (default: next to this one)\n"
+              << "  --plugins DIR      Load the agent plugins (.so files) in DIR; their agents join\n"
+              << "                     the registered ones (give it before --list)\n"
+              << "  --games N          Games per table (default: 100)\n"
+              << "  --seats N          2 plays a round-robin of pairs, 3-10 one free-for-all\n"
+              << "                     table with seat rotation (default: 2)\n"
+              << "  --seed S           Tournament seed (default: random)\n"
+              << "  --threads N        Worker threads, 0 = all hardware threads (default: 0)\n"
+              << "  --format F         table, csv, json or shard (default: table)\n"
+              << "  --duplicate        Replay every deal with the agents rotated through all seats\n"
+              << "                     and report paired score margins\n"
+              << "  --sprt DELTA       Stop a pairing once SPRTs find one agent winning 0.5 + DELTA\n"
+              << "                     of the decisive games, or no difference of DELTA either way;\n"
+              << "                     --games becomes the average budget per pairing\n"
+              << "  --sprt-error E     Error rate alpha = beta of the SPRT (default: 0.05)\n"
+              << "  --shard FIRST:END  Play only deals [FIRST, END) of the schedule (tables in order,\n"
+              << "                     deals per table = games, or games / seats with --duplicate);\n"
+              << "                     write the shards with --format shard and combine them with\n"
+              << "                     sixnimmt_merge\n"
+              << "  --stats            Report Elo-scale ratings, score distributions, head-to-head\n"
+              << "                     results and bootstrap confidence intervals\n"
+              << "  --bootstrap N      Bootstrap replicates for --stats (default: 100)\n"
+              << "  --time-moves       Report chooseCard / chooseRowToTake latency per agent\n"
+              << "  --move-limit MS    After a decision took over MS milliseconds, play the default\n"
+              << "                     move (lowest card, cheapest row) instead; the call is not cut\n"
+              << "                     short, so a hung agent still stalls; implies --time-moves\n"
+              << "  --profile          Print time spent per engine probe to stderr\n"
+              << "  --trace FILE       Write a Chrome trace (chrome://tracing, Perfetto) of the run;\n"
+              << "                     both need a build with -DSIXNIMMT_INSTRUMENT=ON\n"
+              << "  --list             Print the registered agents and exit\n"
+              << "  --help             Print this message\n";
+}
 
-        printResults();
+std::vector<std::string> splitList(const std::string& text) {
+    std::vector<std::string> items;
+    std::stringstream stream(text);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        if (!item.empty()) items.push_back(item);
     }
+    return items;
+}
 
-    void runSingleGame(bool verbose = true) {
-        if (players.empty()) {
-            std::cout << "No players added!" << std::endl;
-            return;
-        }
+// Command-line mode; returns the process exit code
+int runCommandLine(int argc, char* argv[]) {
+    std::vector<std::string> agents;
+    bool allAgents = true;
+    int gamesPerTable = 100;
+    int numSeats = 2;
+    int numThreads = 0;
+    uint64_t seed = randomSeed();
+    OutputFormat format = OutputFormat::Table;
+    bool earlyStopping = false;
+    SprtSettings sprt;
+    bool duplicate = false;
+    bool timeMoves = false;
+    double moveLimitMilliseconds = 0.0;
+    bool profile = false;
+    std::string tracePath;
+    bool statistics = false;
+    int bootstrapReplicates = 100;
+    std::string agentHostPath = defaultAgentHostPath(argv[0]);
+    long shardFirst = 0;
+    long shardEnd = -1;   // -1 = the whole schedule
+
+    try {
+        for (int i = 1; i < argc; ++i) {
+            std::string option = argv[i];
+            if (option == "--help") {
+                printUsage(argv[0]);
+                return 0;
+            }
+            if (option == "--duplicate") {
+                duplicate = true;
+                continue;
+            }
+            if (option == "--profile") {
+                profile = true;
+                continue;
+            }
+            if (option == "--stats") {
+                statistics = true;
+                continue;
+            }
+            if (option == "--time-moves") {
+                timeMoves = true;
+                continue;
+            }
+            if (option == "--list") {
+                for (const std::string& name : AgentRegistry::instance().names()) {
+                    std::cout << name << std::endl;
+                }
+                return 0;
+            }
 
-        // Initialize all players (hands will be set by game)
-        for (int i = 0; i < players.size(); ++i) {
-            players[i]->initialize(i, players.size(), {});
+            if (i + 1 >= argc) throw std::invalid_argument("missing value for " + option);
+            std::string value = argv[++i];
+
+            if (option == "--agents") {
+                agents = splitList(value);
+                allAgents = false;
+            } else if (option == "--plugins") {
+                loadAgentPlugins(value);
+            } else if (option == "--agent-host") {
+                agentHostPath = value;
+            } else if (option == "--games") {
+                gamesPerTable = std::stoi(value);
+            } else if (option == "--seats") {
+                numSeats = std::stoi(value);
+            } else if (option == "--seed") {
+                seed = std::stoull(value);
+            } else if (option == "--threads") {
+                numThreads = std::stoi(value);
+            } else if (option == "--format") {
+                if (!parseOutputFormat(value, format)) throw std::invalid_argument("unknown format " + value);
+            } else if (option == "--sprt") {
+                earlyStopping = true;
+                sprt.delta = std::stod(value);
+            } else if (option == "--sprt-error") {
+                sprt.alpha = sprt.beta = std::stod(value);
+            } else if (option == "--bootstrap") {
+                statistics = true;
+                bootstrapReplicates = std::stoi(value);
+            } else if (option == "--shard") {
+                size_t colon = value.find(':');
+                if (colon == std::string::npos) throw std::invalid_argument("--shard needs FIRST:END");
+                shardFirst = std::stol(value.substr(0, colon));
+                shardEnd = std::stol(value.substr(colon + 1));
+            } else if (option == "--trace") {
+                tracePath = value;
+            } else if (option == "--move-limit") {
+                timeMoves = true;
+                moveLimitMilliseconds = std::stod(value);
+            } else {
+                throw std::invalid_argument("unknown option " + option);
+            }
         }
 
-        // Play the game
-        Game game(std::move(players));
-        std::vector<int> scores = game.playGame(verbose);
+        if (allAgents) agents = AgentRegistry::instance().names();
 
-        // Show results
-        std::cout << "\n=== Final Results ===" << std::endl;
-        std::vector<std::pair<std::string, int>> results;
-        for (int i = 0; i < scores.size(); ++i) {
-            results.emplace_back("Player " + std::to_string(i), scores[i]);
+        Tournament tournament;
+        for (const std::string& name : agents) {
+            if (name.compare(0, 7, "remote:") == 0) {
+                // One host process per remote agent; its clones share it
+                auto connection = std::make_shared<AgentConnection>(agentHostPath, name.substr(7));
+                tournament.addPlayer(std::make_unique<RemoteAgent>(connection));
+                continue;
+            }
+            if (name.compare(0, 7, "policy:") == 0) {
+                tournament.addPlayer(loadPolicyAgent(name.substr(7)));
+                continue;
+            }
+            std::unique_ptr<Player> player = AgentRegistry::instance().create(name);
+            if (!player) throw std::invalid_argument("unknown agent " + name + " (see --list)");
+            tournament.addPlayer(std::move(player));
         }
-
-        std::sort(results.begin(), results.end(), 
-                 [](const auto& a, const auto& b) { return a.second < b.second; });
-        
-        for (int i = 0; i < results.size(); ++i) {
-            std::cout << (i + 1) << ". " << results[i].first 
-                     << ": " << results[i].second << " points" << std::endl;
+        if (earlyStopping) {
+            tournament.setEarlyStopping(sprt);
         }
-    }
-    
-private:
-    void printResults() {
-        std::cout << "\n" << std::string(50, '=') << std::endl;
-        std::cout << "TOURNAMENT RESULTS" << std::endl;
-        std::cout << std::string(50, '=') << std::endl;
-
-        // Sort by win rate
-        std::vector<std::pair<std::string, double>> standings;
-        for (const auto& player : players) {
-            const std::string& name = player->getName();
-            double winRate = (double)wins[name] / gamesPlayed[name] * 100.0;
-            standings.emplace_back(name, winRate);
+        tournament.setDuplicate(duplicate);
+        if (statistics) {
+            tournament.setStatistics(bootstrapReplicates);
+        }
+        if (shardEnd >= 0) {
+            tournament.setShard(shardFirst, shardEnd);
+        }
+        if (timeMoves) {
+            tournament.setDecisionTiming(std::chrono::nanoseconds(static_cast<long long>(moveLimitMilliseconds * 1e6)));
         }
 
-        std::sort(standings.begin(), standings.end(), 
-                 [](const auto& a, const auto& b) { return a.second > b.second; });
-        
-        std::cout << std::left << std::setw(15) << "Player" 
-                  << std::setw(10) << "Wins" 
-                  << std::setw(12) << "Win Rate" 
-                  << std::setw(12) << "Avg Score" << std::endl;
-        std::cout << std::string(50, '-') << std::endl;
-
-        for (const auto& standing : standings) {
-            const std::string& name = standing.first;
-            std::cout << std::left << std::setw(15) << name
-                      << std::setw(10) << wins[name]
-                      << std::setw(12) << std::fixed << std::setprecision(1) 
-                      << (double)wins[name] / gamesPlayed[name] * 100.0 << "%"
-                      << std::setw(12) << std::fixed << std::setprecision(1)
-                      << (double)totalScore[name] / gamesPlayed[name] << std::endl;
+        if ((profile || !tracePath.empty()) && !Instrument::ENABLED) {
+            throw std::invalid_argument("--profile and --trace need a build with -DSIXNIMMT_INSTRUMENT=ON");
         }
+        std::ofstream trace;
+        if (!tracePath.empty()) {
+            trace.open(tracePath);
+            if (!trace) throw std::invalid_argument("cannot write " + tracePath);
+            Instrument::startTrace();
+        }
+
+        TournamentResult result = tournament.run(numSeats, gamesPerTable, numThreads, seed);
+        Instrument::stopTrace();
+        writeResults(std::cout, result, format);
+
+        if (profile) Instrument::writeSummary(std::cerr);
+        if (trace.is_open()) Instrument::writeChromeTrace(trace);
+    } catch (const std::exception& e) {
+        std::cerr << argv[0] << ": " << e.what() << std::endl;
+        std::cerr << "Try " << argv[0] << " --help" << std::endl;
+        return 1;
     }
-};
+    return 0;
+}
 
 } // namespace SixNimmt
 
-int main() {
+int main(int argc, char* argv[]) {
     using namespace SixNimmt;
 
-    Contest contest;
-
-    // Add players
-    contest.addPlayer(std::make_unique<RandomAgent>());
-    contest.addPlayer(std::make_unique<LowestCardFirstAgent>());
-    contest.addPlayer(std::make_unique<HighestCardFirstAgent>());
-    contest.addPlayer(std::make_unique<BullsHeadsFirstAgent>());
+    if (argc > 1) {
+        return runCommandLine(argc, argv);
+    }
 
     std::cout << "\"6 nimmt!\" Contest Framework" << std::endl;
     std::cout << "1. Single game" << std::endl;
@@ -190,9 +259,24 @@ int main() {
     std::cin >> choice;
 
     if (choice == 1) {
-        contest.runSingleGame(true);
+        // Registered agents at one table, as many as it seats
+        std::vector<std::string> names = AgentRegistry::instance().names();
+        if (names.size() > static_cast<size_t>(MAX_PLAYERS)) {
+            std::cout << "Seating the first " << MAX_PLAYERS << " of " << names.size() << " agents" << std::endl;
+            names.resize(MAX_PLAYERS);
+        }
+        std::vector<std::unique_ptr<Player>> players;
+        for (const std::string& name : names) {
+            players.push_back(AgentRegistry::instance().create(name));
+        }
+        runSingleGame(std::move(players), true);
     } else if (choice == 2) {
-        contest.runTournament(50); // 50 games per matchup
+        Tournament tournament;
+        for (const std::string& name : AgentRegistry::instance().names()) {
+            tournament.addPlayer(AgentRegistry::instance().create(name));
+        }
+        // 50 games per matchup, all hardware threads
+        writeResults(std::cout, tournament.run(2, 50, 0), OutputFormat::Table);
     } else {
         std::cout << "Invalid choice!" << std::endl;
     }
@@ -0,0 +1,85 @@
+#include "endgame_agent.h"
+#include "agent_registry.h"
+#include <chrono>
+
+namespace SixNimmt {
+
+void EndgameSolverAgent::initialize(int playerId, int numPlayers, const std::vector<Card>& initialHand) {
+    this->playerId = playerId;
+    this->numPlayers = numPlayers;
+    this->hand = initialHand;
+    movesMade = 0;
+    knowledge.begin(playerId, numPlayers, hand);
+}
+
+int EndgameSolverAgent::chooseCard(const GameState& state) {
+    Rng rng(deriveSeed(agentSeed, movesMade++));
+
+    int index = 0;
+    if (numPlayers == 2 && hand.size() > 1 && hand.size() <= endgameRounds) {
+        index = solve(state, rng);
+    } else if (hand.size() > 1) {
+        index = lowestImmediatePenalty(state);
+    }
+
+    return index;
+}
+
+int EndgameSolverAgent::solve(const GameState& state, Rng& rng) {
+    auto start = std::chrono::steady_clock::now();
+
+    const CardSet& unseen = knowledge.getUnseen();
+    std::array<uint8_t, DECK_SIZE> pile;
+    int pileSize = 0;
+    for (const Card& card : unseen) pile[pileSize++] = static_cast<uint8_t>(card.number);
+
+    std::array<long, HAND_SIZE> totals{};
+    for (int sample = 0; sample < samples; ++sample) {
+        SimState sim;
+        sim.table = state;
+        sim.hands[playerId] = hand;
+        for (int i = 0; i < hand.size(); ++i) {
+            int pick = i + static_cast<int>(rng.below(pileSize - i));
+            std::swap(pile[i], pile[pick]);
+            sim.hands[1 - playerId].insert(pile[i]);
+        }
+
+        std::array<int, HAND_SIZE> values = solver.solveMoves(sim, playerId);
+        for (int i = 0; i < hand.size(); ++i) totals[i] += values[i];
+    }
+
+    int bestIndex = 0;
+    for (int i = 1; i < hand.size(); ++i) {
+        if (totals[i] < totals[bestIndex]) bestIndex = i;
+    }
+
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    solveSeconds += elapsed.count();
+    solvedMoves++;
+    return bestIndex;
+}
+
+int EndgameSolverAgent::lowestImmediatePenalty(const GameState& state) {
+    int bestIndex = 0;
+    int bestPenalty = 1 << 30;
+    int index = 0;
+    for (const Card& card : hand) {
+        int row = findBestRow(state, card.number);
+        int penalty = 0;
+        if (row == -1) {
+            penalty = calculateRowPenalty(state.rows[choseLowestPenaltyRowToTake(state)]);
+        } else if (state.rows[row].size() == MAX_ROW_LENGTH) {
+            penalty = calculateRowPenalty(state.rows[row]);
+        }
+        if (penalty < bestPenalty) {
+            bestPenalty = penalty;
+            bestIndex = index;
+        }
+        index++;
+    }
+    return bestIndex;
+}
+
+SIXNIMMT_REGISTER_AGENT(EndgameSolverAgent);
+
+} // namespace SixNimmt
@@ -0,0 +1,210 @@
+#include "endgame_solver.h"
+#include <algorithm>
+
+namespace SixNimmt {
+
+namespace {
+
+constexpr int INFINITE_MARGIN = 1 << 14;
+constexpr int MAX_ROW_PENALTY = 64;
+
+enum Bound : uint8_t { Empty = 0, Exact, Lower, Upper };
+
+// Random keys for every feature of a position; fixed seed so hashes (and
+// therefore search statistics) are the same on every run
+struct ZobristKeys {
+    uint64_t tail[NUM_ROWS][DECK_SIZE + 1];
+    uint64_t length[NUM_ROWS][MAX_ROW_LENGTH + 1];
+    uint64_t penalty[NUM_ROWS][MAX_ROW_PENALTY];
+    uint64_t own[DECK_SIZE + 1];
+    uint64_t opponent[DECK_SIZE + 1];
+
+    ZobristKeys() {
+        Rng rng(0x5a0b2157u);
+        for (int row = 0; row < NUM_ROWS; ++row) {
+            for (uint64_t& key : tail[row]) key = rng();
+            for (uint64_t& key : length[row]) key = rng();
+            for (uint64_t& key : penalty[row]) key = rng();
+        }
+        for (uint64_t& key : own) key = rng();
+        for (uint64_t& key : opponent) key = rng();
+    }
+};
+
+const ZobristKeys& zobristKeys() {
+    static const ZobristKeys keys;
+    return keys;
+}
+
+// Places a card on row, or on the cheapest row if row is -1 (forced take),
+// and returns the penalty collected; row is set to the row used
+int placeCard(GameState& table, int card, int& row) {
+    int penalty = 0;
+    if (row == -1) {
+        row = 0;
+        for (int i = 1; i < NUM_ROWS; ++i) {
+            if (table.rows[i].penalty() < table.rows[row].penalty()) row = i;
+        }
+        penalty = table.rows[row].penalty();
+        table.rows[row].reset(Card(card));
+    } else if (table.rows[row].size() == MAX_ROW_LENGTH) {
+        penalty = table.rows[row].penalty();
+        table.rows[row].reset(Card(card));
+    } else {
+        table.rows[row].push(Card(card));
+    }
+    return penalty;
+}
+
+// Row each card would go to on this table (-1 for a forced take)
+void findTargetRows(const GameState& table, const CardSet& cards, std::array<int8_t, DECK_SIZE + 1>& target) {
+    RowPlacement placement = placeCards(table, cards);
+    for (int row = 0; row < NUM_ROWS; ++row) {
+        for (const Card& card : placement.byRow[row]) target[card.number] = static_cast<int8_t>(row);
+    }
+    for (const Card& card : placement.forcedTake) target[card.number] = -1;
+}
+
+} // namespace
+
+EndgameSolver::EndgameSolver(int tableBits) : tableBits(tableBits) {
+}
+
+void EndgameSolver::clear() {
+    std::fill(table.begin(), table.end(), Entry());
+}
+
+uint64_t EndgameSolver::hash(const Node& node) const {
+    const ZobristKeys& keys = zobristKeys();
+    uint64_t key = 0;
+    for (int row = 0; row < NUM_ROWS; ++row) {
+        const Row& r = node.table.rows[row];
+        key ^= keys.tail[row][r.tail] ^ keys.length[row][r.length] ^ keys.penalty[row][r.bullHeads];
+    }
+    for (const Card& card : node.own) key ^= keys.own[card.number];
+    for (const Card& card : node.opponent) key ^= keys.opponent[card.number];
+    return key;
+}
+
+std::array<int, HAND_SIZE> EndgameSolver::solveMoves(const SimState& sim, int seat) {
+    assert(sim.numPlayers() == 2);
+
+    // Allocated on first use: agents are also constructed just to read their name
+    if (table.empty()) {
+        table.resize(size_t(1) << tableBits);
+        mask = table.size() - 1;
+    }
+
+    Node root;
+    root.table = sim.table;
+    root.own = sim.hands[seat];
+    root.opponent = sim.hands[1 - seat];
+
+    std::array<int8_t, DECK_SIZE + 1> target;
+    findTargetRows(root.table, root.own | root.opponent, target);
+
+    // Full window for every card, so each value is exact
+    std::array<int, HAND_SIZE> values{};
+    int index = 0;
+    for (const Card& card : root.own) {
+        values[index++] = answer(root, target, card.number, -INFINITE_MARGIN, INFINITE_MARGIN);
+    }
+    return values;
+}
+
+// Our move: minimize the margin over our cards
+int EndgameSolver::search(const Node& node, int alpha, int beta) {
+    if (node.own.empty()) return 0;
+    nodes++;
+
+    uint64_t key = 0;
+    Entry* entry = nullptr;
+    int firstCard = 0;
+
+    // With one card each the round is forced; not worth a table slot
+    if (node.own.size() > 1) {
+        key = hash(node);
+        entry = &table[key & mask];
+        probes++;
+        if (entry->bound != Empty && entry->key == key) {
+            hits++;
+            if (entry->bound == Exact) return entry->value;
+            if (entry->bound == Lower && entry->value >= beta) return entry->value;
+            if (entry->bound == Upper && entry->value <= alpha) return entry->value;
+            firstCard = entry->bestCard;
+        }
+    }
+
+    // Row every card in play would go to on this table, shared by all
+    // card pairs of the node; see answer() for how a pair is resolved
+    std::array<int8_t, DECK_SIZE + 1> target;
+    findTargetRows(node.table, node.own | node.opponent, target);
+
+    int alphaOriginal = alpha;
+    int betaOriginal = beta;
+    int best = INFINITE_MARGIN;
+    int bestCard = 0;
+
+    auto tryCard = [&](int card) {
+        int value = answer(node, target, card, alpha, beta);
+        if (value < best) {
+            best = value;
+            bestCard = card;
+        }
+        beta = std::min(beta, best);
+        return best <= alpha;
+    };
+
+    // Best card from an earlier visit first, then ascending
+    bool cutoff = firstCard && tryCard(firstCard);
+    for (const Card& card : node.own) {
+        if (cutoff) break;
+        if (card.number != firstCard) cutoff = tryCard(card.number);
+    }
+
+    if (entry) {
+        entry->key = key;
+        entry->value = static_cast<int16_t>(best);
+        entry->bound = best <= alphaOriginal ? Upper : best >= betaOriginal ? Lower : Exact;
+        entry->bestCard = static_cast<uint8_t>(bestCard);
+    }
+    return best;
+}
+
+// Opponent's reply to our card: maximize the margin. Only two cards are
+// played, so the resolution order Game::playRound sorts out is just the
+// lower card first. The lower card goes to its precomputed target row; the
+// higher one goes to its own target unless the lower card just became the
+// closer tail, or changed the row the higher card was aiming for.
+int EndgameSolver::answer(const Node& node, const std::array<int8_t, DECK_SIZE + 1>& target, int card, int alpha,
+                          int beta) {
+    int best = -INFINITE_MARGIN;
+    for (const Card& reply : node.opponent) {
+        Node child = node;
+        child.own.erase(card);
+        child.opponent.erase(reply.number);
+
+        int low = std::min(card, reply.number);
+        int high = std::max(card, reply.number);
+        int lowRow = target[low];
+        int lowPenalty = placeCard(child.table, low, lowRow);
+
+        int highTarget = target[high];
+        if (highTarget == lowRow) {
+            highTarget = findBestRow(child.table, high);
+        } else if (highTarget == -1 || node.table.rows[highTarget].tail < low) {
+            highTarget = lowRow;
+        }
+        int highPenalty = placeCard(child.table, high, highTarget);
+
+        int margin = card == low ? lowPenalty - highPenalty : highPenalty - lowPenalty;
+        int value = margin + search(child, alpha - margin, beta - margin);
+
+        best = std::max(best, value);
+        if (best >= beta) break;
+        alpha = std::max(alpha, best);
+    }
+    return best;
+}
+
+} // namespace SixNimmt
@@ -0,0 +1,112 @@
+#include "eval_cache.h"
+#include <algorithm>
+
+namespace SixNimmt {
+
+EvalKey makeEvalKey(const GameState& state, const CardSet& hand, uint64_t context) {
+    std::array<uint16_t, NUM_ROWS> packed;
+    for (int row = 0; row < NUM_ROWS; ++row) {
+        const Row& r = state.rows[row];
+        // Tail in the high bits, so sorting the packed rows sorts by tail
+        packed[row] = static_cast<uint16_t>((r.tail << 9) | (r.length << 6) | r.bullHeads);
+    }
+    std::sort(packed.begin(), packed.end());
+
+    EvalKey key;
+    for (uint16_t row : packed) key.rows = (key.rows << 16) | row;
+    key.hand = hand;
+    key.context = context;
+    key.roundNumber = static_cast<uint8_t>(state.roundNumber);
+    key.numPlayers = static_cast<uint8_t>(state.numPlayers);
+    return key;
+}
+
+EvalCache::EvalCache(size_t maxBytes, int numShards) {
+    while ((1 << (shardBits + 1)) <= std::max(1, numShards)) shardBits++;
+
+    // Largest power of two per shard that fits the budget, at least a window
+    size_t perShard = maxBytes / (size_t(1) << shardBits) / sizeof(Slot);
+    shardSlots = PROBE_WINDOW;
+    while (shardSlots * 2 <= perShard) shardSlots *= 2;
+
+    for (int i = 0; i < (1 << shardBits); ++i) {
+        shards.push_back(std::make_unique<Shard>());
+        shards.back()->slots.resize(shardSlots);
+    }
+}
+
+bool EvalCache::lookup(const EvalKey& key, EvalValues& values) {
+    uint64_t hash = key.hash();
+    Shard& shard = *shards[hash & ((size_t(1) << shardBits) - 1)];
+    size_t home = (hash >> shardBits) & (shardSlots - 1);
+
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    shard.lookups++;
+    for (int i = 0; i < PROBE_WINDOW; ++i) {
+        Slot& slot = shard.slots[(home + i) & (shardSlots - 1)];
+        if (!slot.used) break;
+        if (slot.key == key) {
+            slot.referenced = true;
+            values = slot.values;
+            shard.hits++;
+            return true;
+        }
+    }
+    return false;
+}
+
+void EvalCache::store(const EvalKey& key, const EvalValues& values) {
+    uint64_t hash = key.hash();
+    Shard& shard = *shards[hash & ((size_t(1) << shardBits) - 1)];
+    size_t home = (hash >> shardBits) & (shardSlots - 1);
+
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    shard.stores++;
+
+    // Existing entry or the first free slot of the window
+    for (int i = 0; i < PROBE_WINDOW; ++i) {
+        Slot& slot = shard.slots[(home + i) & (shardSlots - 1)];
+        if (!slot.used || slot.key == key) {
+            if (!slot.used) shard.entries++;
+            slot = Slot{key, values, true, false};
+            return;
+        }
+    }
+
+    // Window full: the clock hand sweeps it, clearing reference bits, and
+    // replaces the first slot not read since its last pass
+    for (int i = shard.clockHand++ % PROBE_WINDOW;; i = (i + 1) % PROBE_WINDOW) {
+        Slot& slot = shard.slots[(home + i) & (shardSlots - 1)];
+        if (!slot.referenced) {
+            slot = Slot{key, values, true, false};
+            shard.evictions++;
+            return;
+        }
+        slot.referenced = false;
+    }
+}
+
+void EvalCache::clear() {
+    for (const auto& shard : shards) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        std::fill(shard->slots.begin(), shard->slots.end(), Slot());
+        shard->entries = 0;
+        shard->lookups = shard->hits = shard->stores = shard->evictions = 0;
+    }
+}
+
+EvalCache::Stats EvalCache::getStats() const {
+    Stats stats;
+    for (const auto& shard : shards) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        stats.lookups += shard->lookups;
+        stats.hits += shard->hits;
+        stats.stores += shard->stores;
+        stats.evictions += shard->evictions;
+        stats.entries += shard->entries;
+    }
+    stats.capacity = capacity();
+    return stats;
+}
+
+} // namespace SixNimmt
@@ -0,0 +1,90 @@
+/*
+ * Example agent plugin (agent_plugin.h), written in C to show the interface
+ * needs nothing from the C++ side. Build it as a shared library and load it
+ * with sixnimmt_contest --plugins DIR.
+ */
+
+#include "agent_plugin.h"
+#include <stdlib.h>
+
+typedef struct {
+    int seat;
+    int num_players;
+} ExampleAgent;
+
+static void* example_create(void) {
+    return calloc(1, sizeof(ExampleAgent));
+}
+
+static void example_destroy(void* agent) {
+    free(agent);
+}
+
+static void example_initialize(void* agent, uint64_t seed, int seat, int num_players,
+                               const uint8_t* hand, int hand_size) {
+    ExampleAgent* self = (ExampleAgent*)agent;
+    (void)seed;
+    (void)hand;
+    (void)hand_size;
+    self->seat = seat;
+    self->num_players = num_players;
+}
+
+/* PluginLowestCardAgent: plays like LowestCardFirstAgent */
+static int lowest_choose_card(void* agent, const SixNimmtPluginState* state) {
+    (void)agent;
+    (void)state;
+    return 0;
+}
+
+/* PluginClosestFitAgent: the card that lands closest above a row tail
+   without being the row's sixth card, else the lowest card */
+static int closest_fit_choose_card(void* agent, const SixNimmtPluginState* state) {
+    int best = 0;
+    int best_gap = 1000;
+    int i;
+    (void)agent;
+    for (i = 0; i < state->hand_size; ++i) {
+        int card = state->hand[i];
+        int row = -1;
+        int gap = 1000;
+        int r;
+        for (r = 0; r < SIXNIMMT_PLUGIN_ROWS; ++r) {
+            int tail = state->row_cards[r][state->row_length[r] - 1];
+            if (card > tail && card - tail < gap) {
+                gap = card - tail;
+                row = r;
+            }
+        }
+        if (row >= 0 && state->row_length[row] < SIXNIMMT_PLUGIN_ROW_LENGTH && gap < best_gap) {
+            best_gap = gap;
+            best = i;
+        }
+    }
+    return best;
+}
+
+/* Fewest bull heads, then the shorter row */
+static int closest_fit_choose_row(void* agent, const SixNimmtPluginState* state) {
+    int best = 0;
+    int r;
+    (void)agent;
+    for (r = 1; r < SIXNIMMT_PLUGIN_ROWS; ++r) {
+        if (state->row_penalty[r] < state->row_penalty[best] ||
+            (state->row_penalty[r] == state->row_penalty[best] && state->row_length[r] < state->row_length[best])) {
+            best = r;
+        }
+    }
+    return best;
+}
+
+static const SixNimmtAgentPlugin AGENTS[] = {
+    {SIXNIMMT_PLUGIN_ABI_VERSION, "PluginLowestCardAgent", example_create, example_destroy, example_initialize,
+     lowest_choose_card, NULL},
+    {SIXNIMMT_PLUGIN_ABI_VERSION, "PluginClosestFitAgent", example_create, example_destroy, example_initialize,
+     closest_fit_choose_card, closest_fit_choose_row},
+};
+
+SIXNIMMT_PLUGIN_EXPORT const SixNimmtAgentPlugin* sixnimmt_agent_plugin(int index) {
+    return index >= 0 && index < (int)(sizeof(AGENTS) / sizeof(AGENTS[0])) ? &AGENTS[index] : NULL;
+}
@@ -1,18 +1,28 @@
 #include "game.h"
+#include "game_log.h"
 #include <iostream>
 #include <iomanip>
 #include <algorithm>
+#include <stdexcept>
 
 namespace SixNimmt {
 
-void Game::initializeDeck() {
-    deck.clear();
-    for (int i = 1; i <= 104; ++i) {
+uint64_t randomSeed() {
+    std::random_device device;
+    return (static_cast<uint64_t>(device()) << 32) | device();
+}
+
+std::vector<Card> Game::shuffledDeck(uint64_t seed) {
+    std::vector<Card> deck;
+    deck.reserve(DECK_SIZE);
+    for (int i = 1; i <= DECK_SIZE; ++i) {
         deck.emplace_back(i);
     }
 
-    // Shuffle the deck
-    std::shuffle(deck.begin(), deck.end(), rng);
+    // Stream 0 of the game seed shuffles the deck
+    Rng rng(deriveSeed(seed, 0));
+    shuffleRange(deck.begin(), deck.end(), rng);
+    return deck;
 }
 
 void Game::dealCards() {
@@ -25,6 +35,8 @@ void Game::dealCards() {
             playerHand.push_back(deck[cardIndex]);
             cardIndex++;
         }
+        // Hands are dealt sorted, so a card's index in the hand is its rank
+        std::sort(playerHand.begin(), playerHand.end());
         players[player]->initialize(player, players.size(), playerHand);
     }
 
@@ -33,124 +45,164 @@ void Game::dealCards() {
 }
 
 void Game::initializeRows() {
-    rows.clear();
-    rows.resize(4);
-
     // Deal 4 starting cards, one to each row
-    for (int i = 0; i < 4; ++i) {
-        rows[i].push_back(deck[i]);
+    for (int i = 0; i < NUM_ROWS; ++i) {
+        state.rows[i].reset(deck[i]);
     }
 
     // Remove the 4 starting cards from deck
     deck.erase(deck.begin(), deck.begin() + 4);
 }
 
+// Runs one agent decision; untimed seats go straight through. fallback -1
+// stands for the lowest-penalty row, computed only when it is needed.
+template <typename Decide>
+int Game::timeDecision(int playerId, LatencyHistogram DecisionStats::*histogram, int fallback, Decide decide) {
+    DecisionStats* stats = decisionStats[playerId];
+    if (!stats && moveTimeLimit.count() == 0) return decide();
+
+    auto start = std::chrono::steady_clock::now();
+    int choice = decide();
+    auto elapsed = std::chrono::steady_clock::now() - start;
+
+    if (stats) (stats->*histogram).add(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+    if (moveTimeLimit.count() > 0 && elapsed > moveTimeLimit) {
+        if (stats) stats->timeouts++;
+        choice = fallback == -1 ? lowestPenaltyRow() : fallback;
+        players[playerId]->onMoveReplaced(state, choice);
+    }
+    return choice;
+}
+
+template <typename Event>
+void Game::notify(Event event) {
+    for (const auto& player : players) event(*player);
+    for (GameObserver* observer : observers) event(*observer);
+}
+
+int Game::lowestPenaltyRow() const {
+    return SixNimmt::lowestPenaltyRow(state);
+}
+
 void Game::playRound() {
-    std::vector<std::pair<Card, int>> playedCards; // (card, playerId)
+    SIXNIMMT_PROBE(PlayRound);
 
-    GameState state = getGameState();
-    for (int playerId = 0; playerId < players.size(); ++playerId) {
-        int cardIndex = players[playerId]->chooseCard(state);
+    RoundCards playedCards;
+    RevealBuffer reveal;
+    int numPlayed = static_cast<int>(players.size());
+
+    for (int playerId = 0; playerId < numPlayed; ++playerId) {
+        int cardIndex = timeDecision(playerId, &DecisionStats::chooseCard, 0, [&] {
+            SIXNIMMT_PROBE(ChooseCard);
+            return players[playerId]->chooseCard(state);
+        });
         assert(cardIndex >= 0 && cardIndex < static_cast<int>(players[playerId]->getHand().size()));
 
+        if (recorder) recorder->recordChoice(playerId, cardIndex);
+
         // Store card and player ID, then remove from hand
-        playedCards.emplace_back(players[playerId]->getHand()[cardIndex], playerId);
+        playedCards[playerId] = static_cast<uint8_t>(players[playerId]->getHand().select(cardIndex));
+        reveal.add(playerId, playedCards[playerId]);
         players[playerId]->removeCard(cardIndex);
     }
 
-    // Sort by card number and process
-    std::sort(playedCards.begin(), playedCards.end());
-
-    for (const auto& pair : playedCards) {
-        processCard(pair.first, pair.second);
+    // Reveal only once everyone has chosen
+    for (int playerId = 0; playerId < numPlayed; ++playerId) {
+        state.playedCards[playerId] = playedCards[playerId];
     }
+    notify([&](GameObserver& observer) { observer.onCardsRevealed(state); });
+
+    // Lowest card first
+    reveal.forEach([&](const Card& card, int playerId) { processCard(card, playerId); });
 
-    currentRound++;
+    state.roundNumber++;
+    notify([&](GameObserver& observer) { observer.onRoundEnd(state); });
 }
 
 void Game::processCard(const Card& card, int playerId) {
+    SIXNIMMT_PROBE(ProcessCard);
     int bestRow = findBestRow(card);
 
     if (bestRow == -1) {
-        GameState state = getGameState();
-        int rowToTake = players[playerId]->chooseRowToTake(state);
+        int rowToTake = timeDecision(playerId, &DecisionStats::chooseRowToTake, -1, [&] {
+            SIXNIMMT_PROBE(ChooseRowToTake);
+            return players[playerId]->chooseRowToTake(state);
+        });
 
-        assert(rowToTake >= 0 && rowToTake < 4);
+        assert(rowToTake >= 0 && rowToTake < NUM_ROWS);
+        if (recorder) recorder->recordForcedTake(rowToTake);
 
+        Row taken = state.rows[rowToTake];
         takeRow(playerId, rowToTake);
-        rows[rowToTake] = {card};
+        state.rows[rowToTake].reset(card);
+        notify([&](GameObserver& observer) { observer.onRowTaken(state, playerId, rowToTake, taken); });
+    } else if (state.rows[bestRow].size() == MAX_ROW_LENGTH) {
+        // The card would be the 6th in the row
+        Row taken = state.rows[bestRow];
+        takeRow(playerId, bestRow);
+        state.rows[bestRow].reset(card);
+        notify([&](GameObserver& observer) { observer.onRowTaken(state, playerId, bestRow, taken); });
     } else {
-        rows[bestRow].push_back(card);
-
-        if (rows[bestRow].size() == 6) {
-            takeRow(playerId, bestRow);
-            rows[bestRow] = {card};
-        }
+        state.rows[bestRow].push(card);
     }
 }
 
 int Game::findBestRow(const Card& card) const {
-    int bestRow = -1;
-    int bestDifference = 1000; // Large number
-
-    for (int i = 0; i < 4; ++i) {
-        if (!rows[i].empty()) {
-            int lastCardNumber = rows[i].back().number;
-            if (lastCardNumber < card.number) {
-                int difference = card.number - lastCardNumber;
-                if (difference < bestDifference) {
-                    bestDifference = difference;
-                    bestRow = i;
-                }
-            }
-        }
-    }
-
-    return bestRow;
+    return SixNimmt::findBestRow(state, card.number);
 }
 
 void Game::takeRow(int playerId, int rowIndex) {
+    SIXNIMMT_PROBE(TakeRow);
     // Add penalty points for all cards in the row
-
-    int penalty = 0;
-    for (const Card& card : rows[rowIndex]) {
-        penalty += card.bullHeads;
-    }
-    scores[playerId] += penalty;
+    state.scores[playerId] += state.rows[rowIndex].penalty();
 }
 
 void Game::printGameState() const {
     std::cout << "\n=== Game State ===" << std::endl;
-    for (int i = 0; i < 4; ++i) {
+    for (int i = 0; i < NUM_ROWS; ++i) {
         std::cout << "Row " << i << ": ";
-        for (const Card& card : rows[i]) {
+        for (const Card& card : state.rows[i]) {
             std::cout << card.number << "(" << card.bullHeads << ") ";
         }
         std::cout << std::endl;
     }
     std::cout << "Scores: ";
-    for (int i = 0; i < scores.size(); ++i) {
-        std::cout << "P" << i << ":" << scores[i] << " ";
+    for (int i = 0; i < state.numPlayers; ++i) {
+        std::cout << "P" << i << ":" << state.scores[i] << " ";
     }
     std::cout << std::endl;
 }
 
-Game::Game(std::vector<std::unique_ptr<Player>>&& players) 
-    : players(std::move(players)), scores(this->players.size(), 0), currentRound(1), rng(std::random_device{}()) {
-    assert(players.size() >= 2 && "Must have at least 2 players");
-    assert(players.size() <= 10 && "Cannot have more than 10 players");
+Game::Game(std::vector<std::unique_ptr<Player>>&& players, uint64_t seed)
+    : Game(std::move(players), shuffledDeck(seed), seed) {
+}
+
+Game::Game(std::vector<std::unique_ptr<Player>>&& players, std::vector<Card> deck, uint64_t seed)
+    : players(std::move(players)), deck(std::move(deck)), gameSeed(seed) {
+    assert(this->players.size() >= 2 && "Must have at least 2 players");
+    assert(this->players.size() <= MAX_PLAYERS && "Cannot have more than 10 players");
+    // Hands and the reveal buffer assume distinct cards; a replayed deck
+    // comes from outside, so check it in release builds too. Numbers are
+    // range-checked first: CardSet shifts by them.
+    bool inRange = std::all_of(this->deck.begin(), this->deck.end(),
+                               [](const Card& card) { return card.number >= 1 && card.number <= DECK_SIZE; });
+    if (this->deck.size() != DECK_SIZE || !inRange || CardSet(this->deck) != CardSet::fullDeck()) {
+        throw std::invalid_argument("deck must hold every card from 1 to 104 once");
+    }
+
+    state.numPlayers = static_cast<int>(this->players.size());
+
+    // Stream 0 shuffles the deck (see shuffledDeck), stream i + 1 belongs to seat i
+    for (int i = 0; i < state.numPlayers; ++i) {
+        this->players[i]->seed(deriveSeed(seed, i + 1));
+    }
 
-    initializeDeck();
     dealCards();
     initializeRows();
 }
 
-GameState Game::getGameState() const {
-    GameState state;
-    state.rows = rows;
-    state.roundNumber = currentRound;
-    state.scores = scores;
-    return state;
+Game::Game(std::vector<std::unique_ptr<Player>>&& players)
+    : Game(std::move(players), randomSeed()) {
 }
 
 std::vector<int> Game::playGame(bool verbose) {
@@ -159,6 +211,15 @@ std::vector<int> Game::playGame(bool verbose) {
         printGameState();
     }
 
+    if (recorder) {
+        std::array<CardSet, MAX_PLAYERS> hands;
+        for (int i = 0; i < state.numPlayers; ++i) {
+            hands[i] = players[i]->getHand();
+        }
+        recorder->beginGame(gameSeed, state, hands);
+    }
+    notify([&](GameObserver& observer) { observer.onGameStart(state); });
+
     // Play 10 rounds
     for (int round = 1; round <= 10; ++round) {
         if (verbose) {
@@ -173,11 +234,13 @@ std::vector<int> Game::playGame(bool verbose) {
     if (verbose) {
         std::cout << "\n=== Final Scores ===" << std::endl;
         for (int i = 0; i < players.size(); ++i) {
-            std::cout << players[i]->getName() << ": " << scores[i] << " points" << std::endl;
+            std::cout << players[i]->getName() << ": " << state.scores[i] << " points" << std::endl;
         }
     }
 
-    return scores;
+    if (recorder) recorder->endGame(state);
+
+    return getScores();
 }
 
 
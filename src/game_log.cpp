@@ -0,0 +1,254 @@
+#include "game_log.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace SixNimmt {
+
+GameRecorder::GameRecorder(const std::string& path, size_t bufferSize)
+    : file(std::fopen(path.c_str(), "ab")), bufferSize(bufferSize) {
+    if (!file) return;
+    buffer.reserve(bufferSize + 256);
+
+    // New file: write the header first
+    std::fseek(file, 0, SEEK_END);
+    if (std::ftell(file) == 0) {
+        uint8_t header[GAME_LOG_HEADER_SIZE] = {
+            GAME_LOG_MAGIC & 0xff, (GAME_LOG_MAGIC >> 8) & 0xff, (GAME_LOG_MAGIC >> 16) & 0xff, GAME_LOG_MAGIC >> 24,
+            GAME_LOG_VERSION & 0xff, GAME_LOG_VERSION >> 8, 0, 0};
+        buffer.insert(buffer.end(), header, header + GAME_LOG_HEADER_SIZE);
+    }
+}
+
+GameRecorder::~GameRecorder() {
+    if (file) {
+        flush();
+        std::fclose(file);
+    }
+}
+
+void GameRecorder::beginGame(uint64_t seed, const GameState& state, const std::array<CardSet, MAX_PLAYERS>& hands) {
+    this->seed = seed;
+    numPlayers = state.numPlayers;
+    for (int row = 0; row < NUM_ROWS; ++row) {
+        rowCards[row] = state.rows[row].tail;
+    }
+    int cardIndex = 0;
+    for (int seat = 0; seat < numPlayers; ++seat) {
+        for (const Card& card : hands[seat]) {
+            dealtCards[cardIndex++] = static_cast<uint8_t>(card.number);
+        }
+    }
+    numChoices = 0;
+    numForcedTakes = 0;
+}
+
+void GameRecorder::recordChoice([[maybe_unused]] int seat, int cardIndex) {
+    assert(numChoices % numPlayers == seat);
+    choices[numChoices++] = static_cast<uint8_t>(cardIndex);
+}
+
+void GameRecorder::recordForcedTake(int row) {
+    forcedTakes[numForcedTakes++] = static_cast<uint8_t>(row);
+}
+
+void GameRecorder::endGame(const GameState& state) {
+    if (!file) return;
+
+    size_t start = buffer.size();
+    size_t size = 16 + numPlayers * HAND_SIZE + (numChoices + 1) / 2 + (numForcedTakes + 3) / 4 + numPlayers;
+    buffer.resize(start + size, 0);
+    uint8_t* out = buffer.data() + start;
+
+    out[0] = size & 0xff;
+    out[1] = size >> 8;
+    for (int i = 0; i < 8; ++i) {
+        out[2 + i] = static_cast<uint8_t>(seed >> (8 * i));
+    }
+    out[10] = static_cast<uint8_t>(numPlayers);
+    out[11] = static_cast<uint8_t>(numForcedTakes);
+    for (int row = 0; row < NUM_ROWS; ++row) {
+        out[12 + row] = rowCards[row];
+    }
+    out += 16;
+    for (int i = 0; i < numPlayers * HAND_SIZE; ++i) {
+        *out++ = dealtCards[i];
+    }
+    for (int i = 0; i < numChoices; ++i) {
+        out[i / 2] |= choices[i] << (4 * (i % 2));
+    }
+    out += (numChoices + 1) / 2;
+    for (int i = 0; i < numForcedTakes; ++i) {
+        out[i / 4] |= forcedTakes[i] << (2 * (i % 4));
+    }
+    out += (numForcedTakes + 3) / 4;
+    for (int seat = 0; seat < numPlayers; ++seat) {
+        *out++ = static_cast<uint8_t>(state.scores[seat]);
+    }
+
+    gamesRecorded++;
+    if (buffer.size() >= bufferSize) {
+        flush();
+    }
+}
+
+void GameRecorder::flush() {
+    if (!file || buffer.empty()) return;
+    std::fwrite(buffer.data(), 1, buffer.size(), file);
+    std::fflush(file);
+    buffer.clear();
+}
+
+uint64_t GameRecordView::seed() const {
+    uint64_t value = 0;
+    for (int i = 0; i < 8; ++i) {
+        value |= static_cast<uint64_t>(data[2 + i]) << (8 * i);
+    }
+    return value;
+}
+
+CardSet GameRecordView::hand(int seat) const {
+    CardSet cards;
+    const uint8_t* dealt = data + 16 + seat * HAND_SIZE;
+    for (int i = 0; i < HAND_SIZE; ++i) {
+        cards.insert(dealt[i]);
+    }
+    return cards;
+}
+
+int GameRecordView::choice(int round, int seat) const {
+    int i = round * numPlayers() + seat;
+    return (data[choicesOffset() + i / 2] >> (4 * (i % 2))) & 0xf;
+}
+
+int GameRecordView::forcedTake(int index) const {
+    return (data[takesOffset() + index / 4] >> (2 * (index % 4))) & 0x3;
+}
+
+int GameRecordView::score(int seat) const {
+    return data[scoresOffset() + seat];
+}
+
+GameLogReader::GameLogReader(const std::string& path) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) return;
+
+    struct stat info;
+    if (fstat(fd, &info) == 0 && static_cast<size_t>(info.st_size) >= GAME_LOG_HEADER_SIZE) {
+        void* mapped = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapped != MAP_FAILED) {
+            data = static_cast<const uint8_t*>(mapped);
+            mappedSize = info.st_size;
+            madvise(mapped, mappedSize, MADV_SEQUENTIAL);
+        }
+    }
+    close(fd);
+    if (!data) return;
+
+    uint32_t magic = data[0] | (data[1] << 8) | (data[2] << 16) | (static_cast<uint32_t>(data[3]) << 24);
+    uint16_t version = data[4] | (data[5] << 8);
+    if (magic != GAME_LOG_MAGIC || version != GAME_LOG_VERSION) {
+        munmap(const_cast<uint8_t*>(data), mappedSize);
+        data = nullptr;
+        return;
+    }
+
+    // Stop before a record that was cut off (e.g. by a crashed writer)
+    validSize = GAME_LOG_HEADER_SIZE;
+    while (validSize + 2 <= mappedSize) {
+        size_t size = GameRecordView(data + validSize).size();
+        if (size == 0 || validSize + size > mappedSize) break;
+        validSize += size;
+    }
+}
+
+GameLogReader::~GameLogReader() {
+    if (data) {
+        munmap(const_cast<uint8_t*>(data), mappedSize);
+    }
+}
+
+namespace {
+
+// Plays back the choices of one seat from a record
+class ReplayAgent : public Player {
+private:
+    const GameRecordView& record;
+    int& nextForcedTake;   // shared by all seats, takes are logged in resolution order
+    int seat = 0;
+    int round = 0;
+
+public:
+    bool dealMatches = false;
+
+    ReplayAgent(const GameRecordView& record, int& nextForcedTake) : record(record), nextForcedTake(nextForcedTake) {}
+
+    void initialize(int playerId, int /*numPlayers*/, const std::vector<Card>& initialHand) override {
+        seat = playerId;
+        round = 0;
+        hand = initialHand;
+        dealMatches = hand == record.hand(seat);
+    }
+
+    int chooseCard(const GameState& /*state*/) override {
+        return record.choice(round++, seat);
+    }
+
+    int chooseRowToTake(const GameState& /*state*/) override {
+        return record.forcedTake(nextForcedTake++);
+    }
+
+    std::string getName() const override {
+        return "ReplayAgent";
+    }
+};
+
+} // namespace
+
+bool replayMatchesRecord(const GameRecordView& record) {
+    int nextForcedTake = 0;
+    std::vector<std::unique_ptr<Player>> players;
+    for (int seat = 0; seat < record.numPlayers(); ++seat) {
+        players.push_back(std::make_unique<ReplayAgent>(record, nextForcedTake));
+    }
+
+    // Rebuild the deal from the record rather than the seed, so games built
+    // from a given deck (duplicate deals) replay too: the hands, the row
+    // cards, then the undealt cards in any order
+    std::vector<Card> deck;
+    CardSet dealt;
+    for (int seat = 0; seat < record.numPlayers(); ++seat) {
+        CardSet hand = record.hand(seat);
+        if (hand.size() != HAND_SIZE || !(dealt & hand).empty()) return false;
+        dealt |= hand;
+        for (const Card& card : hand) deck.push_back(card);
+    }
+    for (int row = 0; row < NUM_ROWS; ++row) {
+        int card = record.rowCard(row);
+        if (card < 1 || card > DECK_SIZE || dealt.contains(card)) return false;
+        dealt.insert(card);
+        deck.emplace_back(card);
+    }
+    for (const Card& card : ~dealt) deck.push_back(card);
+
+    Game game(std::move(players), std::move(deck), record.seed());
+
+    const GameState& state = game.getGameState();
+    for (int row = 0; row < NUM_ROWS; ++row) {
+        if (state.rows[row].tail != record.rowCard(row)) return false;
+    }
+
+    std::vector<int> scores = game.playGame(false);
+
+    for (const auto& player : game.releasePlayers()) {
+        if (!static_cast<const ReplayAgent&>(*player).dealMatches) return false;
+    }
+    if (nextForcedTake != record.numForcedTakes()) return false;
+    for (int seat = 0; seat < record.numPlayers(); ++seat) {
+        if (scores[seat] != record.score(seat)) return false;
+    }
+    return true;
+}
+
+} // namespace SixNimmt
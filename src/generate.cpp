@@ -0,0 +1,99 @@
+#include "self_play.h"
+#include "agent_registry.h"
+#include "plugin_loader.h"
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Generates self-play training data (self_play.h): one NPY file per chunk
+// of games, and a JSON summary on stdout
+
+namespace SixNimmt {
+
+void printGenerateUsage(const char* program) {
+    std::cout << "Usage: " << program << " --output PREFIX [options]\n"
+              << "Plays games between registered agents and writes every card decision, with its\n"
+              << "features, the card played and the final outcome, to PREFIX_00000.npy and on.\n\n"
+              << "  --output PREFIX    Path prefix of the chunk files (required)\n"
+              << "  --agents A,B,...   Agents in rotation, seat s of game g plays agent (g + s) mod\n"
+              << "                     count (default: all registered agents)\n"
+              << "  --plugins DIR      Load the agent plugins (.so files) in DIR first\n"
+              << "  --players N        Seats per game, 2-10 (default: 4)\n"
+              << "  --games N          Games to play (default: 10000)\n"
+              << "  --chunk N          Games per output file (default: 1000)\n"
+              << "  --seed S           Seed; the files depend only on it and the settings, not on\n"
+              << "                     the thread count (default: random)\n"
+              << "  --threads N        Worker threads, 0 = all hardware threads (default: 0)\n"
+              << "  --help             Print this message\n";
+}
+
+int runGenerate(int argc, char* argv[]) {
+    SelfPlaySettings settings;
+    settings.seed = randomSeed();
+    bool allAgents = true;
+
+    try {
+        for (int i = 1; i < argc; ++i) {
+            std::string option = argv[i];
+            if (option == "--help") {
+                printGenerateUsage(argv[0]);
+                return 0;
+            }
+
+            if (i + 1 >= argc) throw std::invalid_argument("missing value for " + option);
+            std::string value = argv[++i];
+
+            if (option == "--output") {
+                settings.outputPrefix = value;
+            } else if (option == "--agents") {
+                settings.agents.clear();
+                std::stringstream stream(value);
+                std::string item;
+                while (std::getline(stream, item, ',')) {
+                    if (!item.empty()) settings.agents.push_back(item);
+                }
+                allAgents = false;
+            } else if (option == "--plugins") {
+                loadAgentPlugins(value);
+            } else if (option == "--players") {
+                settings.numPlayers = std::stoi(value);
+            } else if (option == "--games") {
+                settings.numGames = std::stol(value);
+            } else if (option == "--chunk") {
+                settings.gamesPerChunk = std::stol(value);
+            } else if (option == "--seed") {
+                settings.seed = std::stoull(value);
+            } else if (option == "--threads") {
+                settings.numThreads = std::stoi(value);
+            } else {
+                throw std::invalid_argument("unknown option " + option);
+            }
+        }
+        if (allAgents) settings.agents = AgentRegistry::instance().names();
+
+        auto start = std::chrono::steady_clock::now();
+        SelfPlaySummary summary = generateSelfPlay(settings);
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        std::cout << std::fixed << std::setprecision(1)
+                  << "{\"games\": " << summary.games << ", \"decisions\": " << summary.decisions
+                  << ", \"files\": " << summary.files.size() << ", \"seed\": " << settings.seed
+                  << ", \"games_per_sec\": " << summary.games / seconds
+                  << ", \"decisions_per_sec\": " << summary.decisions / seconds << "}" << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << argv[0] << ": " << e.what() << std::endl;
+        std::cerr << "Try " << argv[0] << " --help" << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+} // namespace SixNimmt
+
+int main(int argc, char* argv[]) {
+    return SixNimmt::runGenerate(argc, argv);
+}
@@ -1,4 +1,5 @@
 #include "game.h"
+#include "agent_registry.h"
 #include <algorithm>
 
 namespace SixNimmt {
@@ -16,18 +17,8 @@ public:
     }
 
     int chooseCard(const GameState& state) override {
-        // Find the card with the highest number in our hand
-        int highestCardIndex = 0;
-        int highestNumber = hand[0].number;
-
-        for (int i = 1; i < hand.size(); ++i) {
-            if (hand[i].number > highestNumber) {
-                highestNumber = hand[i].number;
-                highestCardIndex = i;
-            }
-        }
-
-        return highestCardIndex;
+        // The hand is sorted, so the highest card is always the last one
+        return hand.size() - 1;
     }
 
     std::string getName() const override {
@@ -35,4 +26,6 @@ public:
     }
 };
 
+SIXNIMMT_REGISTER_AGENT(HighestCardFirstAgent);
+
 } // namespace SixNimmt
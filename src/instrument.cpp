@@ -0,0 +1,152 @@
+#include "instrument.h"
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <vector>
+
+namespace SixNimmt {
+namespace Instrument {
+
+namespace {
+
+struct Event {
+    Probe probe;
+    std::chrono::steady_clock::time_point start;
+    std::chrono::steady_clock::duration elapsed;
+};
+
+// Everything one thread records. The registry owns it, so counters and
+// events outlive the thread (pool workers exit before results are read).
+struct ThreadState {
+    ThreadCounters counters;
+    std::vector<Event> events;
+};
+
+struct Registry {
+    std::mutex mutex;   // taken once per new thread and by the readers
+    std::vector<std::unique_ptr<ThreadState>> threads;
+    std::atomic<size_t> maxEvents{0};
+    std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+};
+
+Registry& registry() {
+    static Registry instance;
+    return instance;
+}
+
+thread_local ThreadState* currentThread = nullptr;
+
+} // namespace
+
+std::atomic<bool> tracing{false};
+
+const char* probeName(Probe probe) {
+    switch (probe) {
+    case Probe::PlayRound: return "playRound";
+    case Probe::ProcessCard: return "processCard";
+    case Probe::TakeRow: return "takeRow";
+    case Probe::GetGameState: return "getGameState";
+    case Probe::ChooseCard: return "chooseCard";
+    case Probe::ChooseRowToTake: return "chooseRowToTake";
+    case Probe::Count: break;
+    }
+    return "?";
+}
+
+ThreadCounters& registerThread() {
+    Registry& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    reg.threads.push_back(std::make_unique<ThreadState>());
+    currentThread = reg.threads.back().get();
+    currentThread->counters.threadIndex = static_cast<int>(reg.threads.size()) - 1;
+    return currentThread->counters;
+}
+
+void recordEvent(Probe probe, std::chrono::steady_clock::time_point start, std::chrono::steady_clock::duration elapsed) {
+    // threadCounters() has run on this thread, so currentThread is set
+    std::vector<Event>& events = currentThread->events;
+    if (events.size() < registry().maxEvents.load(std::memory_order_relaxed)) events.push_back({probe, start, elapsed});
+}
+
+std::array<ProbeTotals, NUM_PROBES> totals() {
+    Registry& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    std::array<ProbeTotals, NUM_PROBES> sums{};
+    for (const auto& thread : reg.threads) {
+        for (int i = 0; i < NUM_PROBES; ++i) {
+            sums[i].calls += thread->counters.calls[i].load(std::memory_order_relaxed);
+            sums[i].nanoseconds += thread->counters.nanoseconds[i].load(std::memory_order_relaxed);
+        }
+    }
+    return sums;
+}
+
+void reset() {
+    Registry& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    for (const auto& thread : reg.threads) {
+        for (int i = 0; i < NUM_PROBES; ++i) {
+            thread->counters.calls[i].store(0, std::memory_order_relaxed);
+            thread->counters.nanoseconds[i].store(0, std::memory_order_relaxed);
+        }
+        thread->events = std::vector<Event>();
+    }
+    reg.epoch = std::chrono::steady_clock::now();
+}
+
+void startTrace(size_t maxEventsPerThread) {
+    Registry& reg = registry();
+    reg.maxEvents.store(maxEventsPerThread);
+    tracing.store(true);
+}
+
+void stopTrace() {
+    tracing.store(false);
+}
+
+void writeSummary(std::ostream& out) {
+    std::array<ProbeTotals, NUM_PROBES> sums = totals();
+    out << std::left << std::setw(18) << "Probe" << std::right << std::setw(14) << "Calls" << std::setw(14)
+        << "Total ms" << std::setw(12) << "Mean ns" << std::endl;
+    out << std::string(58, '-') << std::endl;
+    for (int i = 0; i < NUM_PROBES; ++i) {
+        const ProbeTotals& probe = sums[i];
+        out << std::left << std::setw(18) << probeName(static_cast<Probe>(i)) << std::right << std::setw(14)
+            << probe.calls << std::fixed << std::setprecision(2) << std::setw(14) << probe.nanoseconds / 1e6;
+        if (static_cast<Probe>(i) == Probe::GetGameState) {
+            out << std::setw(12) << "-";
+        } else {
+            out << std::setprecision(1) << std::setw(12)
+                << (probe.calls ? static_cast<double>(probe.nanoseconds) / probe.calls : 0.0);
+        }
+        out << std::endl;
+    }
+    if (!ENABLED) {
+        out << "(built without SIXNIMMT_INSTRUMENT: nothing is recorded)" << std::endl;
+    }
+}
+
+void writeChromeTrace(std::ostream& out) {
+    Registry& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+
+    // Timestamps in microseconds since the last reset
+    out << "{\"traceEvents\": [";
+    const char* separator = "\n  ";
+    out << std::fixed << std::setprecision(3);
+    for (const auto& thread : reg.threads) {
+        for (const Event& event : thread->events) {
+            std::chrono::duration<double, std::micro> start = event.start - reg.epoch;
+            std::chrono::duration<double, std::micro> elapsed = event.elapsed;
+            out << separator << "{\"name\": \"" << probeName(event.probe) << "\", \"ph\": \"X\", \"ts\": "
+                << start.count() << ", \"dur\": " << elapsed.count() << ", \"pid\": 1, \"tid\": "
+                << thread->counters.threadIndex << "}";
+            separator = ",\n  ";
+        }
+    }
+    out << "\n], \"displayTimeUnit\": \"ns\"}" << std::endl;
+}
+
+} // namespace Instrument
+} // namespace SixNimmt
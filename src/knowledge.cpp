@@ -0,0 +1,85 @@
+#include "knowledge.h"
+#include <algorithm>
+#include <cmath>
+
+namespace SixNimmt {
+
+void KnowledgeState::begin(int seat, int numPlayers, const CardSet& hand) {
+    this->seat = seat;
+    this->numPlayers = numPlayers;
+    this->hand = hand;
+    unseen = ~hand;
+    playedBy.fill(CardSet());
+    rowsTaken.fill(0);
+}
+
+void KnowledgeState::see(const Row& row) {
+    for (const Card& card : row) unseen.erase(card.number);
+}
+
+void KnowledgeState::onGameStart(const GameState& state) {
+    for (const Row& row : state.rows) see(row);
+    placement.rebuild(state);
+    rebuildTables(state);
+}
+
+void KnowledgeState::onCardsRevealed(const GameState& state) {
+    for (int player = 0; player < numPlayers; ++player) {
+        int card = state.playedCards[player];
+        playedBy[player].insert(card);
+        unseen.erase(card);
+    }
+    hand.erase(state.playedCards[seat]);
+}
+
+void KnowledgeState::onRowTaken(const GameState& /*state*/, int seat, int /*row*/, const Row& /*taken*/) {
+    // Every card of the row was seen when it was placed
+    rowsTaken[seat]++;
+}
+
+void KnowledgeState::onRoundEnd(const GameState& state) {
+    for (int row = 0; row < NUM_ROWS; ++row) {
+        if (state.rows[row].tail != rows[row].tail) placement.moveTail(row, rows[row].tail, state.rows[row].tail);
+    }
+    rebuildTables(state);
+}
+
+void KnowledgeState::rebuildTables(const GameState& state) {
+    rows = state.rows;
+
+    RowPlacement unseenPlacement = placeCards(state, unseen);
+    for (int row = 0; row < NUM_ROWS; ++row) {
+        unseenPerRow[row] = unseenPlacement.byRow[row].size();
+    }
+    unseenForced = unseenPlacement.forcedTake.size();
+
+    int opponents = numPlayers - 1;
+    double p = unseen.empty() ? 0.0 : std::min(1.0, static_cast<double>(opponents) / unseen.size());
+
+    for (int card = 1; card <= DECK_SIZE; ++card) {
+        int row = placement.targetRow(card);
+        if (row == -1) {
+            risk[card] = 1.0;
+            continue;
+        }
+
+        // m cards placed on the row before ours, m ~ Binomial(between, p);
+        // ours is the 6th (collecting the row) when length + m is 5, 10, ...
+        int length = rows[row].size();
+        int between = (unseen & CardSet::range(rows[row].tail + 1, card - 1)).size();
+        int maxPreceding = std::min(between, opponents);
+        double total = 0.0;
+        if (p >= 1.0) {
+            if ((length + maxPreceding) % MAX_ROW_LENGTH == 0) total = 1.0;
+        } else {
+            double probability = std::pow(1.0 - p, between);
+            for (int m = 0; m <= maxPreceding; ++m) {
+                if ((length + m) % MAX_ROW_LENGTH == 0) total += probability;
+                probability *= static_cast<double>(between - m) / (m + 1) * p / (1.0 - p);
+            }
+        }
+        risk[card] = total;
+    }
+}
+
+} // namespace SixNimmt
@@ -1,4 +1,5 @@
 #include "game.h"
+#include "agent_registry.h"
 #include <algorithm>
 
 namespace SixNimmt {
@@ -16,18 +17,8 @@ public:
     }
 
     int chooseCard(const GameState& state) override {
-        // Find the card with the lowest number in our hand
-        int lowestCardIndex = 0;
-        int lowestNumber = hand[0].number;
-
-        for (int i = 1; i < hand.size(); ++i) {
-            if (hand[i].number < lowestNumber) {
-                lowestNumber = hand[i].number;
-                lowestCardIndex = i;
-            }
-        }
-
-        return lowestCardIndex;
+        // The hand is sorted, so the lowest card is always the first one
+        return 0;
     }
 
     std::string getName() const override {
@@ -35,4 +26,6 @@ public:
     }
 };
 
+SIXNIMMT_REGISTER_AGENT(LowestCardFirstAgent);
+
 } // namespace SixNimmt
@@ -0,0 +1,67 @@
+#include "tournament.h"
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Combines the shard files of a tournament (sixnimmt_contest --shard ...
+// --format shard) into its final results
+
+namespace SixNimmt {
+
+void printMergeUsage(const char* program) {
+    std::cout << "Usage: " << program << " [--format F] SHARD...\n"
+              << "Combines shard files written by sixnimmt_contest --shard FIRST:END --format shard\n"
+              << "into the results of the whole tournament. The shards must cover every deal of\n"
+              << "the schedule exactly once.\n\n"
+              << "  --format F         table, csv, json or shard (default: table)\n"
+              << "  --help             Print this message\n";
+}
+
+int runMerge(int argc, char* argv[]) {
+    OutputFormat format = OutputFormat::Table;
+    std::vector<std::string> paths;
+
+    try {
+        for (int i = 1; i < argc; ++i) {
+            std::string option = argv[i];
+            if (option == "--help") {
+                printMergeUsage(argv[0]);
+                return 0;
+            }
+            if (option == "--format") {
+                if (i + 1 >= argc) throw std::invalid_argument("missing value for " + option);
+                std::string value = argv[++i];
+                if (!parseOutputFormat(value, format)) throw std::invalid_argument("unknown format " + value);
+            } else {
+                paths.push_back(option);
+            }
+        }
+        if (paths.empty()) throw std::invalid_argument("no shard files given");
+
+        std::vector<TournamentResult> shards;
+        for (const std::string& path : paths) {
+            std::ifstream in(path);
+            if (!in) throw std::invalid_argument("cannot read " + path);
+            try {
+                shards.push_back(readShard(in));
+            } catch (const std::invalid_argument& e) {
+                throw std::invalid_argument(path + ": " + e.what());
+            }
+        }
+
+        writeResults(std::cout, mergeShards(shards), format);
+    } catch (const std::exception& e) {
+        std::cerr << argv[0] << ": " << e.what() << std::endl;
+        std::cerr << "Try " << argv[0] << " --help" << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+} // namespace SixNimmt
+
+int main(int argc, char* argv[]) {
+    return SixNimmt::runMerge(argc, argv);
+}
@@ -0,0 +1,130 @@
+#include "monte_carlo_agent.h"
+#include "agent_registry.h"
+#include "simulator.h"
+#include <algorithm>
+#include <atomic>
+#include <limits>
+
+namespace SixNimmt {
+
+void MonteCarloAgent::initialize(int playerId, int numPlayers, const std::vector<Card>& initialHand) {
+    this->playerId = playerId;
+    this->numPlayers = numPlayers;
+    this->hand = initialHand;
+    movesMade = 0;
+    knowledge.begin(playerId, numPlayers, hand);
+}
+
+int MonteCarloAgent::chooseCard(const GameState& state) {
+    int numCandidates = hand.size();
+    if (numCandidates == 1) return 0;
+
+    if (!pool) pool = std::make_unique<ThreadPool>(numThreads);
+
+    const CardSet& unseen = knowledge.getUnseen();
+    uint64_t moveSeed = deriveSeed(agentSeed, movesMade++);
+
+    // The estimate also depends on the unseen cards and the budget
+    EvalKey key;
+    EvalValues values;
+    if (cache) {
+        key = makeEvalKey(state, hand, deriveSeed(unseen.low(), unseen.high(), playoutsPerMove, timeBudget.count()));
+        if (cache->lookup(key, values)) {
+            return static_cast<int>(std::min_element(values.begin(), values.begin() + numCandidates) - values.begin());
+        }
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    auto deadline = start + timeBudget;
+    std::atomic<bool> outOfTime{false};
+
+    // Integer sums per worker keep the result independent of how the
+    // playouts were split between threads
+    std::vector<std::array<long, HAND_SIZE>> margins(pool->size());
+    std::vector<std::array<int, HAND_SIZE>> counts(pool->size());
+    for (int w = 0; w < pool->size(); ++w) {
+        margins[w].fill(0);
+        counts[w].fill(0);
+    }
+
+    pool->parallelFor(playoutsPerMove, [&](int worker, size_t task) {
+        if (timeBudget.count() > 0) {
+            if (outOfTime.load(std::memory_order_relaxed)) return;
+            if (std::chrono::steady_clock::now() >= deadline) {
+                outOfTime.store(true, std::memory_order_relaxed);
+                return;
+            }
+        }
+
+        int candidate = static_cast<int>(task % numCandidates);
+        Rng rng(deriveSeed(moveSeed, task));
+        margins[worker][candidate] += playout(state, unseen, hand.select(candidate), rng);
+        counts[worker][candidate]++;
+    });
+
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    totalSeconds += elapsed.count();
+
+    int bestIndex = 0;
+    double bestMargin = 0.0;
+    for (int candidate = 0; candidate < numCandidates; ++candidate) {
+        long margin = 0;
+        int count = 0;
+        for (int w = 0; w < pool->size(); ++w) {
+            margin += margins[w][candidate];
+            count += counts[w][candidate];
+        }
+        totalPlayouts += count;
+        values[candidate] = count ? static_cast<float>(static_cast<double>(margin) / count)
+                                  : std::numeric_limits<float>::infinity();
+        if (count == 0) continue;
+
+        double average = static_cast<double>(margin) / count;
+        if (candidate == 0 || average < bestMargin) {
+            bestMargin = average;
+            bestIndex = candidate;
+        }
+    }
+
+    if (cache) cache->store(key, values);
+    return bestIndex;
+}
+
+int MonteCarloAgent::playout(const GameState& state, const CardSet& unseen, int card, Rng& rng) const {
+    SimState sim;
+    sim.table = state;
+    sim.hands[playerId] = hand;
+
+    // Deal the unseen cards at random to fill the opponents' hands
+    std::array<uint8_t, DECK_SIZE> pile;
+    int pileSize = 0;
+    for (const Card& unseenCard : unseen) pile[pileSize++] = static_cast<uint8_t>(unseenCard.number);
+    int handSize = hand.size();
+    int dealt = 0;
+    for (int seat = 0; seat < numPlayers; ++seat) {
+        if (seat == playerId) continue;
+        for (int i = 0; i < handSize && dealt < pileSize; ++i, ++dealt) {
+            int pick = dealt + static_cast<int>(rng.below(pileSize - dealt));
+            std::swap(pile[dealt], pile[pick]);
+            sim.hands[seat].insert(pile[dealt]);
+        }
+    }
+
+    RoundCards cards{};
+    for (int seat = 0; seat < numPlayers; ++seat) {
+        cards[seat] = static_cast<uint8_t>(seat == playerId ? card : randomRolloutCard(sim, seat, rng));
+    }
+    playRound(sim, cards);
+    playOut(sim, randomRolloutCard, rng);
+
+    int ownGain = sim.table.scores[playerId] - state.scores[playerId];
+    int opponentGain = 0;
+    for (int seat = 0; seat < numPlayers; ++seat) {
+        if (seat != playerId) opponentGain += sim.table.scores[seat] - state.scores[seat];
+    }
+    return ownGain * (numPlayers - 1) - opponentGain;
+}
+
+SIXNIMMT_REGISTER_AGENT(MonteCarloAgent);
+
+} // namespace SixNimmt
@@ -0,0 +1,143 @@
+#include "plugin_loader.h"
+#include "agent_registry.h"
+#include <algorithm>
+#include <cstring>
+#include <dlfcn.h>
+#include <filesystem>
+#include <stdexcept>
+
+namespace SixNimmt {
+
+static_assert(SIXNIMMT_PLUGIN_ROWS == NUM_ROWS && SIXNIMMT_PLUGIN_ROW_LENGTH == MAX_ROW_LENGTH &&
+                  SIXNIMMT_PLUGIN_MAX_PLAYERS == MAX_PLAYERS && SIXNIMMT_PLUGIN_MAX_HAND == HAND_SIZE,
+              "agent_plugin.h limits must match the engine");
+static_assert(sizeof(SixNimmtPluginState) == 72, "SixNimmtPluginState layout is part of the plugin ABI");
+
+class PluginLibrary {
+public:
+    explicit PluginLibrary(void* handle) : handle(handle) {}
+    ~PluginLibrary() { dlclose(handle); }
+
+    PluginLibrary(const PluginLibrary&) = delete;
+    PluginLibrary& operator=(const PluginLibrary&) = delete;
+
+private:
+    void* handle;
+};
+
+PluginAgent::PluginAgent(std::shared_ptr<const PluginLibrary> library, const SixNimmtAgentPlugin* plugin)
+    : library(std::move(library)), plugin(plugin), instance(plugin->create()) {
+    if (!instance) throw std::runtime_error(std::string("plugin agent ") + plugin->name + " failed to start");
+}
+
+PluginAgent::~PluginAgent() {
+    plugin->destroy(instance);
+}
+
+void PluginAgent::initialize(int playerId, int numPlayers, const std::vector<Card>& initialHand) {
+    this->playerId = playerId;
+    this->numPlayers = numPlayers;
+    hand = initialHand;
+
+    uint8_t cards[HAND_SIZE];
+    int size = 0;
+    for (Card card : hand) cards[size++] = static_cast<uint8_t>(card.number);
+    flat.seat = static_cast<uint8_t>(playerId);
+    flat.num_players = static_cast<uint8_t>(numPlayers);
+    plugin->initialize(instance, agentSeed, playerId, numPlayers, cards, size);
+}
+
+const SixNimmtPluginState& PluginAgent::flatten(const GameState& state) {
+    for (int row = 0; row < NUM_ROWS; ++row) {
+        std::memcpy(flat.row_cards[row], state.rows[row].cards.data(), MAX_ROW_LENGTH);
+        flat.row_length[row] = state.rows[row].length;
+        flat.row_penalty[row] = state.rows[row].bullHeads;
+    }
+    int size = 0;
+    for (Card card : hand) flat.hand[size++] = static_cast<uint8_t>(card.number);
+    flat.hand_size = static_cast<uint8_t>(size);
+    flat.round_number = static_cast<uint8_t>(state.roundNumber);
+    for (int seat = 0; seat < MAX_PLAYERS; ++seat) {
+        flat.played_cards[seat] = state.playedCards[seat];
+        flat.scores[seat] = static_cast<int16_t>(state.scores[seat]);
+    }
+    return flat;
+}
+
+int PluginAgent::chooseCard(const GameState& state) {
+    int index = plugin->choose_card(instance, &flatten(state));
+    if (index < 0 || index >= hand.size()) {
+        throw std::runtime_error(std::string("plugin agent ") + plugin->name + " chose card index " +
+                                 std::to_string(index) + " of " + std::to_string(hand.size()));
+    }
+    return index;
+}
+
+int PluginAgent::chooseRowToTake(const GameState& state) {
+    if (!plugin->choose_row_to_take) return choseLowestPenaltyRowToTake(state);
+    int row = plugin->choose_row_to_take(instance, &flatten(state));
+    if (row < 0 || row >= NUM_ROWS) {
+        throw std::runtime_error(std::string("plugin agent ") + plugin->name + " chose row " + std::to_string(row));
+    }
+    return row;
+}
+
+std::vector<std::string> loadAgentPlugin(const std::string& path) {
+    // RTLD_LOCAL keeps each plugin's symbols to itself, so two plugins may
+    // define the same helpers
+    void* handle = dlopen(path.c_str(), RTLD_NOW | RTLD_LOCAL);
+    if (!handle) throw std::invalid_argument("cannot load plugin " + path + ": " + dlerror());
+    auto library = std::make_shared<const PluginLibrary>(handle);
+
+    auto entry = reinterpret_cast<SixNimmtPluginEntry>(dlsym(handle, SIXNIMMT_PLUGIN_ENTRY_NAME));
+    if (!entry) throw std::invalid_argument(path + " has no " SIXNIMMT_PLUGIN_ENTRY_NAME "()");
+
+    // Check every agent before registering any, so a bad plugin adds nothing
+    std::vector<const SixNimmtAgentPlugin*> plugins;
+    for (int index = 0; const SixNimmtAgentPlugin* plugin = entry(index); ++index) {
+        if (plugin->abi_version != SIXNIMMT_PLUGIN_ABI_VERSION) {
+            throw std::invalid_argument(path + " was built for plugin ABI version " +
+                                        std::to_string(plugin->abi_version) + ", not " +
+                                        std::to_string(SIXNIMMT_PLUGIN_ABI_VERSION));
+        }
+        if (!plugin->name || !*plugin->name || !plugin->create || !plugin->destroy || !plugin->initialize ||
+            !plugin->choose_card) {
+            throw std::invalid_argument(path + ": agent " + std::to_string(index) + " is incomplete");
+        }
+        plugins.push_back(plugin);
+    }
+    if (plugins.empty()) throw std::invalid_argument(path + " has no agents");
+
+    std::vector<std::string> names;
+    for (const SixNimmtAgentPlugin* plugin : plugins) {
+        AgentRegistry::instance().add(plugin->name, [library, plugin] {
+            return std::unique_ptr<Player>(new PluginAgent(library, plugin));
+        });
+        names.push_back(plugin->name);
+    }
+    return names;
+}
+
+std::vector<std::string> loadAgentPlugins(const std::string& directory) {
+    std::vector<std::string> paths;
+    std::error_code error;
+    for (const auto& entry : std::filesystem::directory_iterator(directory, error)) {
+        if (entry.path().extension() == ".so") paths.push_back(entry.path().string());
+    }
+    if (error) throw std::invalid_argument("cannot read plugin directory " + directory + ": " + error.message());
+    std::sort(paths.begin(), paths.end());
+
+    std::vector<std::string> names;
+    for (const std::string& path : paths) {
+        for (std::string& name : loadAgentPlugin(path)) names.push_back(std::move(name));
+    }
+    return names;
+}
+
+std::string defaultPluginDirectory(const char* program) {
+    std::string path = program ? program : "";
+    size_t slash = path.rfind('/');
+    return (slash == std::string::npos ? std::string() : path.substr(0, slash + 1)) + "plugins";
+}
+
+} // namespace SixNimmt
@@ -0,0 +1,297 @@
+#include "policy_agent.h"
+#include "agent_registry.h"
+#include <algorithm>
+#include <fstream>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SIXNIMMT_POLICY_X86 1
+#endif
+
+namespace SixNimmt {
+
+namespace {
+
+constexpr int DEFAULT_HIDDEN = 8;
+
+// Each hidden unit prices one thing, in bull heads: a forced take, a sixth
+// card, a crowded expensive row, a wide gap, and (rewarded) shedding a
+// costly card where it is safe. The other units are spare for training.
+constexpr float DEFAULT_INPUT_WEIGHTS[DEFAULT_HIDDEN][POLICY_INPUTS] = {
+    // card  bulls forced fcost sixth scost  gap   len   pen   betw  risk  below rank  hand  opp   cheap
+    {0.0f, 0.0f, 0.0f, 10.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f},
+    {0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 10.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f},
+    {0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 10.0f, 0.0f, 6.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f},
+    {0.0f, 7.0f, -20.0f, 0.0f, -20.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, -4.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f},
+    {0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 20.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f},
+    {},
+    {},
+    {},
+};
+constexpr float DEFAULT_HIDDEN_BIAS[DEFAULT_HIDDEN] = {0.0f, 0.0f, -6.0f, 0.0f, -1.0f, 0.0f, 0.0f, 0.0f};
+constexpr float DEFAULT_OUTPUT_WEIGHTS[DEFAULT_HIDDEN] = {-1.0f, -1.0f, -0.7f, 0.15f, -0.3f, 0.0f, 0.0f, 0.0f};
+constexpr float DEFAULT_OUTPUT_BIAS = 0.0f;
+
+void checkWeights(const PolicyWeights& weights) {
+    bool linear = weights.hidden == 0;
+    if (weights.hidden < 0 ||
+        weights.inputWeights.size() != static_cast<size_t>(weights.hidden) * POLICY_INPUTS ||
+        weights.hiddenBias.size() != static_cast<size_t>(weights.hidden) ||
+        weights.outputWeights.size() != static_cast<size_t>(linear ? POLICY_INPUTS : weights.hidden)) {
+        throw std::invalid_argument("policy weights have the wrong shape");
+    }
+}
+
+const std::shared_ptr<const PolicyWeights>& sharedDefaultWeights() {
+    static const std::shared_ptr<const PolicyWeights> weights =
+        std::make_shared<const PolicyWeights>(defaultPolicyWeights());
+    return weights;
+}
+
+void evaluateScalar(const PolicyWeights& weights, const float* inputs, float* scores) {
+    for (int card = 0; card < POLICY_BATCH; ++card) scores[card] = weights.outputBias;
+
+    if (weights.hidden == 0) {
+        for (int feature = 0; feature < POLICY_INPUTS; ++feature) {
+            float weight = weights.outputWeights[feature];
+            const float* column = inputs + feature * POLICY_BATCH;
+            for (int card = 0; card < POLICY_BATCH; ++card) scores[card] += weight * column[card];
+        }
+        return;
+    }
+
+    float activation[POLICY_BATCH];
+    for (int unit = 0; unit < weights.hidden; ++unit) {
+        const float* row = weights.inputWeights.data() + unit * POLICY_INPUTS;
+        for (int card = 0; card < POLICY_BATCH; ++card) activation[card] = weights.hiddenBias[unit];
+        for (int feature = 0; feature < POLICY_INPUTS; ++feature) {
+            const float* column = inputs + feature * POLICY_BATCH;
+            for (int card = 0; card < POLICY_BATCH; ++card) activation[card] += row[feature] * column[card];
+        }
+        float weight = weights.outputWeights[unit];
+        for (int card = 0; card < POLICY_BATCH; ++card) scores[card] += weight * std::max(activation[card], 0.0f);
+    }
+}
+
+#ifdef SIXNIMMT_POLICY_X86
+// Two registers hold the 16 card slots
+__attribute__((target("avx2,fma")))
+void evaluateAvx2(const PolicyWeights& weights, const float* inputs, float* scores) {
+    static_assert(POLICY_BATCH == 16, "the AVX2 pass covers 16 slots");
+    __m256 low = _mm256_set1_ps(weights.outputBias);
+    __m256 high = low;
+
+    if (weights.hidden == 0) {
+        for (int feature = 0; feature < POLICY_INPUTS; ++feature) {
+            __m256 weight = _mm256_set1_ps(weights.outputWeights[feature]);
+            const float* column = inputs + feature * POLICY_BATCH;
+            low = _mm256_fmadd_ps(weight, _mm256_load_ps(column), low);
+            high = _mm256_fmadd_ps(weight, _mm256_load_ps(column + 8), high);
+        }
+    } else {
+        __m256 zero = _mm256_setzero_ps();
+        for (int unit = 0; unit < weights.hidden; ++unit) {
+            const float* row = weights.inputWeights.data() + unit * POLICY_INPUTS;
+            __m256 activationLow = _mm256_set1_ps(weights.hiddenBias[unit]);
+            __m256 activationHigh = activationLow;
+            for (int feature = 0; feature < POLICY_INPUTS; ++feature) {
+                __m256 weight = _mm256_set1_ps(row[feature]);
+                const float* column = inputs + feature * POLICY_BATCH;
+                activationLow = _mm256_fmadd_ps(weight, _mm256_load_ps(column), activationLow);
+                activationHigh = _mm256_fmadd_ps(weight, _mm256_load_ps(column + 8), activationHigh);
+            }
+            __m256 weight = _mm256_set1_ps(weights.outputWeights[unit]);
+            low = _mm256_fmadd_ps(weight, _mm256_max_ps(activationLow, zero), low);
+            high = _mm256_fmadd_ps(weight, _mm256_max_ps(activationHigh, zero), high);
+        }
+    }
+
+    _mm256_storeu_ps(scores, low);
+    _mm256_storeu_ps(scores + 8, high);
+}
+#endif
+
+} // namespace
+
+PolicyWeights defaultPolicyWeights() {
+    PolicyWeights weights;
+    weights.hidden = DEFAULT_HIDDEN;
+    for (const auto& row : DEFAULT_INPUT_WEIGHTS) {
+        weights.inputWeights.insert(weights.inputWeights.end(), row, row + POLICY_INPUTS);
+    }
+    weights.hiddenBias.assign(DEFAULT_HIDDEN_BIAS, DEFAULT_HIDDEN_BIAS + DEFAULT_HIDDEN);
+    weights.outputWeights.assign(DEFAULT_OUTPUT_WEIGHTS, DEFAULT_OUTPUT_WEIGHTS + DEFAULT_HIDDEN);
+    weights.outputBias = DEFAULT_OUTPUT_BIAS;
+    return weights;
+}
+
+PolicyWeights readPolicyWeights(std::istream& in) {
+    std::string magic;
+    std::string inputsKey;
+    std::string hiddenKey;
+    int version = 0;
+    int inputs = 0;
+    PolicyWeights weights;
+    if (!(in >> magic >> version >> inputsKey >> inputs >> hiddenKey >> weights.hidden) || magic != "6NPOLICY" ||
+        inputsKey != "inputs" || hiddenKey != "hidden") {
+        throw std::invalid_argument("not a policy weights file");
+    }
+    if (version != 1) throw std::invalid_argument("unsupported policy weights version " + std::to_string(version));
+    if (inputs != POLICY_INPUTS) {
+        throw std::invalid_argument("policy weights expect " + std::to_string(inputs) + " inputs, not " +
+                                    std::to_string(POLICY_INPUTS));
+    }
+    if (weights.hidden < 0 || weights.hidden > 4096) throw std::invalid_argument("bad hidden layer size");
+
+    auto readFloats = [&](std::vector<float>& values, size_t count) {
+        values.resize(count);
+        for (float& value : values) {
+            if (!(in >> value)) throw std::invalid_argument("policy weights are truncated");
+        }
+    };
+    readFloats(weights.inputWeights, static_cast<size_t>(weights.hidden) * POLICY_INPUTS);
+    readFloats(weights.hiddenBias, weights.hidden);
+    readFloats(weights.outputWeights, weights.hidden == 0 ? POLICY_INPUTS : weights.hidden);
+    if (!(in >> weights.outputBias)) throw std::invalid_argument("policy weights are truncated");
+    return weights;
+}
+
+void writePolicyWeights(std::ostream& out, const PolicyWeights& weights) {
+    checkWeights(weights);
+    auto writeFloats = [&](const std::vector<float>& values, size_t perLine) {
+        for (size_t i = 0; i < values.size(); ++i) {
+            out << values[i] << ((i + 1) % perLine == 0 || i + 1 == values.size() ? "\n" : " ");
+        }
+    };
+    out.precision(9);   // round-trips a float
+    out << "6NPOLICY 1\ninputs " << POLICY_INPUTS << "\nhidden " << weights.hidden << "\n";
+    writeFloats(weights.inputWeights, POLICY_INPUTS);
+    writeFloats(weights.hiddenBias, POLICY_INPUTS);
+    writeFloats(weights.outputWeights, POLICY_INPUTS);
+    out << weights.outputBias << "\n";
+}
+
+bool policyHasAvx2() {
+#ifdef SIXNIMMT_POLICY_X86
+    static const bool available = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+    return available;
+#else
+    return false;
+#endif
+}
+
+void evaluatePolicy(const PolicyWeights& weights, const float* inputs, float* scores, bool useAvx2) {
+#ifdef SIXNIMMT_POLICY_X86
+    if (useAvx2) {
+        evaluateAvx2(weights, inputs, scores);
+        return;
+    }
+#else
+    (void)useAvx2;
+#endif
+    evaluateScalar(weights, inputs, scores);
+}
+
+PolicyAgent::PolicyAgent() : PolicyAgent(sharedDefaultWeights()) {}
+
+PolicyAgent::PolicyAgent(std::shared_ptr<const PolicyWeights> weights)
+    : weights(std::move(weights)), useAvx2(policyHasAvx2()) {
+    checkWeights(*this->weights);
+}
+
+void PolicyAgent::initialize(int playerId, int numPlayers, const std::vector<Card>& initialHand) {
+    this->playerId = playerId;
+    this->numPlayers = numPlayers;
+    hand = initialHand;
+    unseen = ~hand;
+}
+
+void PolicyAgent::onGameStart(const GameState& state) {
+    for (const Row& row : state.rows) unseen.erase(row.tail);
+}
+
+void PolicyAgent::onCardsRevealed(const GameState& state) {
+    for (int seat = 0; seat < state.numPlayers; ++seat) unseen.erase(state.playedCards[seat]);
+}
+
+const float* PolicyAgent::encode(const GameState& state) {
+    float handSize = static_cast<float>(hand.size());
+    float cheapest = state.rows[lowestPenaltyRow(state)].bullHeads / 10.0f;
+    float opponents = (numPlayers - 1) / 9.0f;
+
+    int slot = 0;
+    for (Card card : hand) {
+        float* x = inputs + slot;
+        auto set = [x](int feature, float value) { x[feature * POLICY_BATCH] = value; };
+
+        int number = card.number;
+        set(POLICY_CARD, number / 104.0f);
+        set(POLICY_BULL_HEADS, card.bullHeads / 7.0f);
+        set(POLICY_UNSEEN_BELOW, (unseen & CardSet::below(number)).size() / 104.0f);
+        set(POLICY_RANK, slot / handSize);
+        set(POLICY_HAND_SIZE, handSize / 10.0f);
+        set(POLICY_OPPONENTS, opponents);
+        set(POLICY_CHEAPEST_ROW, cheapest);
+
+        int target = findBestRow(state, number);
+        if (target == -1) {
+            set(POLICY_FORCED, 1.0f);
+            set(POLICY_FORCED_COST, cheapest);
+            set(POLICY_SIXTH, 0.0f);
+            set(POLICY_SIXTH_COST, 0.0f);
+            set(POLICY_GAP, 0.0f);
+            set(POLICY_ROW_LENGTH, 0.0f);
+            set(POLICY_ROW_PENALTY, 0.0f);
+            set(POLICY_UNSEEN_BETWEEN, 0.0f);
+            set(POLICY_RISK, 0.0f);
+        } else {
+            const Row& row = state.rows[target];
+            bool sixth = row.length == MAX_ROW_LENGTH;
+            int between = (unseen & CardSet::range(row.tail + 1, number - 1)).size();
+            float penalty = row.bullHeads / 10.0f;
+            set(POLICY_FORCED, 0.0f);
+            set(POLICY_FORCED_COST, 0.0f);
+            set(POLICY_SIXTH, sixth ? 1.0f : 0.0f);
+            set(POLICY_SIXTH_COST, sixth ? penalty : 0.0f);
+            set(POLICY_GAP, (number - row.tail) / 104.0f);
+            set(POLICY_ROW_LENGTH, row.length / 5.0f);
+            set(POLICY_ROW_PENALTY, penalty);
+            set(POLICY_UNSEEN_BETWEEN, between / 10.0f);
+            set(POLICY_RISK, sixth ? 0.0f : std::min(1.0f, between / static_cast<float>(MAX_ROW_LENGTH - row.length)));
+        }
+        slot++;
+    }
+    return inputs;
+}
+
+int PolicyAgent::chooseCard(const GameState& state) {
+    evaluatePolicy(*weights, encode(state), scores, useAvx2);
+
+    // Highest score, the lowest card among equals
+    int best = 0;
+    int size = hand.size();
+    for (int i = 1; i < size; ++i) {
+        if (scores[i] > scores[best]) best = i;
+    }
+    return best;
+}
+
+std::unique_ptr<Player> loadPolicyAgent(const std::string& path) {
+    std::ifstream in(path);
+    if (!in) throw std::invalid_argument("cannot read " + path);
+    PolicyWeights weights;
+    try {
+        weights = readPolicyWeights(in);
+    } catch (const std::invalid_argument& e) {
+        throw std::invalid_argument(path + ": " + e.what());
+    }
+    weights.name = "policy:" + path;
+    return std::make_unique<PolicyAgent>(std::make_shared<const PolicyWeights>(std::move(weights)));
+}
+
+SIXNIMMT_REGISTER_AGENT(PolicyAgent);
+
+} // namespace SixNimmt
@@ -1,17 +1,20 @@
 #include "game.h"
-#include <random>
-#include <chrono>
+#include "agent_registry.h"
 
 namespace SixNimmt {
 
 class RandomAgent : public Player {
 private:
-    std::mt19937 rng;
+    Rng rng;
     int playerId;
     int numPlayers;
 
 public:
-    RandomAgent() : rng(std::chrono::steady_clock::now().time_since_epoch().count()) {}
+    RandomAgent() : rng(randomSeed()) {}
+
+    void seed(uint64_t seed) override {
+        rng = Rng(seed);
+    }
 
     void initialize(int playerId, int numPlayers, const std::vector<Card>& initialHand) override {
         this->playerId = playerId;
@@ -21,8 +24,7 @@ public:
 
     int chooseCard(const GameState& state) override {
         // Randomly choose a card from our own hand
-        std::uniform_int_distribution<int> dist(0, hand.size() - 1);
-        return dist(rng);
+        return static_cast<int>(rng.below(hand.size()));
     }
 
     std::string getName() const override {
@@ -30,4 +32,6 @@ public:
     }
 };
 
+SIXNIMMT_REGISTER_AGENT(RandomAgent);
+
 } // namespace SixNimmt
@@ -0,0 +1,523 @@
+#include "remote_agent.h"
+#include "agent_registry.h"
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <new>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <unordered_map>
+
+namespace SixNimmt {
+
+// Layout of the shared memory region. Each index is written by one process
+// only and lives on its own cache line; slots are published by storing the
+// head with release order and consumed after loading it with acquire order.
+// Lock-free std::atomic<uint32_t> is address-free, so it works across
+// processes.
+struct AgentRing {
+    uint32_t magic = AGENT_PROTOCOL_MAGIC;
+    uint32_t version = AGENT_PROTOCOL_VERSION;
+    alignas(64) std::atomic<uint32_t> requestHead{0};    // client
+    alignas(64) std::atomic<uint32_t> requestTail{0};    // host
+    alignas(64) std::atomic<uint32_t> responseHead{0};   // host
+    alignas(64) std::atomic<uint32_t> responseTail{0};   // client
+    WireRequest requests[AGENT_RING_SLOTS];
+    WireResponse responses[AGENT_RING_SLOTS];
+};
+
+static_assert(std::atomic<uint32_t>::is_always_lock_free, "ring indices must be lock-free to be shared");
+static_assert((AGENT_RING_SLOTS & (AGENT_RING_SLOTS - 1)) == 0, "ring size must be a power of two");
+
+void encodeState(const GameState& state, const CardSet& hand, WireRequest& request) {
+    request.handLow = hand.low();
+    request.handHigh = hand.high();
+    request.numPlayers = static_cast<uint8_t>(state.numPlayers);
+    request.roundNumber = static_cast<uint8_t>(state.roundNumber);
+    for (int row = 0; row < NUM_ROWS; ++row) {
+        const Row& r = state.rows[row];
+        request.rowLength[row] = r.length;
+        request.rowPenalty[row] = r.bullHeads;
+        std::memcpy(request.rowCards[row], r.cards.data(), MAX_ROW_LENGTH);
+    }
+    for (int seat = 0; seat < MAX_PLAYERS; ++seat) {
+        request.playedCards[seat] = state.playedCards[seat];
+        request.scores[seat] = static_cast<uint16_t>(state.scores[seat]);
+    }
+}
+
+GameState decodeState(const WireRequest& request) {
+    GameState state;
+    state.numPlayers = request.numPlayers;
+    state.roundNumber = request.roundNumber;
+    for (int row = 0; row < NUM_ROWS; ++row) {
+        Row& r = state.rows[row];
+        r.length = std::min<uint8_t>(request.rowLength[row], MAX_ROW_LENGTH);
+        r.bullHeads = request.rowPenalty[row];
+        std::memcpy(r.cards.data(), request.rowCards[row], MAX_ROW_LENGTH);
+        r.tail = r.length ? r.cards[r.length - 1] : 0;
+    }
+    for (int seat = 0; seat < MAX_PLAYERS; ++seat) {
+        state.playedCards[seat] = request.playedCards[seat];
+        state.scores[seat] = request.scores[seat];
+    }
+    return state;
+}
+
+std::string defaultAgentHostPath(const char* program) {
+    std::string path = program ? program : "";
+    size_t slash = path.rfind('/');
+    return (slash == std::string::npos ? std::string() : path.substr(0, slash + 1)) + "sixnimmt_agent_host";
+}
+
+namespace {
+
+// Blocks until the peer rings; false once it has closed its end
+bool waitForDoorbell(int socket) {
+    char buffer[64];
+    for (;;) {
+        ssize_t received = recv(socket, buffer, sizeof(buffer), 0);
+        if (received > 0) return true;
+        if (received == 0 || errno != EINTR) return false;
+    }
+}
+
+bool ringDoorbell(int socket) {
+    char signal = 1;
+    for (;;) {
+        if (send(socket, &signal, 1, MSG_NOSIGNAL) == 1) return true;
+        if (errno != EINTR) return false;
+    }
+}
+
+} // namespace
+
+AgentConnection::AgentConnection(const std::string& hostPath, const std::string& agentName) : agentName(agentName) {
+    memfd = memfd_create("sixnimmt-agent", MFD_CLOEXEC);
+    if (memfd < 0 || ftruncate(memfd, sizeof(AgentRing)) != 0) {
+        throw std::invalid_argument("cannot create shared memory for " + agentName);
+    }
+    void* mapped = mmap(nullptr, sizeof(AgentRing), PROT_READ | PROT_WRITE, MAP_SHARED, memfd, 0);
+    if (mapped == MAP_FAILED) {
+        close(memfd);
+        throw std::invalid_argument("cannot map shared memory for " + agentName);
+    }
+    ring = new (mapped) AgentRing();
+
+    int sockets[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, sockets) != 0) {
+        munmap(ring, sizeof(AgentRing));
+        close(memfd);
+        throw std::invalid_argument("cannot create the doorbell for " + agentName);
+    }
+    doorbell = sockets[0];
+
+    // Arguments are built before fork: the child may only exec
+    std::string memfdText = std::to_string(memfd);
+    std::string socketText = std::to_string(sockets[1]);
+    const char* argv[] = {hostPath.c_str(), "--agent", agentName.c_str(), "--memfd", memfdText.c_str(),
+                          "--doorbell", socketText.c_str(), nullptr};
+
+    pid = fork();
+    if (pid == 0) {
+        // Only the two descriptors the host needs survive exec
+        fcntl(memfd, F_SETFD, 0);
+        fcntl(sockets[1], F_SETFD, 0);
+        execv(hostPath.c_str(), const_cast<char* const*>(argv));
+        _exit(127);
+    }
+    close(sockets[1]);
+    if (pid < 0) {
+        close(doorbell);
+        munmap(ring, sizeof(AgentRing));
+        close(memfd);
+        throw std::invalid_argument("cannot start " + hostPath);
+    }
+
+    WireRequest hello;
+    WireResponse answer;
+    try {
+        exchange(&hello, 1, &answer);
+    } catch (const std::runtime_error&) {
+        answer.choice = -2;
+    }
+    if (answer.choice != 0) {
+        shutdown();
+        throw std::invalid_argument(answer.choice == -1 ? hostPath + " does not serve " + agentName
+                                                        : "cannot start " + hostPath);
+    }
+}
+
+AgentConnection::~AgentConnection() {
+    shutdown();
+}
+
+void AgentConnection::shutdown() {
+    // Closing the socket ends the host's loop
+    if (doorbell >= 0) close(doorbell);
+    if (pid > 0) waitpid(pid, nullptr, 0);
+    if (ring) munmap(ring, sizeof(AgentRing));
+    if (memfd >= 0) close(memfd);
+    doorbell = memfd = pid = -1;
+    ring = nullptr;
+}
+
+void AgentConnection::exchange(const WireRequest* requests, size_t count, WireResponse* responses) {
+    Submission submission{requests, count, responses, false, nullptr};
+
+    std::unique_lock<std::mutex> lock(mutex);
+    queue.push_back(&submission);
+    while (!submission.done) {
+        if (inFlight) {
+            finished.wait(lock);
+            continue;
+        }
+
+        // Lead a round trip for everything queued so far, ours included
+        inFlight = true;
+        std::vector<Submission*> batch(queue.begin(), queue.end());
+        queue.clear();
+        lock.unlock();
+
+        std::exception_ptr error;
+        try {
+            roundTrip(batch);
+        } catch (...) {
+            error = std::current_exception();
+        }
+
+        lock.lock();
+        for (Submission* done : batch) {
+            done->error = error;
+            done->done = true;
+        }
+        inFlight = false;
+        finished.notify_all();
+    }
+
+    if (submission.error) std::rethrow_exception(submission.error);
+}
+
+void AgentConnection::roundTrip(const std::vector<Submission*>& batch) {
+    // Response slot i of the current chunk goes to destinations[i]
+    std::vector<WireResponse*> destinations;
+    uint32_t head = ring->requestHead.load(std::memory_order_relaxed);
+
+    auto flush = [&] {
+        if (destinations.empty()) return;
+        ring->requestHead.store(head, std::memory_order_release);
+        ringAndWait(destinations.size());
+
+        uint32_t tail = ring->responseTail.load(std::memory_order_relaxed);
+        for (WireResponse* destination : destinations) {
+            *destination = ring->responses[tail++ & (AGENT_RING_SLOTS - 1)];
+        }
+        ring->responseTail.store(tail, std::memory_order_release);
+        roundTrips++;
+        requestsSent += destinations.size();
+        destinations.clear();
+    };
+
+    for (Submission* submission : batch) {
+        for (size_t i = 0; i < submission->count; ++i) {
+            ring->requests[head++ & (AGENT_RING_SLOTS - 1)] = submission->requests[i];
+            destinations.push_back(&submission->responses[i]);
+            if (destinations.size() == AGENT_RING_SLOTS) flush();
+        }
+    }
+    flush();
+}
+
+void AgentConnection::ringAndWait(size_t count) {
+    if (!ringDoorbell(doorbell)) {
+        throw std::runtime_error("agent host for " + agentName + " has exited");
+    }
+    uint32_t expected = ring->responseTail.load(std::memory_order_relaxed) + static_cast<uint32_t>(count);
+    while (ring->responseHead.load(std::memory_order_acquire) != expected) {
+        if (!waitForDoorbell(doorbell)) {
+            throw std::runtime_error("agent host for " + agentName + " has exited");
+        }
+    }
+}
+
+RemoteAgent::RemoteAgent(std::shared_ptr<AgentConnection> connection)
+    : connection(std::move(connection)), game(this->connection->newGameId()) {}
+
+RemoteAgent::~RemoteAgent() {
+    // The host drops the game; nothing is left to report if it has gone
+    try {
+        queue(RequestKind::Close, nullptr);
+        responses.resize(pending.size());
+        connection->exchange(pending.data(), pending.size(), responses.data());
+    } catch (const std::runtime_error&) {
+    }
+}
+
+WireRequest& RemoteAgent::queue(RequestKind kind, const GameState* state) {
+    pending.emplace_back();
+    WireRequest& request = pending.back();
+    if (state) encodeState(*state, hand, request);
+    request.game = game;
+    request.kind = kind;
+    request.seat = static_cast<uint8_t>(playerId);
+    return request;
+}
+
+int RemoteAgent::decide(RequestKind kind, const GameState& state) {
+    queue(kind, &state);
+    responses.resize(pending.size());
+    connection->exchange(pending.data(), pending.size(), responses.data());
+    pending.clear();
+
+    for (const WireResponse& response : responses) {
+        if (response.choice < 0) {
+            throw std::runtime_error("agent host for " + connection->getAgentName() + " rejected a request");
+        }
+    }
+    return responses.back().choice;
+}
+
+void RemoteAgent::initialize(int playerId, int numPlayers, const std::vector<Card>& initialHand) {
+    this->playerId = playerId;
+    this->numPlayers = numPlayers;
+    hand = initialHand;
+    // Anything left over from an abandoned game is stale
+    pending.clear();
+
+    WireRequest& request = queue(RequestKind::Init, nullptr);
+    request.handLow = hand.low();
+    request.handHigh = hand.high();
+    request.seed = agentSeed;
+    request.numPlayers = static_cast<uint8_t>(numPlayers);
+}
+
+int RemoteAgent::chooseCard(const GameState& state) {
+    int card = decide(RequestKind::ChooseCard, state);
+    if (!hand.contains(card)) {
+        throw std::runtime_error("agent host for " + connection->getAgentName() + " played a card it does not hold");
+    }
+    return hand.rank(card);
+}
+
+int RemoteAgent::chooseRowToTake(const GameState& state) {
+    int row = decide(RequestKind::ChooseRow, state);
+    if (row >= NUM_ROWS) {
+        throw std::runtime_error("agent host for " + connection->getAgentName() + " chose a row that does not exist");
+    }
+    return row;
+}
+
+void RemoteAgent::onGameStart(const GameState& state) {
+    queue(RequestKind::GameStart, &state);
+}
+
+void RemoteAgent::onCardsRevealed(const GameState& state) {
+    queue(RequestKind::CardsRevealed, &state);
+}
+
+void RemoteAgent::onRowTaken(const GameState& state, int seat, int row, const Row& taken) {
+    WireRequest& request = queue(RequestKind::RowTaken, &state);
+    request.seat = static_cast<uint8_t>(seat);
+    request.takenRow = static_cast<uint8_t>(row);
+    request.takenLength = taken.length;
+    std::memcpy(request.takenCards, taken.cards.data(), MAX_ROW_LENGTH);
+}
+
+void RemoteAgent::onRoundEnd(const GameState& state) {
+    queue(RequestKind::RoundEnd, &state);
+}
+
+RemoteBatchPolicy::~RemoteBatchPolicy() {
+    try {
+        requests.assign(games.size(), WireRequest());
+        for (size_t i = 0; i < games.size(); ++i) {
+            requests[i].game = games[i];
+            requests[i].kind = RequestKind::Close;
+        }
+        responses.resize(requests.size());
+        connection->exchange(requests.data(), requests.size(), responses.data());
+    } catch (const std::runtime_error&) {
+    }
+}
+
+void RemoteBatchPolicy::encode(const BatchState& batch, int seat, int game, RequestKind kind,
+                               WireRequest& request) const {
+    request = WireRequest();
+    request.game = games[game];
+    request.kind = kind;
+    request.seat = static_cast<uint8_t>(seat);
+    request.numPlayers = static_cast<uint8_t>(batch.numPlayers);
+    request.roundNumber = static_cast<uint8_t>(batch.roundNumber);
+    request.handLow = batch.handLow[batch.at(seat, game)];
+    request.handHigh = batch.handHigh[batch.at(seat, game)];
+    for (int row = 0; row < NUM_ROWS; ++row) {
+        int length = batch.rowLength[row][game];
+        request.rowLength[row] = static_cast<uint8_t>(length);
+        request.rowPenalty[row] = batch.rowPenalty[row][game];
+        request.rowCards[row][length - 1] = batch.rowTail[row][game];
+    }
+    for (int other = 0; other < batch.numPlayers; ++other) {
+        request.scores[other] = batch.scores[batch.at(other, game)];
+    }
+}
+
+void RemoteBatchPolicy::initialize(const BatchState& batch, int seat) {
+    while (games.size() < static_cast<size_t>(batch.numGames)) {
+        games.push_back(connection->newGameId());
+    }
+
+    requests.resize(batch.numGames);
+    responses.resize(batch.numGames);
+    for (int game = 0; game < batch.numGames; ++game) {
+        encode(batch, seat, game, RequestKind::Init, requests[game]);
+        // Seeded like the seat's Player in Game(players, seed)
+        requests[game].seed = deriveSeed(batch.seeds[game], seat + 1);
+    }
+    connection->exchange(requests.data(), batch.numGames, responses.data());
+}
+
+void RemoteBatchPolicy::chooseCards(const BatchState& batch, int seat, uint8_t* cards) {
+    for (int game = 0; game < batch.numGames; ++game) {
+        encode(batch, seat, game, RequestKind::ChooseCard, requests[game]);
+    }
+    connection->exchange(requests.data(), batch.numGames, responses.data());
+
+    for (int game = 0; game < batch.numGames; ++game) {
+        int card = responses[game].choice;
+        CardSet hand(batch.handLow[batch.at(seat, game)], batch.handHigh[batch.at(seat, game)]);
+        if (card <= 0 || !hand.contains(card)) {
+            throw std::runtime_error("agent host for " + connection->getAgentName() + " played a card it does not hold");
+        }
+        cards[game] = static_cast<uint8_t>(card);
+    }
+}
+
+int RemoteBatchPolicy::chooseRowToTake(const BatchState& batch, int seat, int game) {
+    WireRequest request;
+    WireResponse response;
+    encode(batch, seat, game, RequestKind::ChooseRow, request);
+    connection->exchange(&request, 1, &response);
+    if (response.choice < 0 || response.choice >= NUM_ROWS) {
+        throw std::runtime_error("agent host for " + connection->getAgentName() + " chose a row that does not exist");
+    }
+    return response.choice;
+}
+
+namespace {
+
+// The host's copy of one game: the agent and which events it has seen
+class HostedGames {
+public:
+    explicit HostedGames(const std::string& agentName) : agentName(agentName) {}
+
+    // Answer to one request: a card, a row, 0 for done or -1 for an error
+    int handle(const WireRequest& request) {
+        if (request.kind == RequestKind::Hello) {
+            return AgentRegistry::instance().contains(agentName) ? 0 : -1;
+        }
+        if (request.kind == RequestKind::Close) {
+            games.erase(request.game);
+            return 0;
+        }
+
+        std::unique_ptr<Player>& player = games[request.game];
+        if (request.kind == RequestKind::Init) {
+            if (!player) player = AgentRegistry::instance().create(agentName);
+            if (!player || request.numPlayers < 2 || request.numPlayers > MAX_PLAYERS) return -1;
+            CardSet hand(request.handLow, request.handHigh);
+            player->seed(request.seed);
+            std::vector<Card> cards;
+            for (const Card& card : hand) cards.push_back(card);
+            player->initialize(request.seat, request.numPlayers, cards);
+            return 0;
+        }
+        if (!player) {
+            games.erase(request.game);
+            return -1;
+        }
+
+        GameState state = decodeState(request);
+        switch (request.kind) {
+        case RequestKind::GameStart:
+            player->onGameStart(state);
+            return 0;
+        case RequestKind::CardsRevealed: {
+            // The card the engine played, which is not the agent's choice
+            // when a move limit replaced it; the engine has taken it from
+            // the hand by now
+            int played = state.playedCards[request.seat];
+            if (!player->getHand().contains(played)) return -1;
+            player->removeCard(player->getHand().rank(played));
+            player->onCardsRevealed(state);
+            return 0;
+        }
+        case RequestKind::RowTaken: {
+            Row taken;
+            for (int i = 0; i < std::min<int>(request.takenLength, MAX_ROW_LENGTH); ++i) {
+                taken.push(Card(request.takenCards[i]));
+            }
+            player->onRowTaken(state, request.seat, request.takenRow, taken);
+            return 0;
+        }
+        case RequestKind::RoundEnd:
+            player->onRoundEnd(state);
+            return 0;
+        case RequestKind::ChooseCard: {
+            // Batch games send no CardsRevealed, so the cards played since
+            // the last request are dropped here. Any other difference
+            // means the two sides have lost track.
+            CardSet hand(request.handLow, request.handHigh);
+            CardSet played = player->getHand() - hand;
+            if (!(hand - player->getHand()).empty()) return -1;
+            for (const Card& card : played) player->removeCard(player->getHand().rank(card.number));
+            int index = player->chooseCard(state);
+            if (index < 0 || index >= player->getHand().size()) return -1;
+            return player->getHand().select(index);
+        }
+        case RequestKind::ChooseRow: {
+            int row = player->chooseRowToTake(state);
+            return row >= 0 && row < NUM_ROWS ? row : -1;
+        }
+        default:
+            return -1;
+        }
+    }
+
+private:
+    std::string agentName;
+    std::unordered_map<uint32_t, std::unique_ptr<Player>> games;
+};
+
+} // namespace
+
+int serveAgent(const std::string& agentName, int memfd, int doorbell) {
+    void* mapped = mmap(nullptr, sizeof(AgentRing), PROT_READ | PROT_WRITE, MAP_SHARED, memfd, 0);
+    if (mapped == MAP_FAILED) return 1;
+    AgentRing* ring = static_cast<AgentRing*>(mapped);
+    if (ring->magic != AGENT_PROTOCOL_MAGIC || ring->version != AGENT_PROTOCOL_VERSION) return 1;
+
+    HostedGames games(agentName);
+    while (waitForDoorbell(doorbell)) {
+        // Answer everything published so far, then ring once
+        uint32_t head = ring->requestHead.load(std::memory_order_acquire);
+        uint32_t tail = ring->requestTail.load(std::memory_order_relaxed);
+        uint32_t responseHead = ring->responseHead.load(std::memory_order_relaxed);
+        for (; tail != head; ++tail) {
+            const WireRequest& request = ring->requests[tail & (AGENT_RING_SLOTS - 1)];
+            WireResponse& response = ring->responses[responseHead++ & (AGENT_RING_SLOTS - 1)];
+            response.game = request.game;
+            response.choice = games.handle(request);
+        }
+        ring->requestTail.store(tail, std::memory_order_release);
+        ring->responseHead.store(responseHead, std::memory_order_release);
+        if (!ringDoorbell(doorbell)) break;
+    }
+
+    munmap(mapped, sizeof(AgentRing));
+    return 0;
+}
+
+} // namespace SixNimmt
@@ -0,0 +1,290 @@
+#include "self_play.h"
+#include "agent_registry.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+namespace SixNimmt {
+
+void encodeFeatures(const GameState& state, const SeatView& view, uint8_t* features) {
+    std::fill(features, features + SELF_PLAY_FEATURES, 0);
+    for (int row = 0; row < NUM_ROWS; ++row) {
+        features[FEATURE_ROW_TAILS + row] = state.rows[row].tail;
+        features[FEATURE_ROW_LENGTHS + row] = state.rows[row].length;
+        features[FEATURE_ROW_PENALTIES + row] = state.rows[row].bullHeads;
+    }
+    for (Card card : view.hand) features[FEATURE_HAND + card.number - 1] = 1;
+    for (Card card : view.unseen) features[FEATURE_UNSEEN + card.number - 1] = 1;
+    for (int seat = 0; seat < state.numPlayers; ++seat) {
+        features[FEATURE_SCORES + seat] = static_cast<uint8_t>(std::min(state.scores[seat], 255));
+        features[FEATURE_ROWS_TAKEN + seat] = view.rowsTaken[seat];
+    }
+    features[FEATURE_ROUND] = static_cast<uint8_t>(state.roundNumber);
+    features[FEATURE_NUM_PLAYERS] = static_cast<uint8_t>(state.numPlayers);
+    features[FEATURE_SEAT] = static_cast<uint8_t>(view.seat);
+}
+
+std::string selfPlayNpyHeader(size_t records) {
+    std::string header = "{'descr': [('game', '<u4'), ('final_score', '<i2'), ('final_margin', '<i2'), "
+                         "('action', 'u1'), ('features', 'u1', (" +
+                         std::to_string(SELF_PLAY_FEATURES) + ",))], 'fortran_order': False, 'shape': (" +
+                         std::to_string(records) + ",), }";
+    // Magic, version and length take 10 bytes; pad so the data starts on a
+    // 64-byte boundary, ending the header with a newline
+    size_t total = (10 + header.size() + 1 + 63) / 64 * 64;
+    header.append(total - 10 - header.size() - 1, ' ');
+    header += '\n';
+
+    std::string prefix = "\x93NUMPY";
+    prefix += '\x01';
+    prefix += '\x00';
+    prefix += static_cast<char>(header.size() & 0xff);
+    prefix += static_cast<char>(header.size() >> 8);
+    return prefix + header;
+}
+
+std::string selfPlayChunkPath(const std::string& prefix, long chunk) {
+    char number[32];
+    std::snprintf(number, sizeof(number), "_%05ld.npy", chunk);
+    return prefix + number;
+}
+
+namespace {
+
+// Wraps one seat's agent, recording its card decisions. It keeps its own
+// SeatView rather than a KnowledgeState, whose per-round risk tables would
+// cost more than the rest of the recording.
+class RecordingPlayer : public Player {
+public:
+    void attach(std::unique_ptr<Player> agent, std::vector<SelfPlayRecord>* records, uint32_t game) {
+        this->agent = std::move(agent);
+        this->records = records;
+        this->game = game;
+    }
+    std::unique_ptr<Player> detach() { return std::move(agent); }
+
+    void seed(uint64_t seed) override { agent->seed(seed); }
+
+    void initialize(int playerId, int numPlayers, const std::vector<Card>& initialHand) override {
+        this->playerId = playerId;
+        this->numPlayers = numPlayers;
+        hand = initialHand;
+        view.seat = playerId;
+        view.hand = hand;
+        view.unseen = ~hand;
+        view.rowsTaken.fill(0);
+        agent->initialize(playerId, numPlayers, initialHand);
+    }
+
+    int chooseCard(const GameState& state) override {
+        records->emplace_back();
+        SelfPlayRecord& record = records->back();
+        record.game = game;
+        view.hand = hand;
+        encodeFeatures(state, view, record.features);
+
+        int index = agent->chooseCard(state);
+        record.action = static_cast<uint8_t>(hand.select(index));
+        agent->removeCard(index);
+        return index;
+    }
+
+    int chooseRowToTake(const GameState& state) override { return agent->chooseRowToTake(state); }
+
+    void onGameStart(const GameState& state) override {
+        for (const Row& row : state.rows) view.unseen.erase(row.tail);
+        agent->onGameStart(state);
+    }
+    void onCardsRevealed(const GameState& state) override {
+        for (int seat = 0; seat < state.numPlayers; ++seat) view.unseen.erase(state.playedCards[seat]);
+        agent->onCardsRevealed(state);
+    }
+    void onRowTaken(const GameState& state, int seat, int row, const Row& taken) override {
+        view.rowsTaken[seat]++;
+        agent->onRowTaken(state, seat, row, taken);
+    }
+    void onRoundEnd(const GameState& state) override { agent->onRoundEnd(state); }
+    void onMoveReplaced(const GameState& state, int choice) override { agent->onMoveReplaced(state, choice); }
+
+    std::string getName() const override { return agent->getName(); }
+
+private:
+    std::unique_ptr<Player> agent;
+    SeatView view;
+    std::vector<SelfPlayRecord>* records = nullptr;
+    uint32_t game = 0;
+};
+
+// Writes finished chunks on its own thread. push() blocks while the queue
+// is full, so a slow disk holds the workers back instead of memory growing.
+class ChunkWriter {
+public:
+    ChunkWriter(std::string prefix, size_t capacity)
+        : prefix(std::move(prefix)), capacity(capacity), thread([this] { run(); }) {}
+
+    // After an exception elsewhere: stop without reporting write errors
+    ~ChunkWriter() {
+        try {
+            finish();
+        } catch (...) {
+        }
+    }
+
+    // Rethrows a write error, so the workers stop early
+    void push(long chunk, std::vector<SelfPlayRecord> records) {
+        std::unique_lock<std::mutex> lock(mutex);
+        spaceFree.wait(lock, [&] { return queue.size() < capacity || error; });
+        if (error) std::rethrow_exception(error);
+        queue.emplace_back(chunk, std::move(records));
+        itemReady.notify_one();
+    }
+
+    // Writes what is queued and stops; rethrows the first write error
+    void finish() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (stopping) return;
+            stopping = true;
+        }
+        itemReady.notify_one();
+        thread.join();
+        if (error) std::rethrow_exception(error);
+    }
+
+private:
+    std::string prefix;
+    size_t capacity;
+    std::mutex mutex;
+    std::condition_variable itemReady;
+    std::condition_variable spaceFree;
+    std::deque<std::pair<long, std::vector<SelfPlayRecord>>> queue;
+    bool stopping = false;
+    std::exception_ptr error;
+    std::thread thread;   // last, so it starts after the rest is constructed
+
+    void run() {
+        for (;;) {
+            std::pair<long, std::vector<SelfPlayRecord>> item;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                itemReady.wait(lock, [&] { return !queue.empty() || stopping; });
+                if (queue.empty()) return;
+                item = std::move(queue.front());
+                queue.pop_front();
+            }
+            spaceFree.notify_one();
+
+            try {
+                write(item.first, item.second);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(mutex);
+                error = std::current_exception();
+                queue.clear();
+                spaceFree.notify_all();
+                return;
+            }
+        }
+    }
+
+    void write(long chunk, const std::vector<SelfPlayRecord>& records) const {
+        std::string path = selfPlayChunkPath(prefix, chunk);
+        std::FILE* file = std::fopen(path.c_str(), "wb");
+        if (!file) throw std::runtime_error("cannot write " + path);
+        std::string header = selfPlayNpyHeader(records.size());
+        bool ok = std::fwrite(header.data(), 1, header.size(), file) == header.size() &&
+                  std::fwrite(records.data(), sizeof(SelfPlayRecord), records.size(), file) == records.size();
+        ok = std::fclose(file) == 0 && ok;
+        if (!ok) throw std::runtime_error("cannot write " + path);
+    }
+};
+
+} // namespace
+
+SelfPlaySummary generateSelfPlay(const SelfPlaySettings& settings) {
+    if (settings.agents.empty()) throw std::invalid_argument("no agents given");
+    for (const std::string& name : settings.agents) {
+        if (!AgentRegistry::instance().contains(name)) throw std::invalid_argument("unknown agent " + name);
+    }
+    if (settings.numPlayers < 2 || settings.numPlayers > MAX_PLAYERS) {
+        throw std::invalid_argument("players must be between 2 and " + std::to_string(MAX_PLAYERS));
+    }
+    if (settings.numGames <= 0 || settings.gamesPerChunk <= 0) {
+        throw std::invalid_argument("games and games per chunk must be positive");
+    }
+    if (settings.outputPrefix.empty()) throw std::invalid_argument("no output prefix given");
+
+    long numChunks = (settings.numGames + settings.gamesPerChunk - 1) / settings.gamesPerChunk;
+    ThreadPool pool(settings.numThreads);
+    size_t pending = settings.maxPendingChunks > 0 ? settings.maxPendingChunks : 2 * pool.size();
+    ChunkWriter writer(settings.outputPrefix, pending);
+
+    int numPlayers = settings.numPlayers;
+    size_t numAgents = settings.agents.size();
+    std::vector<long> decisions(pool.size(), 0);
+
+    pool.parallelFor(numChunks, [&](int worker, size_t chunk) {
+        long firstGame = static_cast<long>(chunk) * settings.gamesPerChunk;
+        long endGame = std::min(settings.numGames, firstGame + settings.gamesPerChunk);
+
+        std::vector<SelfPlayRecord> records;
+        records.reserve(static_cast<size_t>(endGame - firstGame) * numPlayers * HAND_SIZE);
+
+        // Agent instances by name, reused from game to game; initialize()
+        // resets them
+        std::vector<std::vector<std::unique_ptr<Player>>> spare(numAgents);
+        std::vector<std::unique_ptr<Player>> seats;
+        for (int seat = 0; seat < numPlayers; ++seat) seats.push_back(std::make_unique<RecordingPlayer>());
+
+        for (long game = firstGame; game < endGame; ++game) {
+            for (int seat = 0; seat < numPlayers; ++seat) {
+                size_t agent = (game + seat) % numAgents;
+                std::unique_ptr<Player> player;
+                if (spare[agent].empty()) {
+                    player = AgentRegistry::instance().create(settings.agents[agent]);
+                } else {
+                    player = std::move(spare[agent].back());
+                    spare[agent].pop_back();
+                }
+                static_cast<RecordingPlayer&>(*seats[seat]).attach(std::move(player), &records,
+                                                                   static_cast<uint32_t>(game));
+            }
+
+            size_t first = records.size();
+            Game match(std::move(seats), deriveSeed(settings.seed, game));
+            std::vector<int> scores = match.playGame(false);
+            seats = match.releasePlayers();
+
+            int total = 0;
+            for (int score : scores) total += score;
+            for (size_t i = first; i < records.size(); ++i) {
+                int seat = records[i].features[FEATURE_SEAT];
+                records[i].finalScore = static_cast<int16_t>(scores[seat]);
+                records[i].finalMargin = static_cast<int16_t>(scores[seat] * numPlayers - total);
+            }
+
+            for (int seat = 0; seat < numPlayers; ++seat) {
+                spare[(game + seat) % numAgents].push_back(static_cast<RecordingPlayer&>(*seats[seat]).detach());
+            }
+        }
+
+        decisions[worker] += static_cast<long>(records.size());
+        writer.push(static_cast<long>(chunk), std::move(records));
+    });
+    writer.finish();
+
+    SelfPlaySummary summary;
+    summary.games = settings.numGames;
+    for (long count : decisions) summary.decisions += count;
+    for (long chunk = 0; chunk < numChunks; ++chunk) {
+        summary.files.push_back(selfPlayChunkPath(settings.outputPrefix, chunk));
+    }
+    return summary;
+}
+
+} // namespace SixNimmt
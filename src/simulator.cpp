@@ -0,0 +1,28 @@
+#include "simulator.h"
+
+namespace SixNimmt {
+
+void playRound(SimState& sim, const RoundCards& cards) {
+    for (int seat = 0; seat < sim.numPlayers(); ++seat) {
+        assert(sim.hands[seat].contains(cards[seat]));
+        sim.hands[seat].erase(cards[seat]);
+    }
+    resolveRound(sim.table, cards);
+}
+
+int randomRolloutCard(const SimState& sim, int seat, Rng& rng) {
+    const CardSet& hand = sim.hands[seat];
+    return hand.select(static_cast<int>(rng.below(hand.size())));
+}
+
+void playOut(SimState& sim, RolloutPolicy policy, Rng& rng) {
+    RoundCards cards{};
+    while (sim.roundsLeft() > 0) {
+        for (int seat = 0; seat < sim.numPlayers(); ++seat) {
+            cards[seat] = static_cast<uint8_t>(policy(sim, seat, rng));
+        }
+        playRound(sim, cards);
+    }
+}
+
+} // namespace SixNimmt
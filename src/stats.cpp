@@ -0,0 +1,327 @@
+#include "stats.h"
+#include "rng.h"
+#include <algorithm>
+#include <cmath>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+
+namespace SixNimmt {
+
+void RunningStats::add(double value) {
+    n++;
+    if (n == 1) {
+        minimum = maximum = value;
+    } else {
+        minimum = std::min(minimum, value);
+        maximum = std::max(maximum, value);
+    }
+    double delta = value - average;
+    average += delta / n;
+    squares += delta * (value - average);
+}
+
+void RunningStats::add(const RunningStats& other) {
+    if (other.n == 0) return;
+    if (n == 0) {
+        *this = other;
+        return;
+    }
+    long combined = n + other.n;
+    double delta = other.average - average;
+    average += delta * other.n / combined;
+    squares += other.squares + delta * delta * (static_cast<double>(n) * other.n / combined);
+    minimum = std::min(minimum, other.minimum);
+    maximum = std::max(maximum, other.maximum);
+    n = combined;
+}
+
+double RunningStats::stddev() const {
+    return std::sqrt(variance());
+}
+
+double RunningStats::standardError() const {
+    return n > 0 ? std::sqrt(variance() / n) : 0.0;
+}
+
+void ScoreHistogram::add(int score, long weight) {
+    counts[std::min(std::max(score, 0), MAX_BIN)] += weight;
+    total += weight;
+    sum += score * weight;
+    squares += static_cast<long>(score) * score * weight;
+}
+
+void ScoreHistogram::add(const ScoreHistogram& other) {
+    for (int i = 0; i <= MAX_BIN; ++i) counts[i] += other.counts[i];
+    total += other.total;
+    sum += other.sum;
+    squares += other.squares;
+}
+
+double ScoreHistogram::variance() const {
+    if (total < 2) return 0.0;
+    double mean = this->mean();
+    return std::max(0.0, (static_cast<double>(squares) - total * mean * mean) / (total - 1));
+}
+
+double ScoreHistogram::stddev() const {
+    return std::sqrt(variance());
+}
+
+int ScoreHistogram::percentile(double p) const {
+    if (total == 0) return 0;
+    long rank = std::max(1L, static_cast<long>(std::ceil(p / 100.0 * total)));
+    long seen = 0;
+    for (int score = 0; score <= MAX_BIN; ++score) {
+        seen += counts[score];
+        if (seen >= rank) return score;
+    }
+    return MAX_BIN;
+}
+
+void PairwiseMatrix::addGame(const int* seatAgents, const int* scores, int numSeats, long weight) {
+    for (int a = 0; a < numSeats; ++a) {
+        for (int b = a + 1; b < numSeats; ++b) {
+            int first = seatAgents[a];
+            int second = seatAgents[b];
+            if (scores[a] < scores[b]) {
+                halfPoints[first * agents + second] += 2 * weight;
+            } else if (scores[a] > scores[b]) {
+                halfPoints[second * agents + first] += 2 * weight;
+            } else {
+                halfPoints[first * agents + second] += weight;
+                halfPoints[second * agents + first] += weight;
+            }
+        }
+    }
+}
+
+void PairwiseMatrix::add(const PairwiseMatrix& other) {
+    for (size_t i = 0; i < halfPoints.size(); ++i) halfPoints[i] += other.halfPoints[i];
+}
+
+double PairwiseMatrix::score(int agent, int opponent) const {
+    long total = getHalfPoints(agent, opponent) + getHalfPoints(opponent, agent);
+    return total ? static_cast<double>(getHalfPoints(agent, opponent)) / total : 0.5;
+}
+
+std::vector<double> PairwiseMatrix::eloRatings() const {
+    // Points (with the virtual ties) and games per pair
+    std::vector<double> points(agents, 0.0);
+    std::vector<double> games(agents * agents, 0.0);
+    for (int i = 0; i < agents; ++i) {
+        for (int j = 0; j < agents; ++j) {
+            if (i == j || this->games(i, j) == 0) continue;
+            points[i] += getHalfPoints(i, j) / 2.0 + 0.5;
+            games[i * agents + j] = this->games(i, j) + 1.0;
+        }
+    }
+
+    // Minorization-maximization (Hunter 2004): strength_i = points_i /
+    // sum_j games_ij / (strength_i + strength_j), renormalized every pass
+    std::vector<double> strength(agents, 1.0);
+    std::vector<double> next(agents);
+    for (int iteration = 0; iteration < 10000; ++iteration) {
+        double logSum = 0.0;
+        for (int i = 0; i < agents; ++i) {
+            double denominator = 0.0;
+            for (int j = 0; j < agents; ++j) {
+                if (games[i * agents + j] > 0.0) denominator += games[i * agents + j] / (strength[i] + strength[j]);
+            }
+            next[i] = denominator > 0.0 ? points[i] / denominator : 1.0;
+            logSum += std::log(next[i]);
+        }
+
+        double scale = std::exp(-logSum / std::max(1, agents));
+        double change = 0.0;
+        for (int i = 0; i < agents; ++i) {
+            next[i] *= scale;
+            change = std::max(change, std::abs(std::log(next[i] / strength[i])));
+        }
+        strength.swap(next);
+        if (change < 1e-10) break;
+    }
+
+    std::vector<double> ratings(agents);
+    for (int i = 0; i < agents; ++i) {
+        ratings[i] = 400.0 * std::log10(strength[i]);
+    }
+    return ratings;
+}
+
+namespace {
+
+// Poisson(1) by inversion of its CDF
+int poissonWeight(Rng& rng) {
+    static constexpr double CDF[] = {0.36787944117144233, 0.73575888234288467, 0.91969860292860584,
+                                     0.98101184312384626, 0.99634015317265634, 0.99940581518241813,
+                                     0.99991675885071177, 0.99998975080332288, 0.99999887479739843};
+    double u = rng.uniform();
+    int k = 0;
+    while (k < 9 && u >= CDF[k]) k++;
+    return k;
+}
+
+// Central interval of the values at the given level
+TournamentStats::Interval centralInterval(std::vector<double> values, double level) {
+    if (values.empty()) return {};
+    std::sort(values.begin(), values.end());
+    double tail = (1.0 - level) / 2.0 * (values.size() - 1);
+    return {values[static_cast<size_t>(std::floor(tail))],
+            values[static_cast<size_t>(std::ceil(values.size() - 1 - tail))]};
+}
+
+} // namespace
+
+TournamentStats::TournamentStats(int numAgents, int bootstrapReplicates)
+    : agents(numAgents),
+      replicates(bootstrapReplicates),
+      scores(numAgents),
+      pairwise(numAgents),
+      replicatePairwise(bootstrapReplicates, PairwiseMatrix(numAgents)),
+      replicateScoreSums(static_cast<size_t>(bootstrapReplicates) * numAgents, 0),
+      replicateGames(static_cast<size_t>(bootstrapReplicates) * numAgents, 0) {}
+
+void TournamentStats::addGame(const int* seatAgents, const int* seatScores, int numSeats, uint64_t resampleSeed) {
+    for (int seat = 0; seat < numSeats; ++seat) {
+        scores[seatAgents[seat]].add(seatScores[seat]);
+    }
+    pairwise.addGame(seatAgents, seatScores, numSeats);
+
+    Rng rng(resampleSeed);
+    for (int r = 0; r < replicates; ++r) {
+        int weight = poissonWeight(rng);
+        if (weight == 0) continue;
+        replicatePairwise[r].addGame(seatAgents, seatScores, numSeats, weight);
+        for (int seat = 0; seat < numSeats; ++seat) {
+            replicateScoreSums[r * agents + seatAgents[seat]] += static_cast<long>(seatScores[seat]) * weight;
+            replicateGames[r * agents + seatAgents[seat]] += weight;
+        }
+    }
+}
+
+void TournamentStats::add(const TournamentStats& other) {
+    for (int agent = 0; agent < agents; ++agent) {
+        scores[agent].add(other.scores[agent]);
+    }
+    pairwise.add(other.pairwise);
+    for (int r = 0; r < replicates; ++r) {
+        replicatePairwise[r].add(other.replicatePairwise[r]);
+    }
+    for (size_t i = 0; i < replicateScoreSums.size(); ++i) {
+        replicateScoreSums[i] += other.replicateScoreSums[i];
+        replicateGames[i] += other.replicateGames[i];
+    }
+}
+
+std::vector<std::vector<double>> TournamentStats::replicateElo() const {
+    std::vector<std::vector<double>> ratings;
+    for (const PairwiseMatrix& matrix : replicatePairwise) {
+        ratings.push_back(matrix.eloRatings());
+    }
+    return ratings;
+}
+
+std::vector<TournamentStats::Interval> TournamentStats::eloIntervals(double level) const {
+    std::vector<std::vector<double>> ratings = replicateElo();
+    std::vector<double> elo = eloRatings();
+    std::vector<Interval> intervals(agents);
+    for (int agent = 0; agent < agents; ++agent) {
+        std::vector<double> values;
+        for (const auto& replicate : ratings) values.push_back(replicate[agent]);
+        intervals[agent] = values.empty() ? Interval{elo[agent], elo[agent]} : centralInterval(values, level);
+    }
+    return intervals;
+}
+
+std::vector<double> TournamentStats::eloStandardErrors() const {
+    std::vector<RunningStats> spread(agents);
+    for (const auto& replicate : replicateElo()) {
+        for (int agent = 0; agent < agents; ++agent) spread[agent].add(replicate[agent]);
+    }
+    std::vector<double> errors(agents);
+    for (int agent = 0; agent < agents; ++agent) errors[agent] = spread[agent].stddev();
+    return errors;
+}
+
+std::vector<TournamentStats::Interval> TournamentStats::averageScoreIntervals(double level) const {
+    std::vector<Interval> intervals(agents);
+    for (int agent = 0; agent < agents; ++agent) {
+        std::vector<double> values;
+        for (int r = 0; r < replicates; ++r) {
+            long games = replicateGames[r * agents + agent];
+            if (games) values.push_back(static_cast<double>(replicateScoreSums[r * agents + agent]) / games);
+        }
+        double mean = scores[agent].mean();
+        intervals[agent] = values.empty() ? Interval{mean, mean} : centralInterval(values, level);
+    }
+    return intervals;
+}
+
+void TournamentStats::write(std::ostream& out) const {
+    out << agents << " " << replicates << "\n";
+    for (const ScoreHistogram& histogram : scores) {
+        // Sparse: number of nonempty bins, then score and count pairs
+        int used = static_cast<int>(std::count_if(histogram.counts.begin(), histogram.counts.end(),
+                                                  [](long count) { return count != 0; }));
+        out << histogram.total << " " << histogram.sum << " " << histogram.squares << " " << used;
+        for (int score = 0; score <= ScoreHistogram::MAX_BIN; ++score) {
+            if (histogram.counts[score]) out << " " << score << " " << histogram.counts[score];
+        }
+        out << "\n";
+    }
+    auto writeMatrix = [&](const PairwiseMatrix& matrix) {
+        for (size_t i = 0; i < matrix.halfPoints.size(); ++i) out << (i ? " " : "") << matrix.halfPoints[i];
+        out << "\n";
+    };
+    writeMatrix(pairwise);
+    for (int r = 0; r < replicates; ++r) {
+        writeMatrix(replicatePairwise[r]);
+        for (int agent = 0; agent < agents; ++agent) {
+            out << (agent ? " " : "") << replicateScoreSums[r * agents + agent] << " "
+                << replicateGames[r * agents + agent];
+        }
+        out << "\n";
+    }
+}
+
+TournamentStats TournamentStats::read(std::istream& in) {
+    auto next = [&]() {
+        long value;
+        if (!(in >> value)) throw std::invalid_argument("statistics: truncated data");
+        return value;
+    };
+
+    long numAgents = next();
+    long numReplicates = next();
+    if (numAgents < 0 || numAgents > 1000 || numReplicates < 0 || numReplicates > 100000) {
+        throw std::invalid_argument("statistics: bad dimensions");
+    }
+    TournamentStats stats(static_cast<int>(numAgents), static_cast<int>(numReplicates));
+
+    for (ScoreHistogram& histogram : stats.scores) {
+        histogram.total = next();
+        histogram.sum = next();
+        histogram.squares = next();
+        long used = next();
+        for (long i = 0; i < used; ++i) {
+            long score = next();
+            if (score < 0 || score > ScoreHistogram::MAX_BIN) throw std::invalid_argument("statistics: bad score");
+            histogram.counts[score] = next();
+        }
+    }
+    auto readMatrix = [&](PairwiseMatrix& matrix) {
+        for (long& value : matrix.halfPoints) value = next();
+    };
+    readMatrix(stats.pairwise);
+    for (int r = 0; r < stats.replicates; ++r) {
+        readMatrix(stats.replicatePairwise[r]);
+        for (int agent = 0; agent < stats.agents; ++agent) {
+            stats.replicateScoreSums[r * stats.agents + agent] = next();
+            stats.replicateGames[r * stats.agents + agent] = next();
+        }
+    }
+    return stats;
+}
+
+} // namespace SixNimmt
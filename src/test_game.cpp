@@ -3,9 +3,1227 @@
 #include "lowest_card_first_agent.cpp"
 #include "highest_card_first_agent.cpp"
 #include "bulls_heads_first_agent.cpp"
+#include "batch_engine.h"
+#include "game_log.h"
+#include "endgame_solver.h"
+#include "knowledge.h"
+#include "eval_cache.h"
+#include "thread_pool.h"
+#include "tournament.h"
+#include "agent_registry.h"
+#include "remote_agent.h"
+#include "plugin_loader.h"
+#include "self_play.h"
+#include "policy_agent.h"
+#include "monte_carlo_agent.h"
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <set>
+#include <sstream>
+#include <thread>
+#include <sys/wait.h>
 #include <iostream>
 
-int main() {
+namespace SixNimmt {
+
+// CardSet against a std::set model under random inserts and erases, always
+// touching cards 63, 64 and 65 on either side of the word boundary
+bool cardSetMatchesModel() {
+    Rng rng(5);
+    for (int trial = 0; trial < 200; ++trial) {
+        CardSet cards;
+        std::set<int> model;
+        for (int step = 0; step < 80; ++step) {
+            int number = step < 3 ? 63 + step : 1 + static_cast<int>(rng.below(DECK_SIZE));
+            if (rng.below(3) == 0) {
+                cards.erase(number);
+                model.erase(number);
+            } else {
+                cards.insert(number);
+                model.insert(number);
+            }
+
+            std::vector<int> iterated;
+            for (const Card& card : cards) iterated.push_back(card.number);
+            if (iterated != std::vector<int>(model.begin(), model.end()) ||
+                cards.size() != static_cast<int>(model.size()) || cards.empty() != model.empty()) {
+                std::cout << "CardSet contents differ from the model" << std::endl;
+                return false;
+            }
+            if (!model.empty() && (cards.lowest() != *model.begin() || cards.highest() != *model.rbegin())) {
+                std::cout << "CardSet lowest/highest differ from the model" << std::endl;
+                return false;
+            }
+
+            for (int n = 0; n <= DECK_SIZE + 1; ++n) {
+                int below = static_cast<int>(std::distance(model.begin(), model.lower_bound(n)));
+                if ((n >= 1 && n <= DECK_SIZE && cards.contains(n) != (model.count(n) == 1)) ||
+                    cards.rank(n) != below) {
+                    std::cout << "CardSet contains/rank differ from the model at " << n << std::endl;
+                    return false;
+                }
+            }
+            for (int index = 0; index < static_cast<int>(iterated.size()); ++index) {
+                if (cards.select(index) != iterated[index] || cards.rank(iterated[index]) != index) {
+                    std::cout << "CardSet select differs from the model at index " << index << std::endl;
+                    return false;
+                }
+            }
+        }
+    }
+
+    for (int first = 0; first <= DECK_SIZE + 1; ++first) {
+        std::vector<int> below;
+        for (int n = 1; n < first && n <= DECK_SIZE; ++n) below.push_back(n);
+        if (CardSet::below(first).toVector().size() != below.size() ||
+            (!below.empty() && CardSet::below(first).highest() != below.back())) {
+            std::cout << "CardSet::below(" << first << ") is wrong" << std::endl;
+            return false;
+        }
+        for (int last : {first - 1, first, 62, 63, 64, 65, DECK_SIZE}) {
+            CardSet range = CardSet::range(first, last);
+            int expected = std::max(0, std::min(last, DECK_SIZE) - std::max(first, 1) + 1);
+            if (range.size() != expected || (expected > 0 && (range.lowest() != std::max(first, 1) ||
+                                                                range.highest() != std::min(last, DECK_SIZE)))) {
+                std::cout << "CardSet::range(" << first << ", " << last << ") is wrong" << std::endl;
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// The branchless findBestRow, and placeCards, against a scalar scan for
+// the closest lower tail on random tables
+bool findBestRowMatchesScan() {
+    Rng rng(6);
+    for (int trial = 0; trial < 2000; ++trial) {
+        GameState state;
+        CardSet tails;
+        for (int row = 0; row < NUM_ROWS; ++row) {
+            int tail;
+            do {
+                tail = 1 + static_cast<int>(rng.below(DECK_SIZE));
+            } while (tails.contains(tail));
+            tails.insert(tail);
+            state.rows[row].reset(Card(tail));
+        }
+
+        RowPlacement placement = placeCards(state, ~tails);
+        for (int number = 1; number <= DECK_SIZE; ++number) {
+            if (tails.contains(number)) continue;
+            int expected = -1;
+            for (int row = 0; row < NUM_ROWS; ++row) {
+                int tail = state.rows[row].tail;
+                if (tail < number && (expected == -1 || tail > state.rows[expected].tail)) expected = row;
+            }
+            bool placed = expected == -1 ? placement.forcedTake.contains(number)
+                                         : placement.byRow[expected].contains(number);
+            if (findBestRow(state, number) != expected || !placed) {
+                std::cout << "findBestRow(" << number << ") differs from the scan" << std::endl;
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// Plays the same seeds through Game and BatchEngine and compares every score
+bool batchEngineMatchesGame() {
+    const std::vector<std::string> agents = {
+        "LowestCardFirstAgent", "HighestCardFirstAgent", "BullsHeadsFirstAgent", "RandomAgent"};
+
+    for (int numPlayers = 2; numPlayers <= MAX_PLAYERS; ++numPlayers) {
+        std::vector<uint64_t> seeds;
+        for (int game = 0; game < 100; ++game) {
+            seeds.push_back(deriveSeed(numPlayers, game));
+        }
+
+        std::vector<std::unique_ptr<BatchPolicy>> policies;
+        for (int seat = 0; seat < numPlayers; ++seat) {
+            policies.push_back(createBatchPolicy(agents[seat % agents.size()]));
+        }
+        BatchEngine batch(std::move(policies), seeds);
+        batch.playGames();
+
+        for (size_t game = 0; game < seeds.size(); ++game) {
+            std::vector<std::unique_ptr<Player>> players;
+            for (int seat = 0; seat < numPlayers; ++seat) {
+                players.push_back(AgentRegistry::instance().create(agents[seat % agents.size()]));
+            }
+            std::vector<int> scores = Game(std::move(players), seeds[game]).playGame(false);
+
+            for (int seat = 0; seat < numPlayers; ++seat) {
+                if (scores[seat] != batch.getScore(seat, game)) {
+                    std::cout << "Batch engine mismatch: " << numPlayers << " players, game " << game
+                              << ", seat " << seat << ": " << batch.getScore(seat, game)
+                              << " != " << scores[seat] << std::endl;
+                    return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+// Records games, seeded ones and ones dealt from a deck their seed does not
+// produce, reads them back through the mapped reader and replays every
+// record through Game
+bool gameLogReplays() {
+    const std::string path = "test_game_log.bin";
+    std::remove(path.c_str());
+
+    const int numGames = 200;
+    {
+        GameRecorder recorder(path);
+        for (int gameNum = 0; gameNum < numGames; ++gameNum) {
+            int numPlayers = 2 + gameNum % (MAX_PLAYERS - 1);
+            std::vector<std::unique_ptr<Player>> players;
+            for (int seat = 0; seat < numPlayers; ++seat) {
+                players.push_back(seat % 2 ? std::unique_ptr<Player>(std::make_unique<RandomAgent>())
+                                           : std::unique_ptr<Player>(std::make_unique<BullsHeadsFirstAgent>()));
+            }
+            uint64_t seed = deriveSeed(42, gameNum);
+            Game game = gameNum % 2 ? Game(std::move(players), Game::shuffledDeck(deriveSeed(43, gameNum)), seed)
+                                    : Game(std::move(players), seed);
+            game.setRecorder(&recorder);
+            game.playGame(false);
+        }
+    }
+
+    GameLogReader reader(path);
+    int replayed = 0;
+    for (GameRecordView record : reader) {
+        if (!replayMatchesRecord(record)) {
+            std::cout << "Replay mismatch for game " << replayed << std::endl;
+            return false;
+        }
+        replayed++;
+    }
+    std::remove(path.c_str());
+
+    if (replayed != numGames) {
+        std::cout << "Game log holds " << replayed << " of " << numGames << " games" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Game(players, shuffledDeck(seed), seed) must replay Game(players, seed),
+// and a deck must deal the same hands and rows whoever sits in the seats
+bool deckConstructorReplaysDeals() {
+    for (int gameNum = 0; gameNum < 100; ++gameNum) {
+        uint64_t seed = deriveSeed(7, gameNum);
+        std::vector<Card> deck = Game::shuffledDeck(seed);
+
+        auto makePlayers = [](bool swapped) {
+            std::vector<std::unique_ptr<Player>> players;
+            players.push_back(std::make_unique<RandomAgent>());
+            players.push_back(std::make_unique<BullsHeadsFirstAgent>());
+            if (swapped) std::swap(players[0], players[1]);
+            return players;
+        };
+
+        std::vector<int> seededScores = Game(makePlayers(false), seed).playGame(false);
+        std::vector<int> deckScores = Game(makePlayers(false), deck, seed).playGame(false);
+        if (seededScores != deckScores) {
+            std::cout << "Deck constructor differs from seed constructor in game " << gameNum << std::endl;
+            return false;
+        }
+
+        Game mirrored(makePlayers(true), deck, seed);
+        CardSet firstHand(std::vector<Card>(deck.begin(), deck.begin() + HAND_SIZE));
+        std::vector<std::unique_ptr<Player>> seated = mirrored.releasePlayers();
+        if (seated[0]->getHand() != firstHand ||
+            mirrored.getGameState().rows[0].tail != deck[2 * HAND_SIZE].number) {
+            std::cout << "Mirrored deal differs in game " << gameNum << std::endl;
+            return false;
+        }
+    }
+
+    // A deck with a repeated card, one too short or one with numbers out of
+    // range must be refused
+    std::vector<Card> repeated = Game::shuffledDeck(1);
+    repeated[5] = repeated[6];
+    std::vector<Card> shortDeck = Game::shuffledDeck(1);
+    shortDeck.pop_back();
+    std::vector<Card> outOfRange = Game::shuffledDeck(1);
+    outOfRange[3].number = 200;
+    outOfRange[9].number = -1;
+    for (const std::vector<Card>* deck : {&repeated, &shortDeck, &outOfRange}) {
+        std::vector<std::unique_ptr<Player>> players;
+        players.push_back(std::make_unique<RandomAgent>());
+        players.push_back(std::make_unique<RandomAgent>());
+        try {
+            Game(std::move(players), *deck, 1);
+            std::cout << "Deck constructor accepted a deck that is not a permutation" << std::endl;
+            return false;
+        } catch (const std::invalid_argument&) {
+        }
+    }
+    return true;
+}
+
+bool sameTable(const GameState& a, const GameState& b) {
+    for (int row = 0; row < NUM_ROWS; ++row) {
+        if (a.rows[row].length != b.rows[row].length || a.rows[row].bullHeads != b.rows[row].bullHeads ||
+            a.rows[row].tail != b.rows[row].tail ||
+            !std::equal(a.rows[row].cards.begin(), a.rows[row].cards.begin() + a.rows[row].length,
+                        b.rows[row].cards.begin())) {
+            return false;
+        }
+    }
+    return a.roundNumber == b.roundNumber && a.numPlayers == b.numPlayers && a.scores == b.scores &&
+           a.playedCards == b.playedCards;
+}
+
+// The table at the start of the game and after every round
+class TableHistory : public GameObserver {
+public:
+    std::vector<GameState> tables;
+    void onGameStart(const GameState& state) override { tables.push_back(state); }
+    void onRoundEnd(const GameState& state) override { tables.push_back(state); }
+};
+
+// resolveRound applied to each recorded table and the cards revealed next
+// must give the table Game reached, without touching its input
+bool resolveRoundMatchesGame() {
+    for (int gameNum = 0; gameNum < 300; ++gameNum) {
+        int numPlayers = 2 + gameNum % (MAX_PLAYERS - 1);
+        std::vector<std::unique_ptr<Player>> players;
+        for (int seat = 0; seat < numPlayers; ++seat) {
+            if (seat % 3 == 0) players.push_back(std::make_unique<RandomAgent>());
+            else if (seat % 3 == 1) players.push_back(std::make_unique<HighestCardFirstAgent>());
+            else players.push_back(std::make_unique<LowestCardFirstAgent>());
+        }
+        TableHistory history;
+        Game game(std::move(players), deriveSeed(24, gameNum));
+        game.addObserver(&history);
+        game.playGame(false);
+
+        for (size_t round = 1; round < history.tables.size(); ++round) {
+            const GameState before = history.tables[round - 1];
+            RoundCards cards{};
+            std::copy(history.tables[round].playedCards.begin(), history.tables[round].playedCards.end(),
+                      cards.begin());
+            GameState after = resolvedRound(history.tables[round - 1], cards);
+            if (!sameTable(after, history.tables[round]) || !sameTable(before, history.tables[round - 1])) {
+                std::cout << "resolveRound differs from Game in game " << gameNum << " round " << round << std::endl;
+                return false;
+            }
+        }
+    }
+
+    // Reveals come back lowest first with their seats
+    RevealBuffer reveal;
+    const int numbers[] = {57, 3, 104, 12, 1};
+    for (int seat = 0; seat < 5; ++seat) reveal.add(seat, numbers[seat]);
+    std::vector<std::pair<int, int>> order;
+    reveal.forEach([&](Card card, int seat) { order.emplace_back(card.number, seat); });
+    if (order != std::vector<std::pair<int, int>>{{1, 4}, {3, 1}, {12, 3}, {57, 0}, {104, 2}}) {
+        std::cout << "RevealBuffer order is wrong" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+int bruteForceMargin(const SimState& sim, int seat);
+
+// Plain maximin value of playing `card` now: the opponent's best reply,
+// resolved by the simulator, then best play for the rest of the game
+int bruteForceCardMargin(const SimState& sim, int seat, int card) {
+    int worst = -(1 << 30);
+    for (const Card& reply : sim.hands[1 - seat]) {
+        SimState child = sim;
+        RoundCards cards{};
+        cards[seat] = static_cast<uint8_t>(card);
+        cards[1 - seat] = static_cast<uint8_t>(reply.number);
+        playRound(child, cards);
+        int margin = (child.table.scores[seat] - sim.table.scores[seat]) -
+                     (child.table.scores[1 - seat] - sim.table.scores[1 - seat]);
+        worst = std::max(worst, margin + bruteForceMargin(child, seat));
+    }
+    return worst;
+}
+
+int bruteForceMargin(const SimState& sim, int seat) {
+    if (sim.roundsLeft() == 0) return 0;
+    int best = 1 << 30;
+    for (const Card& card : sim.hands[seat]) {
+        best = std::min(best, bruteForceCardMargin(sim, seat, card.number));
+    }
+    return best;
+}
+
+// The solver's value for every card must match brute force on positions
+// with four rounds left, reached by random play from seeded deals
+bool endgameSolverMatchesBruteForce() {
+    EndgameSolver solver(12);   // small table so slots get replaced
+    for (int gameNum = 0; gameNum < 200; ++gameNum) {
+        Rng rng(deriveSeed(11, gameNum));
+        std::vector<Card> deck = Game::shuffledDeck(deriveSeed(12, gameNum));
+
+        SimState sim;
+        sim.table.numPlayers = 2;
+        for (int i = 0; i < 2 * HAND_SIZE; ++i) sim.hands[i / HAND_SIZE].insert(deck[i].number);
+        for (int row = 0; row < NUM_ROWS; ++row) sim.table.rows[row].reset(deck[2 * HAND_SIZE + row]);
+        while (sim.roundsLeft() > 4) {
+            playRound(sim, {static_cast<uint8_t>(randomRolloutCard(sim, 0, rng)),
+                            static_cast<uint8_t>(randomRolloutCard(sim, 1, rng))});
+        }
+
+        int seat = gameNum % 2;
+        std::array<int, HAND_SIZE> values = solver.solveMoves(sim, seat);
+        int index = 0;
+        for (const Card& card : sim.hands[seat]) {
+            int expected = bruteForceCardMargin(sim, seat, card.number);
+            if (values[index] != expected) {
+                std::cout << "Endgame solver values card " << card.number << " at " << values[index]
+                          << " instead of " << expected << " in game " << gameNum << std::endl;
+                return false;
+            }
+            index++;
+        }
+    }
+    return true;
+}
+
+// Plays the highest card and takes the most expensive row, but too slowly
+class SlowAgent : public HighestCardFirstAgent {
+public:
+    long replaced = 0;   // onMoveReplaced calls
+
+    void onMoveReplaced(const GameState& /*state*/, int /*choice*/) override { replaced++; }
+
+    int chooseCard(const GameState& state) override {
+        std::this_thread::sleep_for(std::chrono::milliseconds(3));
+        return HighestCardFirstAgent::chooseCard(state);
+    }
+
+    int chooseRowToTake(const GameState& state) override {
+        std::this_thread::sleep_for(std::chrono::milliseconds(3));
+        return choseHighestPenaltyRowToTake(state);
+    }
+};
+
+// Every decision of an agent over the time limit must be replaced by the
+// default move, so a slow agent plays exactly like LowestCardFirstAgent
+// (lowest card, lowest-penalty row), every call counts as a timeout and the
+// agent hears of each replacement
+bool moveTimeLimitFallsBack() {
+    for (int gameNum = 0; gameNum < 4; ++gameNum) {
+        uint64_t seed = deriveSeed(13, gameNum);
+        std::vector<std::unique_ptr<Player>> players;
+        auto slow = std::make_unique<SlowAgent>();
+        SlowAgent* slowAgent = slow.get();
+        players.push_back(std::move(slow));
+        players.push_back(std::make_unique<BullsHeadsFirstAgent>());
+        players.push_back(std::make_unique<RandomAgent>());
+        Game game(std::move(players), seed);
+
+        std::array<DecisionStats, 3> stats;
+        for (int seat = 0; seat < 3; ++seat) game.setDecisionStats(seat, &stats[seat]);
+        game.setMoveTimeLimit(std::chrono::milliseconds(1));
+        std::vector<int> scores = game.playGame(false);
+
+        std::vector<std::unique_ptr<Player>> reference;
+        reference.push_back(std::make_unique<LowestCardFirstAgent>());
+        reference.push_back(std::make_unique<BullsHeadsFirstAgent>());
+        reference.push_back(std::make_unique<RandomAgent>());
+        std::vector<int> expected = Game(std::move(reference), seed).playGame(false);
+
+        long slowDecisions = stats[0].chooseCard.count() + stats[0].chooseRowToTake.count();
+        if (scores != expected || stats[0].chooseCard.count() != HAND_SIZE || stats[0].timeouts != slowDecisions ||
+            slowAgent->replaced != slowDecisions || stats[1].timeouts != 0 ||
+            stats[1].chooseCard.count() != HAND_SIZE) {
+            std::cout << "Move time limit: game " << gameNum << " did not fall back to the default moves ("
+                      << stats[0].timeouts << " timeouts in " << slowDecisions << " decisions)" << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+// Random player that checks its KnowledgeState at every decision against
+// the real hands of the other seats, which it reads through `table`
+class KnowledgeCheckAgent : public RandomAgent {
+public:
+    KnowledgeState knowledge;
+    std::vector<KnowledgeCheckAgent*>* table = nullptr;
+    CardSet undealt;
+    int chosen = 0;   // chosen but not yet revealed
+    bool failed = false;
+
+    void initialize(int playerId, int numPlayers, const std::vector<Card>& initialHand) override {
+        RandomAgent::initialize(playerId, numPlayers, initialHand);
+        knowledge.begin(playerId, numPlayers, hand);
+    }
+
+    void onGameStart(const GameState& state) override {
+        knowledge.onGameStart(state);
+        undealt = CardSet::fullDeck();
+        for (KnowledgeCheckAgent* agent : *table) undealt -= agent->getHand();
+        for (const Row& row : state.rows) {
+            for (const Card& card : row) undealt.erase(card.number);
+        }
+    }
+    void onCardsRevealed(const GameState& state) override {
+        knowledge.onCardsRevealed(state);
+        chosen = 0;
+    }
+    void onRowTaken(const GameState& state, int seat, int row, const Row& taken) override {
+        knowledge.onRowTaken(state, seat, row, taken);
+    }
+    void onRoundEnd(const GameState& state) override { knowledge.onRoundEnd(state); }
+
+    int chooseCard(const GameState& state) override {
+        CardSet expected = undealt;
+        for (KnowledgeCheckAgent* agent : *table) {
+            if (agent == this) continue;
+            expected |= agent->getHand();
+            if (agent->chosen) expected.insert(agent->chosen);
+        }
+        if (knowledge.getUnseen() != expected || knowledge.getHand() != hand) failed = true;
+        for (const Card& card : hand) {
+            double risk = knowledge.takeRisk(card.number);
+            if (knowledge.targetRow(card.number) != findBestRow(state, card.number) || risk < 0.0 || risk > 1.0 + 1e-9 ||
+                (knowledge.targetRow(card.number) == -1 && risk != 1.0)) {
+                failed = true;
+            }
+        }
+        int index = RandomAgent::chooseCard(state);
+        chosen = hand.select(index);
+        return index;
+    }
+};
+
+// The knowledge tracker, fed only by observer events, must agree with the
+// actual hands at every decision for every table size
+bool knowledgeTracksGames() {
+    for (int numPlayers = 2; numPlayers <= MAX_PLAYERS; ++numPlayers) {
+        for (int gameNum = 0; gameNum < 20; ++gameNum) {
+            std::vector<KnowledgeCheckAgent*> table;
+            std::vector<std::unique_ptr<Player>> players;
+            for (int seat = 0; seat < numPlayers; ++seat) {
+                auto agent = std::make_unique<KnowledgeCheckAgent>();
+                agent->table = &table;
+                table.push_back(agent.get());
+                players.push_back(std::move(agent));
+            }
+            Game game(std::move(players), deriveSeed(14, numPlayers, gameNum));
+            game.playGame(false);
+
+            for (KnowledgeCheckAgent* agent : table) {
+                if (agent->failed) {
+                    std::cout << "Knowledge state diverged in a " << numPlayers << "-player game " << gameNum
+                              << std::endl;
+                    return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+// EvalCache must treat row order as irrelevant, stay within its capacity
+// when threads overfill it, and return exactly what was stored
+bool evalCacheStoresAndEvicts() {
+    GameState state;
+    state.numPlayers = 3;
+    const int tails[NUM_ROWS] = {12, 40, 77, 3};
+    for (int row = 0; row < NUM_ROWS; ++row) state.rows[row].reset(Card(tails[row]));
+    GameState permuted = state;
+    std::swap(permuted.rows[0], permuted.rows[3]);
+    std::swap(permuted.rows[1], permuted.rows[2]);
+    CardSet hand = CardSet::range(50, 59);
+    if (!(makeEvalKey(state, hand, 1) == makeEvalKey(permuted, hand, 1)) ||
+        makeEvalKey(state, hand, 1) == makeEvalKey(state, hand, 2)) {
+        std::cout << "EvalCache keys are not canonical" << std::endl;
+        return false;
+    }
+
+    EvalCache cache(64 << 10, 4);
+    const int keysPerThread = static_cast<int>(cache.capacity());
+    ThreadPool pool(4);
+    std::atomic<bool> wrongValue{false};
+    pool.parallelFor(4, [&](int /*worker*/, size_t task) {
+        EvalValues values{};
+        for (int i = 0; i < keysPerThread; ++i) {
+            EvalKey key = makeEvalKey(state, hand, deriveSeed(task, i));
+            values[0] = static_cast<float>(i);
+            cache.store(key, values);
+
+            EvalValues found;
+            if (cache.lookup(key, found) && found[0] != static_cast<float>(i)) wrongValue = true;
+        }
+    });
+
+    EvalCache::Stats stats = cache.getStats();
+    if (wrongValue || stats.entries > stats.capacity || stats.evictions == 0 || stats.hits == 0 ||
+        cache.memoryBytes() > (64 << 10)) {
+        std::cout << "EvalCache: " << stats.entries << " entries of " << stats.capacity << ", " << stats.evictions
+                  << " evictions, " << stats.hits << " hits" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// MonteCarloAgent that logs the cards it plays and flags indices outside
+// its hand
+class MonteCarloCheckAgent : public MonteCarloAgent {
+public:
+    using MonteCarloAgent::MonteCarloAgent;
+
+    std::vector<int> played;
+    bool outOfHand = false;
+
+    int chooseCard(const GameState& state) override {
+        int index = MonteCarloAgent::chooseCard(state);
+        if (index < 0 || index >= hand.size()) {
+            outOfHand = true;
+            return 0;
+        }
+        played.push_back(hand.select(index));
+        return index;
+    }
+};
+
+// Under a playout budget MonteCarloAgent must play the same cards on one
+// thread as on four, and replaying a game through a shared EvalCache must
+// answer every multi-card decision from the cache with the same cards
+bool monteCarloIsReproducible() {
+    struct Run {
+        std::vector<int> played;
+        bool outOfHand;
+        long playouts;
+        double playoutsPerSecond;
+    };
+    auto play = [](uint64_t seed, int numThreads, std::shared_ptr<EvalCache> cache) {
+        std::vector<std::unique_ptr<Player>> players;
+        players.push_back(std::make_unique<MonteCarloCheckAgent>(200, std::chrono::microseconds(0), numThreads, cache));
+        players.push_back(std::make_unique<BullsHeadsFirstAgent>());
+        players.push_back(std::make_unique<RandomAgent>());
+        Game game(std::move(players), seed);
+        game.playGame(false);
+        std::vector<std::unique_ptr<Player>> seated = game.releasePlayers();
+        const auto& agent = static_cast<const MonteCarloCheckAgent&>(*seated[0]);
+        return Run{agent.played, agent.outOfHand, agent.getTotalPlayouts(), agent.getPlayoutsPerSecond()};
+    };
+
+    for (int gameNum = 0; gameNum < 3; ++gameNum) {
+        uint64_t seed = deriveSeed(31, gameNum);
+        Run single = play(seed, 1, nullptr);
+        Run threaded = play(seed, 4, nullptr);
+        if (single.outOfHand || threaded.outOfHand || single.played.size() != HAND_SIZE ||
+            single.played != threaded.played || single.playouts != threaded.playouts) {
+            std::cout << "MonteCarloAgent: game " << gameNum << " differs between 1 and 4 threads" << std::endl;
+            return false;
+        }
+        if (single.playouts == 0 || single.playoutsPerSecond <= 0.0) {
+            std::cout << "MonteCarloAgent: game " << gameNum << " reports no playouts" << std::endl;
+            return false;
+        }
+
+        auto cache = std::make_shared<EvalCache>();
+        Run searched = play(seed, 1, cache);
+        long searchedHits = cache->getStats().hits;
+        Run cached = play(seed, 4, cache);
+        long hits = cache->getStats().hits - searchedHits;
+        if (searched.played != single.played || cached.played != single.played || cached.outOfHand ||
+            cached.playouts != 0 || hits != HAND_SIZE - 1) {
+            std::cout << "MonteCarloAgent: game " << gameNum << " replayed through the cache with " << hits
+                      << " hits and " << cached.playouts << " playouts" << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+// A tournament's results must depend only on its seed: 1 and 4 threads must
+// give the same counts at every table, for round-robin, free-for-all,
+// duplicate and early-stopping runs
+bool tournamentIsThreadIndependent() {
+    enum Mode { RoundRobin, FreeForAll, Duplicate, EarlyStopping };
+    auto run = [](Mode mode, int numThreads) {
+        Tournament tournament;
+        for (const char* name : {"RandomAgent", "LowestCardFirstAgent", "BullsHeadsFirstAgent", "HighestCardFirstAgent"}) {
+            tournament.addPlayer(AgentRegistry::instance().create(name));
+        }
+        if (mode == Duplicate) tournament.setDuplicate(true);
+        if (mode == EarlyStopping) tournament.setEarlyStopping(SprtSettings());
+        return tournament.run(mode == FreeForAll ? 3 : 2, 200, numThreads, 99);
+    };
+    auto sameStats = [](const AgentStats& a, const AgentStats& b) {
+        return a.games == b.games && a.wins == b.wins && a.totalScore == b.totalScore &&
+               a.totalRank == b.totalRank && a.deals == b.deals && a.marginSum == b.marginSum &&
+               a.marginSquares == b.marginSquares;
+    };
+
+    for (Mode mode : {RoundRobin, FreeForAll, Duplicate, EarlyStopping}) {
+        TournamentResult single = run(mode, 1);
+        TournamentResult threaded = run(mode, 4);
+        bool same = single.tables.size() == threaded.tables.size() && single.standings.size() == threaded.standings.size();
+        for (size_t t = 0; same && t < single.tables.size(); ++t) {
+            const TableResult& a = single.tables[t];
+            const TableResult& b = threaded.tables[t];
+            same = a.games == b.games && a.lineup == b.lineup && a.leader == b.leader && a.noDifference == b.noDifference;
+            for (size_t position = 0; same && position < a.stats.size(); ++position) {
+                same = sameStats(a.stats[position], b.stats[position]);
+            }
+        }
+        for (size_t agent = 0; same && agent < single.standings.size(); ++agent) {
+            same = sameStats(single.standings[agent], threaded.standings[agent]);
+        }
+        if (!same) {
+            std::cout << "Tournament mode " << mode << " differs between 1 and 4 threads" << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+// Output and exit status of a shell command
+std::string runCommand(const std::string& command, int& status) {
+    std::string output;
+    std::FILE* pipe = popen(command.c_str(), "r");
+    if (!pipe) {
+        status = -1;
+        return output;
+    }
+    char buffer[4096];
+    size_t read;
+    while ((read = std::fread(buffer, 1, sizeof(buffer), pipe)) > 0) output.append(buffer, read);
+    int result = pclose(pipe);
+    status = WIFEXITED(result) ? WEXITSTATUS(result) : -1;
+    return output;
+}
+
+// The contest and merge programs next to this one, run with the scripted
+// options: CSV and JSON output, SPRT early stopping, a move limit, shards
+// merged back into the single run, the interactive single game, and usage
+// errors
+bool contestCommandLineWorks(const std::string& programDirectory) {
+    char directory[] = "/tmp/sixnimmt_contest_XXXXXX";
+    if (!mkdtemp(directory)) {
+        std::cout << "Cannot create a temporary directory" << std::endl;
+        return false;
+    }
+    const std::string contest = "'" + programDirectory + "sixnimmt_contest' 2>/dev/null ";
+    const std::string merge = "'" + programDirectory + "sixnimmt_merge' 2>/dev/null ";
+    const std::string agents = "--agents RandomAgent,BullsHeadsFirstAgent,LowestCardFirstAgent --seed 4 ";
+    const std::string first = std::string(directory) + "/first.shard";
+    const std::string second = std::string(directory) + "/second.shard";
+
+    struct Case {
+        std::string command;
+        int status;
+        std::string expected;   // in the output
+    };
+    const std::vector<Case> cases = {
+        {contest + agents + "--games 30 --format csv", 0, "table,agent,games,wins"},
+        {contest + agents + "--games 30 --seats 3 --format json", 0, "\"tables\": ["},
+        {contest + agents + "--games 400 --sprt 0.1 --format json", 0, "\"outcome\": "},
+        {contest + agents + "--games 10 --move-limit 1000 --format csv", 0, "timeouts"},
+        {contest + agents + "--games 30 --format shard --shard 0:40 > '" + first + "'", 0, ""},
+        {contest + agents + "--games 30 --format shard --shard 40:90 > '" + second + "'", 0, ""},
+        {"echo 1 | " + contest, 0, "=== Final Results ==="},
+        {contest + "--format xml", 1, ""},
+        {contest + agents + "--sprt 0.7", 1, ""},
+        {contest + agents + "--format shard --shard 0:10 --sprt 0.1", 1, ""},
+    };
+    bool ok = true;
+    for (const Case& test : cases) {
+        int status = 0;
+        std::string output = runCommand(test.command, status);
+        if (status != test.status || output.find(test.expected) == std::string::npos) {
+            std::cout << "Command exited " << status << " (expected " << test.status << "): " << test.command
+                      << std::endl;
+            ok = false;
+        }
+    }
+
+    int status = 0;
+    std::string single = runCommand(contest + agents + "--games 30 --format csv", status);
+    std::string merged = runCommand(merge + "--format csv '" + second + "' '" + first + "'", status);
+    if (ok && (status != 0 || merged != single)) {
+        std::cout << "Merged contest shards differ from the single run" << std::endl;
+        ok = false;
+    }
+
+    std::remove(first.c_str());
+    std::remove(second.c_str());
+    std::remove(directory);
+    return ok;
+}
+
+// Early stopping must name the stronger agent of an uneven pairing, find no
+// difference between two copies of one agent and leave a pairing it has too
+// few games for undecided
+bool sprtSeparatesOutcomes() {
+    auto runPair = [](const char* first, const char* second, double delta, int games) {
+        Tournament tournament;
+        tournament.addPlayer(AgentRegistry::instance().create(first));
+        tournament.addPlayer(AgentRegistry::instance().create(second));
+        SprtSettings settings;
+        settings.delta = delta;
+        tournament.setEarlyStopping(settings);
+        return tournament.run(2, games, 1, 11).tables[0];
+    };
+
+    TableResult uneven = runPair("LowestCardFirstAgent", "BullsHeadsFirstAgent", 0.1, 4000);
+    TableResult even = runPair("RandomAgent", "RandomAgent", 0.1, 4000);
+    TableResult shortRun = runPair("RandomAgent", "RandomAgent", 0.01, 100);
+    if (uneven.leader < 0 || uneven.lineup[uneven.leader] != 1 || uneven.games >= 4000) {
+        std::cout << "SPRT did not find BullsHeadsFirstAgent stronger than LowestCardFirstAgent" << std::endl;
+        return false;
+    }
+    if (!even.noDifference || even.leader >= 0 || even.games >= 4000) {
+        std::cout << "SPRT did not find two RandomAgents even" << std::endl;
+        return false;
+    }
+    if (shortRun.decided()) {
+        std::cout << "SPRT decided a pairing from too few games" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Unregistered agent whose name has spaces, as a policy: path can
+class SpacedNameAgent : public LowestCardFirstAgent {
+public:
+    std::string getName() const override { return "policy:my weights.txt"; }
+    std::unique_ptr<Player> clone() const override { return std::make_unique<SpacedNameAgent>(); }
+};
+
+// Shards of a tournament, written out, read back and merged in any order,
+// must give exactly the counts of a single run with the same seed
+bool shardsMergeToSingleRun() {
+    auto makeTournament = [] {
+        Tournament tournament;
+        for (const char* name : {"HighestCardFirstAgent", "BullsHeadsFirstAgent"}) {
+            tournament.addPlayer(AgentRegistry::instance().create(name));
+        }
+        tournament.addPlayer(std::make_unique<SpacedNameAgent>());
+        tournament.setDuplicate(true);
+        tournament.setStatistics(20);
+        return tournament;
+    };
+    const uint64_t seed = 2024;
+    TournamentResult single = makeTournament().run(2, 40, 2, seed);
+
+    std::vector<TournamentResult> shards;
+    for (auto range : {std::make_pair(25L, 1000L), std::make_pair(0L, 7L), std::make_pair(7L, 25L)}) {
+        Tournament tournament = makeTournament();
+        tournament.setShard(range.first, range.second);
+        std::stringstream file;
+        writeResults(file, tournament.run(2, 40, 1, seed), OutputFormat::Shard);
+        shards.push_back(readShard(file));
+    }
+    TournamentResult merged = mergeShards(shards);
+
+    bool same = merged.agentNames == single.agentNames && merged.tables.size() == single.tables.size() &&
+                merged.standings.size() == single.standings.size();
+    auto sameStats = [](const AgentStats& a, const AgentStats& b) {
+        return a.games == b.games && a.wins == b.wins && a.totalScore == b.totalScore &&
+               a.totalRank == b.totalRank && a.deals == b.deals && a.marginSum == b.marginSum &&
+               a.marginSquares == b.marginSquares;
+    };
+    for (size_t t = 0; same && t < single.tables.size(); ++t) {
+        same = merged.tables[t].games == single.tables[t].games && merged.tables[t].deals == single.tables[t].deals;
+        for (size_t position = 0; same && position < single.tables[t].stats.size(); ++position) {
+            same = sameStats(merged.tables[t].stats[position], single.tables[t].stats[position]);
+        }
+    }
+    for (size_t agent = 0; same && agent < single.standings.size(); ++agent) {
+        same = sameStats(merged.standings[agent], single.standings[agent]);
+    }
+    same = same && merged.statistics.eloRatings() == single.statistics.eloRatings() &&
+           merged.statistics.eloStandardErrors() == single.statistics.eloStandardErrors();
+    if (!same) {
+        std::cout << "Merged shards differ from the single run" << std::endl;
+        return false;
+    }
+
+    // A missing range must be reported, not merged
+    shards.pop_back();
+    try {
+        mergeShards(shards);
+        std::cout << "Merging incomplete shards did not fail" << std::endl;
+        return false;
+    } catch (const std::invalid_argument&) {
+    }
+    return true;
+}
+
+// Statistics accumulators must merge to what one accumulator would give,
+// and placements must count against every opponent at the table
+bool statisticsMerge() {
+    RunningStats all;
+    RunningStats low;
+    RunningStats high;
+    for (int i = 1; i <= 100; ++i) {
+        all.add(i * 0.5);
+        (i <= 30 ? low : high).add(i * 0.5);
+    }
+    low.add(high);
+    if (low.count() != all.count() || std::abs(low.mean() - all.mean()) > 1e-9 ||
+        std::abs(low.variance() - all.variance()) > 1e-9 || low.min() != all.min() || low.max() != all.max()) {
+        std::cout << "RunningStats merge differs: " << low.variance() << " vs " << all.variance() << std::endl;
+        return false;
+    }
+
+    // Agent 1 beats everyone, 0 and 2 tie, agent 3 loses to all
+    PairwiseMatrix matrix(4);
+    const int agents[4] = {0, 1, 2, 3};
+    const int scores[4] = {5, 3, 5, 9};
+    matrix.addGame(agents, scores, 4);
+    if (matrix.getHalfPoints(1, 0) != 2 || matrix.getHalfPoints(0, 1) != 0 || matrix.getHalfPoints(0, 2) != 1 ||
+        matrix.getHalfPoints(2, 0) != 1 || matrix.getHalfPoints(3, 2) != 0 || matrix.games(1, 3) != 1) {
+        std::cout << "Pairwise matrix misreads a 4-player game" << std::endl;
+        return false;
+    }
+    std::vector<double> elo = matrix.eloRatings();
+    if (!(elo[1] > elo[0] && std::abs(elo[0] - elo[2]) < 1e-6 && elo[2] > elo[3])) {
+        std::cout << "Ratings do not follow the placements" << std::endl;
+        return false;
+    }
+
+    // Ratings and intervals must not depend on the thread count
+    auto run = [](int numThreads) {
+        Tournament tournament;
+        for (const char* name : {"LowestCardFirstAgent", "RandomAgent", "BullsHeadsFirstAgent"}) {
+            tournament.addPlayer(AgentRegistry::instance().create(name));
+        }
+        tournament.setStatistics(30);
+        return tournament.run(3, 300, numThreads, 99);
+    };
+    TournamentResult one = run(1);
+    TournamentResult three = run(3);
+    std::vector<TournamentStats::Interval> a = one.statistics.eloIntervals();
+    std::vector<TournamentStats::Interval> b = three.statistics.eloIntervals();
+    for (size_t agent = 0; agent < a.size(); ++agent) {
+        if (a[agent].low != b[agent].low || a[agent].high != b[agent].high ||
+            one.statistics.getScores(agent).percentile(50) != three.statistics.getScores(agent).percentile(50)) {
+            std::cout << "Statistics depend on the thread count" << std::endl;
+            return false;
+        }
+        if (a[agent].low > one.statistics.eloRatings()[agent] || a[agent].high < one.statistics.eloRatings()[agent]) {
+            std::cout << "Rating outside its bootstrap interval" << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+// Agents served by a host process must play exactly like local instances,
+// through Game, BatchEngine and a multi-threaded tournament
+bool remoteAgentsMatchLocal(const std::string& hostPath) {
+    auto random = std::make_shared<AgentConnection>(hostPath, "RandomAgent");
+    auto bullsHeads = std::make_shared<AgentConnection>(hostPath, "BullsHeadsFirstAgent");
+
+    for (int game = 0; game < 50; ++game) {
+        uint64_t seed = deriveSeed(21, game);
+        std::vector<std::unique_ptr<Player>> remote;
+        remote.push_back(std::make_unique<RemoteAgent>(random));
+        remote.push_back(std::make_unique<LowestCardFirstAgent>());
+        remote.push_back(std::make_unique<RemoteAgent>(bullsHeads));
+        std::vector<std::unique_ptr<Player>> local;
+        local.push_back(std::make_unique<RandomAgent>());
+        local.push_back(std::make_unique<LowestCardFirstAgent>());
+        local.push_back(std::make_unique<BullsHeadsFirstAgent>());
+
+        if (Game(std::move(remote), seed).playGame(false) != Game(std::move(local), seed).playGame(false)) {
+            std::cout << "Remote agents diverge from local ones in game " << game << std::endl;
+            return false;
+        }
+    }
+
+    // A move limit nothing meets replaces every choice with the lowest card,
+    // so the host's agent must follow the cards actually played
+    auto highest = std::make_shared<AgentConnection>(hostPath, "HighestCardFirstAgent");
+    for (int game = 0; game < 10; ++game) {
+        uint64_t seed = deriveSeed(23, game);
+        std::vector<std::unique_ptr<Player>> remote;
+        remote.push_back(std::make_unique<RemoteAgent>(highest));
+        remote.push_back(std::make_unique<RemoteAgent>(bullsHeads));
+        std::vector<std::unique_ptr<Player>> local;
+        local.push_back(std::make_unique<LowestCardFirstAgent>());
+        local.push_back(std::make_unique<LowestCardFirstAgent>());
+
+        Game limited(std::move(remote), seed);
+        limited.setMoveTimeLimit(std::chrono::nanoseconds(1));
+        if (limited.playGame(false) != Game(std::move(local), seed).playGame(false)) {
+            std::cout << "Remote agents under a move limit diverge in game " << game << std::endl;
+            return false;
+        }
+    }
+
+    std::vector<uint64_t> seeds;
+    for (int game = 0; game < 2000; ++game) seeds.push_back(deriveSeed(22, game));
+    std::vector<std::unique_ptr<BatchPolicy>> remotePolicies;
+    remotePolicies.push_back(std::make_unique<RemoteBatchPolicy>(random));
+    remotePolicies.push_back(createBatchPolicy("HighestCardFirstAgent"));
+    std::vector<std::unique_ptr<BatchPolicy>> localPolicies;
+    localPolicies.push_back(createBatchPolicy("RandomAgent"));
+    localPolicies.push_back(createBatchPolicy("HighestCardFirstAgent"));
+    BatchEngine remoteBatch(std::move(remotePolicies), seeds);
+    BatchEngine localBatch(std::move(localPolicies), seeds);
+    remoteBatch.playGames();
+    localBatch.playGames();
+    for (size_t game = 0; game < seeds.size(); ++game) {
+        for (int seat = 0; seat < 2; ++seat) {
+            if (remoteBatch.getScore(seat, game) != localBatch.getScore(seat, game)) {
+                std::cout << "Remote batch policy diverges in game " << game << std::endl;
+                return false;
+            }
+        }
+    }
+
+    // Clones share the host process; events ride along with decisions
+    Tournament remoteTournament;
+    remoteTournament.addPlayer(std::make_unique<RemoteAgent>(bullsHeads));
+    remoteTournament.addPlayer(std::make_unique<LowestCardFirstAgent>());
+    Tournament localTournament;
+    localTournament.addPlayer(std::make_unique<BullsHeadsFirstAgent>());
+    localTournament.addPlayer(std::make_unique<LowestCardFirstAgent>());
+    long roundTrips = bullsHeads->getRoundTrips();
+    long requests = bullsHeads->getRequests();
+    TournamentResult remoteResult = remoteTournament.run(2, 200, 3, 5);
+    TournamentResult localResult = localTournament.run(2, 200, 1, 5);
+    if (remoteResult.standings[0].totalScore != localResult.standings[0].totalScore ||
+        remoteResult.standings[0].wins != localResult.standings[0].wins ||
+        bullsHeads->getRequests() - requests <= bullsHeads->getRoundTrips() - roundTrips) {
+        std::cout << "Remote tournament differs from the local one" << std::endl;
+        return false;
+    }
+
+    try {
+        AgentConnection unknown(hostPath, "NoSuchAgent");
+        std::cout << "Host accepted an unknown agent" << std::endl;
+        return false;
+    } catch (const std::invalid_argument&) {
+    }
+    return true;
+}
+
+// The example plugin's agents load into the registry; its lowest-card agent
+// plays exactly like LowestCardFirstAgent, and bad plugins are rejected
+bool pluginAgentsLoad(const std::string& pluginDirectory) {
+    std::vector<std::string> names = loadAgentPlugins(pluginDirectory);
+    if (names != std::vector<std::string>{"PluginLowestCardAgent", "PluginClosestFitAgent"} ||
+        !AgentRegistry::instance().contains("PluginClosestFitAgent")) {
+        std::cout << "Example plugin did not register its agents" << std::endl;
+        return false;
+    }
+
+    for (int game = 0; game < 100; ++game) {
+        uint64_t seed = deriveSeed(23, game);
+        std::vector<std::unique_ptr<Player>> plugin;
+        plugin.push_back(AgentRegistry::instance().create("PluginLowestCardAgent"));
+        plugin.push_back(std::make_unique<RandomAgent>());
+        plugin.push_back(AgentRegistry::instance().create("PluginClosestFitAgent"));
+        std::vector<std::unique_ptr<Player>> local;
+        local.push_back(std::make_unique<LowestCardFirstAgent>());
+        local.push_back(std::make_unique<RandomAgent>());
+        local.push_back(AgentRegistry::instance().create("PluginClosestFitAgent"));
+
+        if (Game(std::move(plugin), seed).playGame(false) != Game(std::move(local), seed).playGame(false)) {
+            std::cout << "Plugin agent diverges from LowestCardFirstAgent in game " << game << std::endl;
+            return false;
+        }
+    }
+
+    // Clones come from the registry factory and keep the library loaded
+    Tournament tournament;
+    tournament.addPlayer(AgentRegistry::instance().create("PluginClosestFitAgent"));
+    tournament.addPlayer(std::make_unique<BullsHeadsFirstAgent>());
+    TournamentResult result = tournament.run(2, 100, 2, 7);
+    if (result.standings.size() != 2 || result.standings[0].games != 100) {
+        std::cout << "Tournament with a plugin agent did not complete" << std::endl;
+        return false;
+    }
+
+    for (const std::string& path : {pluginDirectory + "/no_such_plugin.so", std::string("/dev/null")}) {
+        try {
+            loadAgentPlugin(path);
+            std::cout << "Loaded a bad plugin " << path << std::endl;
+            return false;
+        } catch (const std::invalid_argument&) {
+        }
+    }
+    return true;
+}
+
+// Self-play files must not depend on the thread count, and every record
+// must describe its decision and the game's true outcome
+bool selfPlayIsReproducible() {
+    char directory[] = "/tmp/sixnimmt_selfplay_XXXXXX";
+    if (!mkdtemp(directory)) {
+        std::cout << "Cannot create a temporary directory" << std::endl;
+        return false;
+    }
+
+    SelfPlaySettings settings;
+    settings.agents = {"RandomAgent", "BullsHeadsFirstAgent", "HighestCardFirstAgent"};
+    settings.numPlayers = 3;
+    settings.numGames = 250;
+    settings.gamesPerChunk = 60;
+    settings.seed = 31;
+    settings.numThreads = 1;
+    settings.outputPrefix = std::string(directory) + "/one";
+    SelfPlaySummary one = generateSelfPlay(settings);
+    settings.numThreads = 3;
+    settings.maxPendingChunks = 1;
+    settings.outputPrefix = std::string(directory) + "/three";
+    SelfPlaySummary three = generateSelfPlay(settings);
+
+    auto readFile = [](const std::string& path) {
+        std::ifstream in(path, std::ios::binary);
+        return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    };
+
+    bool ok = one.files.size() == 5 && one.decisions == 250 * 3 * HAND_SIZE && three.decisions == one.decisions;
+    std::vector<int> finalScores(250 * 3, -1);
+    for (size_t chunk = 0; ok && chunk < one.files.size(); ++chunk) {
+        std::string data = readFile(one.files[chunk]);
+        ok = data == readFile(three.files[chunk]) && data.compare(0, 6, "\x93NUMPY") == 0;
+        size_t offset = selfPlayNpyHeader(0).size();
+        size_t records = ok ? (data.size() - offset) / sizeof(SelfPlayRecord) : 0;
+        ok = ok && data.substr(0, offset) == selfPlayNpyHeader(records);
+
+        for (size_t i = 0; ok && i < records; ++i) {
+            SelfPlayRecord record;
+            std::memcpy(&record, data.data() + offset + i * sizeof(SelfPlayRecord), sizeof(record));
+            const uint8_t* features = record.features;
+            int round = features[FEATURE_ROUND];
+            int handSize = 0;
+            int unseen = 0;
+            for (int card = 0; card < DECK_SIZE; ++card) {
+                handSize += features[FEATURE_HAND + card];
+                unseen += features[FEATURE_UNSEEN + card];
+            }
+            int seat = features[FEATURE_SEAT];
+            ok = record.game / 60 == chunk && features[FEATURE_NUM_PLAYERS] == 3 &&
+                 features[FEATURE_HAND + record.action - 1] == 1 && handSize == HAND_SIZE + 1 - round &&
+                 unseen == DECK_SIZE - handSize - NUM_ROWS - 3 * (round - 1);
+            finalScores[record.game * 3 + seat] = record.finalScore;
+        }
+    }
+
+    // Outcomes match the same games replayed
+    for (int game = 0; ok && game < 250; ++game) {
+        std::vector<std::unique_ptr<Player>> players;
+        for (int seat = 0; seat < 3; ++seat) {
+            players.push_back(AgentRegistry::instance().create(settings.agents[(game + seat) % 3]));
+        }
+        std::vector<int> scores = Game(std::move(players), deriveSeed(31, game)).playGame(false);
+        for (int seat = 0; seat < 3; ++seat) ok = ok && finalScores[game * 3 + seat] == scores[seat];
+    }
+
+    for (const std::string& path : one.files) std::remove(path.c_str());
+    for (const std::string& path : three.files) std::remove(path.c_str());
+    std::remove(directory);
+    if (!ok) std::cout << "Self-play data is wrong or depends on the thread count" << std::endl;
+    return ok;
+}
+
+// Observes a game and checks both PolicyAgent forward passes on every
+// position its seat decides in
+class PolicyChecker : public PolicyAgent {
+public:
+    using PolicyAgent::PolicyAgent;
+    double maxDifference = 0.0;
+
+    int chooseCard(const GameState& state) override {
+        alignas(32) float scalar[POLICY_BATCH];
+        alignas(32) float vector[POLICY_BATCH];
+        const float* inputs = encode(state);
+        evaluatePolicy(*defaultWeights, inputs, scalar, false);
+        evaluatePolicy(*defaultWeights, inputs, vector, policyHasAvx2());
+        for (int i = 0; i < hand.size(); ++i) {
+            maxDifference = std::max(maxDifference, static_cast<double>(std::abs(scalar[i] - vector[i])));
+        }
+        return PolicyAgent::chooseCard(state);
+    }
+
+    std::shared_ptr<const PolicyWeights> defaultWeights = std::make_shared<const PolicyWeights>(defaultPolicyWeights());
+};
+
+// The AVX2 and scalar passes agree, weights survive a write and read, a
+// linear policy scores by its dot product, and bad files are rejected
+bool policyAgentEvaluates() {
+    double maxDifference = 0.0;
+    for (int game = 0; game < 200; ++game) {
+        std::vector<std::unique_ptr<Player>> players;
+        players.push_back(std::make_unique<PolicyChecker>());
+        players.push_back(std::make_unique<BullsHeadsFirstAgent>());
+        players.push_back(std::make_unique<RandomAgent>());
+        Game match(std::move(players), deriveSeed(25, game));
+        match.playGame(false);
+        maxDifference = std::max(maxDifference, static_cast<PolicyChecker&>(*match.releasePlayers()[0]).maxDifference);
+    }
+    if (maxDifference > 1e-3) {
+        std::cout << "AVX2 and scalar policy scores differ by " << maxDifference << std::endl;
+        return false;
+    }
+
+    // Written weights play the same games as the built-in ones
+    std::stringstream file;
+    writePolicyWeights(file, defaultPolicyWeights());
+    auto reread = std::make_shared<const PolicyWeights>(readPolicyWeights(file));
+    for (int game = 0; game < 50; ++game) {
+        std::vector<std::unique_ptr<Player>> builtIn;
+        builtIn.push_back(std::make_unique<PolicyAgent>());
+        builtIn.push_back(std::make_unique<LowestCardFirstAgent>());
+        std::vector<std::unique_ptr<Player>> loaded;
+        loaded.push_back(std::make_unique<PolicyAgent>(reread));
+        loaded.push_back(std::make_unique<LowestCardFirstAgent>());
+        if (Game(std::move(builtIn), deriveSeed(26, game)).playGame(false) !=
+            Game(std::move(loaded), deriveSeed(26, game)).playGame(false)) {
+            std::cout << "Policy weights change when written and read back" << std::endl;
+            return false;
+        }
+    }
+
+    PolicyWeights linear;
+    linear.outputWeights.assign(POLICY_INPUTS, 0.0f);
+    linear.outputWeights[POLICY_CARD] = 2.0f;
+    linear.outputWeights[POLICY_FORCED] = -1.0f;
+    linear.outputBias = 0.5f;
+    alignas(32) float inputs[POLICY_INPUTS * POLICY_BATCH] = {};
+    for (int slot = 0; slot < POLICY_BATCH; ++slot) {
+        inputs[POLICY_CARD * POLICY_BATCH + slot] = slot / 16.0f;
+        inputs[POLICY_FORCED * POLICY_BATCH + slot] = slot % 2;
+    }
+    for (bool avx2 : {false, policyHasAvx2()}) {
+        alignas(32) float scores[POLICY_BATCH];
+        evaluatePolicy(linear, inputs, scores, avx2);
+        for (int slot = 0; slot < POLICY_BATCH; ++slot) {
+            if (std::abs(scores[slot] - (0.5f + 2.0f * slot / 16.0f - slot % 2)) > 1e-5f) {
+                std::cout << "Linear policy scores slot " << slot << " wrong" << std::endl;
+                return false;
+            }
+        }
+    }
+
+    for (const std::string& text : {std::string("6NPOLICY 1 inputs 16 hidden 2 1 2 3"), std::string("weights")}) {
+        std::stringstream bad(text);
+        try {
+            readPolicyWeights(bad);
+            std::cout << "Read malformed policy weights" << std::endl;
+            return false;
+        } catch (const std::invalid_argument&) {
+        }
+    }
+    return true;
+}
+
+} // namespace SixNimmt
+
+int main(int argc, char* argv[]) {
     using namespace SixNimmt;
 
     std::cout << "Testing \"6 nimmt!\" game engine" << std::endl;
@@ -27,6 +1245,102 @@ int main() {
     Game game(std::move(players));
     std::vector<int> scores = game.playGame(true);
 
+    if (!cardSetMatchesModel() || !findBestRowMatchesScan()) {
+        return 1;
+    }
+    std::cout << "CardSet and findBestRow match naive models" << std::endl;
+
+    if (!batchEngineMatchesGame()) {
+        return 1;
+    }
+    std::cout << "Batch engine matches Game on 900 seeded games" << std::endl;
+
+    if (!gameLogReplays()) {
+        return 1;
+    }
+    std::cout << "Game log records replay exactly" << std::endl;
+
+    if (!deckConstructorReplaysDeals()) {
+        return 1;
+    }
+    std::cout << "Games built from a deck replay their deal" << std::endl;
+
+    if (!resolveRoundMatchesGame()) {
+        return 1;
+    }
+    std::cout << "resolveRound replays every round of 300 games" << std::endl;
+
+    if (!endgameSolverMatchesBruteForce()) {
+        return 1;
+    }
+    std::cout << "Endgame solver matches brute force" << std::endl;
+
+    if (!tournamentIsThreadIndependent()) {
+        return 1;
+    }
+    std::cout << "Tournament results do not depend on the thread count" << std::endl;
+
+    if (!sprtSeparatesOutcomes()) {
+        return 1;
+    }
+    std::cout << "SPRT separates stronger, even and undecided pairings" << std::endl;
+
+    if (!moveTimeLimitFallsBack()) {
+        return 1;
+    }
+    std::cout << "Decisions over the time limit fall back to the default move" << std::endl;
+
+    if (!knowledgeTracksGames()) {
+        return 1;
+    }
+    std::cout << "Knowledge state tracks the hidden cards" << std::endl;
+
+    if (!evalCacheStoresAndEvicts()) {
+        return 1;
+    }
+    std::cout << "Evaluation cache is canonical and bounded" << std::endl;
+
+    if (!monteCarloIsReproducible()) {
+        return 1;
+    }
+    std::cout << "Monte Carlo agent plays the same cards on any thread count" << std::endl;
+
+    if (!shardsMergeToSingleRun()) {
+        return 1;
+    }
+    std::cout << "Tournament shards merge to the single-process result" << std::endl;
+
+    if (!statisticsMerge()) {
+        return 1;
+    }
+    std::cout << "Tournament statistics merge exactly" << std::endl;
+
+    if (!remoteAgentsMatchLocal(defaultAgentHostPath(argc > 0 ? argv[0] : nullptr))) {
+        return 1;
+    }
+    std::cout << "Remote agents play like local ones" << std::endl;
+
+    if (!pluginAgentsLoad(defaultPluginDirectory(argc > 0 ? argv[0] : nullptr))) {
+        return 1;
+    }
+    std::cout << "Plugin agents load and play like built-in ones" << std::endl;
+
+    std::string program = argc > 0 ? argv[0] : "";
+    if (!contestCommandLineWorks(program.substr(0, program.rfind('/') + 1))) {
+        return 1;
+    }
+    std::cout << "Contest command line runs its scripted options" << std::endl;
+
+    if (!selfPlayIsReproducible()) {
+        return 1;
+    }
+    std::cout << "Self-play data is reproducible across thread counts" << std::endl;
+
+    if (!policyAgentEvaluates()) {
+        return 1;
+    }
+    std::cout << "Policy agent matches across forward passes and weight files" << std::endl;
+
     std::cout << "\nTest completed successfully!" << std::endl;
     return 0;
 }
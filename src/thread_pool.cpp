@@ -0,0 +1,149 @@
+#include "thread_pool.h"
+
+namespace SixNimmt {
+
+ThreadPool::ThreadPool(int numThreads) {
+    if (numThreads <= 0) {
+        numThreads = static_cast<int>(std::thread::hardware_concurrency());
+        if (numThreads <= 0) numThreads = 1;
+    }
+
+    for (int i = 0; i < numThreads; ++i) {
+        queues.push_back(std::make_unique<WorkQueue>());
+    }
+
+    // Worker 0 is the thread calling parallelFor
+    for (int i = 1; i < numThreads; ++i) {
+        threads.emplace_back(&ThreadPool::workerLoop, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wakeWorkers.notify_all();
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+}
+
+void ThreadPool::parallelFor(size_t numTasks, const Task& task) {
+    if (numTasks == 0) return;
+
+    // Deal out contiguous blocks so that neighbouring tasks start on the same worker
+    size_t numWorkers = queues.size();
+    for (size_t i = 0; i < numWorkers; ++i) {
+        std::lock_guard<std::mutex> lock(queues[i]->mutex);
+        queues[i]->begin = numTasks * i / numWorkers;
+        queues[i]->end = numTasks * (i + 1) / numWorkers;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        currentTask = &task;
+        activeWorkers = static_cast<int>(threads.size());
+        firstError = nullptr;
+        generation++;
+    }
+    wakeWorkers.notify_all();
+
+    runWorker(0, task);
+
+    std::exception_ptr error;
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        jobDone.wait(lock, [this] { return activeWorkers == 0; });
+        currentTask = nullptr;
+        error = firstError;
+        firstError = nullptr;
+    }
+
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+void ThreadPool::workerLoop(int workerIndex) {
+    unsigned long seenGeneration = 0;
+
+    while (true) {
+        const Task* task;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wakeWorkers.wait(lock, [&] { return stopping || generation != seenGeneration; });
+            if (stopping) return;
+            seenGeneration = generation;
+            task = currentTask;
+        }
+
+        runWorker(workerIndex, *task);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            activeWorkers--;
+        }
+        jobDone.notify_one();
+    }
+}
+
+void ThreadPool::runWorker(int workerIndex, const Task& task) {
+    size_t taskIndex;
+    while (popTask(workerIndex, taskIndex) || (stealTasks(workerIndex) && popTask(workerIndex, taskIndex))) {
+        try {
+            task(workerIndex, taskIndex);
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!firstError) firstError = std::current_exception();
+        }
+    }
+}
+
+bool ThreadPool::popTask(int workerIndex, size_t& taskIndex) {
+    WorkQueue& queue = *queues[workerIndex];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.begin == queue.end) return false;
+    taskIndex = queue.begin++;
+    return true;
+}
+
+bool ThreadPool::stealTasks(int workerIndex) {
+    while (true) {
+        // Pick the victim with the most work left
+        int victim = -1;
+        size_t mostRemaining = 0;
+        for (size_t i = 0; i < queues.size(); ++i) {
+            if (static_cast<int>(i) == workerIndex) continue;
+            std::lock_guard<std::mutex> lock(queues[i]->mutex);
+            size_t remaining = queues[i]->end - queues[i]->begin;
+            if (remaining > mostRemaining) {
+                mostRemaining = remaining;
+                victim = static_cast<int>(i);
+            }
+        }
+
+        if (victim == -1) return false;
+
+        // Take the upper half of the victim's range; the victim may have
+        // drained it since we looked, in which case we look again
+        size_t stolenBegin, stolenEnd;
+        {
+            std::lock_guard<std::mutex> lock(queues[victim]->mutex);
+            WorkQueue& queue = *queues[victim];
+            size_t remaining = queue.end - queue.begin;
+            if (remaining == 0) continue;
+            stolenEnd = queue.end;
+            stolenBegin = queue.end - (remaining + 1) / 2;
+            queue.end = stolenBegin;
+        }
+
+        WorkQueue& own = *queues[workerIndex];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        own.begin = stolenBegin;
+        own.end = stolenEnd;
+        return true;
+    }
+}
+
+} // namespace SixNimmt
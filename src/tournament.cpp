@@ -0,0 +1,981 @@
+#include "tournament.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <iomanip>
+#include <istream>
+#include <limits>
+#include <numeric>
+#include <ostream>
+#include <sstream>
+#include <stdexcept>
+
+namespace SixNimmt {
+
+void AgentStats::add(const AgentStats& other) {
+    games += other.games;
+    wins += other.wins;
+    totalScore += other.totalScore;
+    totalRank += other.totalRank;
+    deals += other.deals;
+    marginSum += other.marginSum;
+    marginSquares += other.marginSquares;
+}
+
+void AgentStats::addDeal(long margin) {
+    deals++;
+    marginSum += margin;
+    marginSquares += margin * margin;
+}
+
+double AgentStats::marginStandardError() const {
+    if (deals < 2) return 0.0;
+    double mean = averageMargin();
+    double variance = (static_cast<double>(marginSquares) - deals * mean * mean) / (deals - 1);
+    return std::sqrt(std::max(0.0, variance) / deals);
+}
+
+bool parseOutputFormat(const std::string& text, OutputFormat& format) {
+    if (text == "table") {
+        format = OutputFormat::Table;
+    } else if (text == "csv") {
+        format = OutputFormat::Csv;
+    } else if (text == "json") {
+        format = OutputFormat::Json;
+    } else if (text == "shard") {
+        format = OutputFormat::Shard;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+double sprtLogLikelihoodRatio(const SprtSettings& settings, long wins, long losses) {
+    // H1: p = 0.5 + delta against H0: p = 0.5; ties do not move the ratio.
+    // Between even agents it drifts down, towards accepting H0.
+    return wins * std::log(1.0 + 2.0 * settings.delta) + losses * std::log(1.0 - 2.0 * settings.delta);
+}
+
+// Each direction gets half of alpha
+double sprtUpperBound(const SprtSettings& settings) {
+    return std::log((1.0 - settings.beta) / (settings.alpha / 2.0));
+}
+
+double sprtLowerBound(const SprtSettings& settings) {
+    return std::log(settings.beta / (1.0 - settings.alpha / 2.0));
+}
+
+void Tournament::addPlayer(std::unique_ptr<Player> player) {
+    players.push_back(std::move(player));
+}
+
+TournamentResult Tournament::run(int numSeats, int gamesPerTable, int numThreads, uint64_t seed) {
+    if (numSeats < 2 || numSeats > MAX_PLAYERS) {
+        throw std::invalid_argument("seats must be between 2 and " + std::to_string(MAX_PLAYERS));
+    }
+    if (players.size() < 2) {
+        throw std::invalid_argument("a tournament needs at least 2 agents");
+    }
+    if (gamesPerTable <= 0) {
+        throw std::invalid_argument("games per table must be positive");
+    }
+    if (moveTimeLimit.count() < 0) {
+        throw std::invalid_argument("move time limit must not be negative");
+    }
+    if (sprt && (sprt->delta <= 0.0 || sprt->delta >= 0.5 || sprt->alpha <= 0.0 || sprt->alpha >= 1.0 ||
+                 sprt->beta <= 0.0 || sprt->beta >= 1.0 || sprt->batchSize <= 0)) {
+        throw std::invalid_argument("SPRT needs 0 < delta < 0.5, error rates in (0, 1) and a positive batch size");
+    }
+    if (shard && (sprt || timeDecisions)) {
+        throw std::invalid_argument("a shard cannot use early stopping or decision timing");
+    }
+    if (collectStats && (bootstrapReplicates < 0 || bootstrapReplicates > 100000)) {
+        throw std::invalid_argument("bootstrap replicates must be between 0 and 100000");
+    }
+    if (shard && (shard->first < 0 || shard->second <= shard->first)) {
+        throw std::invalid_argument("a shard needs 0 <= first deal < end deal");
+    }
+
+    // Every agent must be clonable so each worker can own its instances
+    for (const auto& player : players) {
+        if (!player->clone()) {
+            throw std::invalid_argument("cannot create instances of " + player->getName() +
+                                        ": register it with SIXNIMMT_REGISTER_AGENT or override clone()");
+        }
+    }
+
+    ThreadPool pool(numThreads);
+
+    TournamentResult result;
+    result.seed = seed;
+    result.numSeats = numSeats;
+    result.gamesPerTable = gamesPerTable;
+    result.numThreads = pool.size();
+    result.earlyStopping = sprt && numSeats == 2;
+    result.duplicate = duplicate;
+    result.timed = timeDecisions;
+    result.moveTimeLimit = moveTimeLimit;
+    result.detailedStats = collectStats;
+    for (const auto& player : players) {
+        result.agentNames.push_back(player->getName());
+    }
+
+    // Round-robin of pairs, or a single table with everyone
+    if (numSeats == 2) {
+        for (size_t i = 0; i < players.size(); ++i) {
+            for (size_t j = i + 1; j < players.size(); ++j) {
+                result.tables.push_back({{static_cast<int>(i), static_cast<int>(j)}, {}});
+            }
+        }
+    } else {
+        TableResult table;
+        table.lineup.resize(players.size());
+        std::iota(table.lineup.begin(), table.lineup.end(), 0);
+        result.tables.push_back(table);
+    }
+    for (TableResult& table : result.tables) {
+        table.stats.resize(table.lineup.size());
+    }
+
+    // Every (table, game) pair is an independent task. Each worker
+    // accumulates into its own copy of the tables, which are summed after
+    // every pass; the totals are plain integer sums and do not depend on
+    // which worker played which game.
+    std::vector<std::vector<TableResult>> workerTables(pool.size(), result.tables);
+
+    // Decision latencies per worker and agent, merged at the end
+    std::vector<std::vector<DecisionStats>> workerDecisions(pool.size());
+    if (timeDecisions) {
+        for (auto& decisions : workerDecisions) {
+            decisions.resize(players.size());
+        }
+    }
+
+    // Statistics per worker, merged at the end
+    std::vector<TournamentStats> workerStats;
+    if (collectStats) {
+        workerStats.assign(pool.size(), TournamentStats(static_cast<int>(players.size()), bootstrapReplicates));
+    }
+
+    // Idle instances of every agent per worker. Each new Game calls
+    // Player::initialize(), which resets an agent, so instances are cloned
+    // on first use and then recycled
+    std::vector<std::vector<std::vector<std::unique_ptr<Player>>>> agentPool(pool.size());
+    for (auto& agents : agentPool) {
+        agents.resize(players.size());
+    }
+
+    // One deal of a table. Normally that is one game, with the lineup
+    // rotated by the deal number. In duplicate mode the deal is replayed once
+    // per rotation of the lineup, so every agent plays every seat's hand.
+    int gamesPerDeal = 1;
+    if (duplicate) {
+        gamesPerDeal = static_cast<int>(result.tables[0].lineup.size());
+    }
+
+    auto playDeal = [&](int worker, size_t tableIndex, int dealNum) {
+        TableResult& table = workerTables[worker][tableIndex];
+        int lineupSize = static_cast<int>(table.lineup.size());
+        uint64_t dealSeed = deriveSeed(seed, tableIndex, dealNum);
+        std::vector<Card> deck = Game::shuffledDeck(dealSeed);
+
+        // Penalty margin per lineup position over the deal: own points times
+        // the number of opponents minus the opponents' points
+        std::array<long, MAX_PLAYERS> margins{};
+
+        for (int rotation = 0; rotation < gamesPerDeal; ++rotation) {
+            int offset = duplicate ? rotation : dealNum;
+
+            std::array<int, MAX_PLAYERS> positions;   // lineup position in each seat
+            std::vector<std::unique_ptr<Player>> gamePlayers;
+            for (int seat = 0; seat < numSeats; ++seat) {
+                positions[seat] = (seat + offset) % lineupSize;
+                std::vector<std::unique_ptr<Player>>& idle = agentPool[worker][table.lineup[positions[seat]]];
+                if (idle.empty()) {
+                    gamePlayers.push_back(players[table.lineup[positions[seat]]]->clone());
+                } else {
+                    gamePlayers.push_back(std::move(idle.back()));
+                    idle.pop_back();
+                }
+            }
+
+            Game game(std::move(gamePlayers), deck, dealSeed);
+            if (timeDecisions) {
+                for (int seat = 0; seat < numSeats; ++seat) {
+                    game.setDecisionStats(seat, &workerDecisions[worker][table.lineup[positions[seat]]]);
+                }
+                game.setMoveTimeLimit(moveTimeLimit);
+            }
+            std::vector<int> scores = game.playGame(false);
+
+            gamePlayers = game.releasePlayers();
+            for (int seat = 0; seat < numSeats; ++seat) {
+                agentPool[worker][table.lineup[positions[seat]]].push_back(std::move(gamePlayers[seat]));
+            }
+
+            int totalScore = 0;
+            for (int seat = 0; seat < numSeats; ++seat) {
+                totalScore += scores[seat];
+            }
+
+            if (collectStats) {
+                std::array<int, MAX_PLAYERS> seatAgents;
+                for (int seat = 0; seat < numSeats; ++seat) {
+                    seatAgents[seat] = table.lineup[positions[seat]];
+                }
+                // All replays of a deal share its bootstrap weights
+                workerStats[worker].addGame(seatAgents.data(), scores.data(), numSeats,
+                                            deriveSeed(seed, tableIndex, dealNum, 1));
+            }
+
+            for (int seat = 0; seat < numSeats; ++seat) {
+                int lower = 0;
+                int tied = 0;
+                for (int other = 0; other < numSeats; ++other) {
+                    if (scores[other] < scores[seat]) lower++;
+                    if (other != seat && scores[other] == scores[seat]) tied++;
+                }
+
+                AgentStats& stats = table.stats[positions[seat]];
+                stats.games++;
+                stats.totalScore += scores[seat];
+                stats.totalRank += lower + 1;
+                if (lower == 0 && tied == 0) stats.wins++;
+                margins[positions[seat]] += scores[seat] * numSeats - totalScore;
+            }
+        }
+
+        if (duplicate) {
+            for (int position = 0; position < lineupSize; ++position) {
+                table.stats[position].addDeal(margins[position]);
+            }
+        }
+    };
+
+    // Plays deals [first, first + count) of the listed tables in parallel
+    // and merges the workers' statistics into the result
+    auto playPass = [&](const std::vector<size_t>& tables, const std::vector<int>& firstDeals,
+                        const std::vector<int>& counts) {
+        std::vector<size_t> firstTask(tables.size() + 1, 0);
+        for (size_t i = 0; i < tables.size(); ++i) {
+            firstTask[i + 1] = firstTask[i] + counts[i];
+        }
+
+        pool.parallelFor(firstTask.back(), [&](int worker, size_t task) {
+            size_t i = std::upper_bound(firstTask.begin(), firstTask.end(), task) - firstTask.begin() - 1;
+            playDeal(worker, tables[i], firstDeals[i] + static_cast<int>(task - firstTask[i]));
+        });
+
+        for (size_t i = 0; i < tables.size(); ++i) {
+            TableResult& table = result.tables[tables[i]];
+            table.deals += counts[i];
+            table.games += counts[i] * gamesPerDeal;
+            for (auto& worker : workerTables) {
+                for (size_t position = 0; position < table.lineup.size(); ++position) {
+                    table.stats[position].add(worker[tables[i]].stats[position]);
+                    worker[tables[i]].stats[position] = AgentStats();
+                }
+            }
+        }
+    };
+
+    // Budgets are in games; a table plays whole deals
+    int dealsPerTable = std::max(1, gamesPerTable / gamesPerDeal);
+    result.scheduleDeals = static_cast<long>(dealsPerTable) * result.tables.size();
+    result.firstDeal = 0;
+    result.endDeal = result.scheduleDeals;
+    if (shard) {
+        if (shard->first >= result.scheduleDeals) {
+            throw std::invalid_argument("the schedule has only " + std::to_string(result.scheduleDeals) + " deals");
+        }
+        result.firstDeal = shard->first;
+        result.endDeal = std::min(shard->second, result.scheduleDeals);
+    }
+
+    if (result.earlyStopping) {
+        // Passes of up to batchSize games per undecided pairing. Decisions
+        // are only taken between passes, so the games played (and the
+        // seeds they use) do not depend on the thread count. The budget a
+        // decided pairing leaves unused goes to the ones still open.
+        long budget = static_cast<long>(dealsPerTable) * result.tables.size();
+        long batchDeals = std::max(1, sprt->batchSize / gamesPerDeal);
+        std::vector<size_t> open(result.tables.size());
+        std::iota(open.begin(), open.end(), 0);
+
+        while (!open.empty() && budget > 0) {
+            long share = std::max(1L, budget / static_cast<long>(open.size()));
+            std::vector<size_t> tables;
+            std::vector<int> firstDeals;
+            std::vector<int> counts;
+            for (size_t t : open) {
+                if (budget == 0) break;
+                int count = static_cast<int>(std::min({batchDeals, share, budget}));
+                tables.push_back(t);
+                firstDeals.push_back(result.tables[t].deals);
+                counts.push_back(count);
+                budget -= count;
+            }
+            playPass(tables, firstDeals, counts);
+
+            std::vector<size_t> stillOpen;
+            for (size_t t : open) {
+                TableResult& table = result.tables[t];
+                for (int position = 0; position < 2; ++position) {
+                    table.llr[position] = sprtLogLikelihoodRatio(*sprt, table.stats[position].wins,
+                                                                 table.stats[1 - position].wins);
+                }
+                // The ratios move in opposite directions, so at most one
+                // crosses the upper bound
+                if (table.llr[0] >= sprtUpperBound(*sprt)) {
+                    table.leader = 0;
+                } else if (table.llr[1] >= sprtUpperBound(*sprt)) {
+                    table.leader = 1;
+                } else if (std::max(table.llr[0], table.llr[1]) <= sprtLowerBound(*sprt)) {
+                    table.noDifference = true;
+                } else {
+                    stillOpen.push_back(t);
+                }
+            }
+            open = stillOpen;
+        }
+        // Pairings still open when the budget runs out stay undecided
+    } else {
+        // The part of every table that falls into [firstDeal, endDeal)
+        std::vector<size_t> tables;
+        std::vector<int> firstDeals;
+        std::vector<int> counts;
+        for (size_t t = 0; t < result.tables.size(); ++t) {
+            long tableStart = static_cast<long>(t) * dealsPerTable;
+            long first = std::max(result.firstDeal, tableStart);
+            long end = std::min(result.endDeal, tableStart + dealsPerTable);
+            if (first >= end) continue;
+            tables.push_back(t);
+            firstDeals.push_back(static_cast<int>(first - tableStart));
+            counts.push_back(static_cast<int>(end - first));
+        }
+        playPass(tables, firstDeals, counts);
+    }
+
+    result.standings.resize(players.size());
+    for (const TableResult& table : result.tables) {
+        for (size_t position = 0; position < table.lineup.size(); ++position) {
+            result.standings[table.lineup[position]].add(table.stats[position]);
+        }
+    }
+
+    if (collectStats) {
+        result.statistics = TournamentStats(static_cast<int>(players.size()), bootstrapReplicates);
+        for (const TournamentStats& stats : workerStats) {
+            result.statistics.add(stats);
+        }
+    }
+
+    if (timeDecisions) {
+        result.decisions.resize(players.size());
+        for (const auto& decisions : workerDecisions) {
+            for (size_t agent = 0; agent < players.size(); ++agent) {
+                result.decisions[agent].add(decisions[agent]);
+            }
+        }
+    }
+
+    return result;
+}
+
+namespace {
+
+// Agent indices from best to worst: win rate, then average score
+std::vector<int> rankAgents(const TournamentResult& result) {
+    std::vector<int> order(result.standings.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](int a, int b) {
+        const AgentStats& sa = result.standings[a];
+        const AgentStats& sb = result.standings[b];
+        if (sa.winRate() != sb.winRate()) return sa.winRate() > sb.winRate();
+        return sa.averageScore() < sb.averageScore();
+    });
+    return order;
+}
+
+// SPRT outcome of a pairing
+std::string outcome(const TableResult& table) {
+    if (table.leader >= 0) return "decided";
+    return table.noDifference ? "no difference" : "undecided";
+}
+
+// SPRT outcome for the agent at a lineup position
+std::string decision(const TournamentResult& result, const TableResult& table, size_t position) {
+    if (!result.earlyStopping) return "";
+    if (table.leader < 0) return table.noDifference ? "even" : "undecided";
+    return table.leader == static_cast<int>(position) ? "stronger" : "weaker";
+}
+
+double microseconds(uint64_t nanoseconds) {
+    return nanoseconds / 1000.0;
+}
+
+std::string jsonString(const std::string& text) {
+    std::string quoted = "\"";
+    for (char c : text) {
+        if (c == '"' || c == '\\') quoted += '\\';
+        quoted += c;
+    }
+    return quoted + "\"";
+}
+
+// Ratings and bootstrap intervals of a result with detailed statistics,
+// computed once per report (each replicate is a separate rating fit)
+struct Ratings {
+    std::vector<double> elo;
+    std::vector<TournamentStats::Interval> eloInterval;
+    std::vector<TournamentStats::Interval> scoreInterval;
+
+    explicit Ratings(const TournamentResult& result) {
+        if (!result.detailedStats) return;
+        elo = result.statistics.eloRatings();
+        eloInterval = result.statistics.eloIntervals();
+        scoreInterval = result.statistics.averageScoreIntervals();
+    }
+};
+
+void writeTable(std::ostream& out, const TournamentResult& result) {
+    out << "\"6 nimmt!\" Tournament" << std::endl;
+    out << "Agents: " << result.agentNames.size() << std::endl;
+    out << "Seats: " << result.numSeats << (result.numSeats == 2 ? " (round-robin)" : " (free-for-all)") << std::endl;
+    out << "Games per table: " << result.gamesPerTable << std::endl;
+    out << "Threads: " << result.numThreads << std::endl;
+    out << "Seed: " << result.seed << std::endl;
+    if (result.earlyStopping) {
+        out << "Early stopping: SPRT" << std::endl;
+    }
+    if (result.duplicate) {
+        out << "Duplicate deals: margins are per deal, negative is better" << std::endl;
+    }
+    out << std::string(50, '=') << std::endl;
+
+    long totalGames = 0;
+    for (const TableResult& table : result.tables) {
+        out << "\n";
+        for (size_t position = 0; position < table.lineup.size(); ++position) {
+            out << (position ? " vs " : "") << result.agentNames[table.lineup[position]];
+        }
+        if (result.earlyStopping) {
+            out << " (" << table.games << " games, " << outcome(table) << ")";
+        }
+        out << std::endl;
+        for (size_t position = 0; position < table.lineup.size(); ++position) {
+            const AgentStats& stats = table.stats[position];
+            out << "  " << result.agentNames[table.lineup[position]] << ": " << stats.wins << " wins";
+            if (result.numSeats > 2) {
+                out << ", average rank " << std::fixed << std::setprecision(2) << stats.averageRank();
+            }
+            if (result.duplicate) {
+                out << ", margin " << std::fixed << std::setprecision(2) << stats.averageMargin() << " +/- "
+                    << stats.marginStandardError();
+            }
+            if (table.leader == static_cast<int>(position)) {
+                out << " - stronger";
+            }
+            out << std::endl;
+        }
+        totalGames += table.games;
+    }
+
+    if (result.earlyStopping) {
+        out << "\nGames played: " << totalGames << " of " << result.gamesPerTable * static_cast<long>(result.tables.size())
+            << std::endl;
+    }
+
+    // The name column fits the longest name (remote: and policy: names run long)
+    int longestName = 0;
+    for (const std::string& name : result.agentNames) {
+        longestName = std::max(longestName, static_cast<int>(name.size()));
+    }
+    int nameWidth = std::max(24, longestName + 2);
+    int extraWidth = nameWidth - 24;
+
+    out << "\n" << std::string(70 + extraWidth, '=') << std::endl;
+    out << "TOURNAMENT RESULTS" << std::endl;
+    out << std::string(70 + extraWidth, '=') << std::endl;
+
+    out << std::left << std::setw(nameWidth) << "Player"
+        << std::setw(10) << "Games"
+        << std::setw(10) << "Wins"
+        << std::setw(10) << "Win Rate"
+        << std::setw(11) << "Avg Score"
+        << std::setw(10) << "Avg Rank"
+        << (result.duplicate ? "Margin" : "") << std::endl;
+    out << std::string(70 + extraWidth, '-') << std::endl;
+
+    for (int agent : rankAgents(result)) {
+        const AgentStats& stats = result.standings[agent];
+        std::ostringstream winRate;
+        winRate << std::fixed << std::setprecision(1) << stats.winRate() * 100.0 << "%";
+        out << std::left << std::setw(nameWidth) << result.agentNames[agent]
+            << std::setw(10) << stats.games
+            << std::setw(10) << stats.wins
+            << std::setw(10) << winRate.str()
+            << std::setw(11) << std::fixed << std::setprecision(1) << stats.averageScore()
+            << std::setw(10) << std::setprecision(2) << stats.averageRank();
+        if (result.duplicate) {
+            out << stats.averageMargin() << " +/- " << stats.marginStandardError();
+        }
+        out << std::endl;
+    }
+
+    if (result.detailedStats) {
+        const TournamentStats& statistics = result.statistics;
+        Ratings ratings(result);
+        out << "\nRATINGS (Bradley-Terry on the Elo scale; 95% intervals from " << statistics.getReplicates()
+            << " bootstrap replicates)" << std::endl;
+        out << std::left << std::setw(nameWidth) << "Player"
+            << std::setw(8) << "Elo"
+            << std::setw(18) << "Elo interval"
+            << std::setw(18) << "Score interval"
+            << std::setw(8) << "Sd"
+            << "p10/p50/p90" << std::endl;
+        out << std::string(90 + extraWidth, '-') << std::endl;
+        for (int agent : rankAgents(result)) {
+            const ScoreHistogram& scores = statistics.getScores(agent);
+            std::ostringstream eloInterval;
+            std::ostringstream scoreInterval;
+            eloInterval << std::fixed << std::setprecision(0) << ratings.eloInterval[agent].low << " to "
+                        << ratings.eloInterval[agent].high;
+            scoreInterval << std::fixed << std::setprecision(2) << ratings.scoreInterval[agent].low << " to "
+                          << ratings.scoreInterval[agent].high;
+            out << std::left << std::setw(nameWidth) << result.agentNames[agent]
+                << std::setw(8) << std::fixed << std::setprecision(0) << ratings.elo[agent]
+                << std::setw(18) << eloInterval.str()
+                << std::setw(18) << scoreInterval.str()
+                << std::setw(8) << std::setprecision(2) << scores.stddev()
+                << scores.percentile(10) << "/" << scores.percentile(50) << "/" << scores.percentile(90) << std::endl;
+        }
+
+        // Share of the head-to-head points the row agent took from the column
+        // agent, over every game in which both sat (finishing order decides)
+        std::vector<int> order = rankAgents(result);
+        // Row labels are "#rank name"
+        int labelWidth = std::max(24, longestName + static_cast<int>(std::to_string(order.size()).size()) + 3);
+        out << "\nHEAD TO HEAD (% of points, row vs column)" << std::endl;
+        out << std::left << std::setw(labelWidth) << "";
+        for (size_t column = 0; column < order.size(); ++column) {
+            out << std::right << std::setw(7) << ("#" + std::to_string(column + 1));
+        }
+        out << std::endl;
+        for (size_t row = 0; row < order.size(); ++row) {
+            out << std::left << std::setw(labelWidth) << ("#" + std::to_string(row + 1) + " " + result.agentNames[order[row]]);
+            for (int opponent : order) {
+                out << std::right << std::setw(7);
+                if (opponent == order[row] || statistics.getPairwise().games(order[row], opponent) == 0) {
+                    out << "-";
+                } else {
+                    out << std::fixed << std::setprecision(1)
+                        << statistics.getPairwise().score(order[row], opponent) * 100.0;
+                }
+            }
+            out << std::endl;
+        }
+    }
+
+    if (result.timed) {
+        out << "\nDECISION LATENCY (us)";
+        if (result.moveTimeLimit.count() > 0) {
+            out << ", limit " << std::fixed << std::setprecision(1) << microseconds(result.moveTimeLimit.count());
+        }
+        out << std::endl;
+        out << std::left << std::setw(nameWidth) << "Player"
+            << std::setw(30) << "chooseCard p50/p99/max"
+            << std::setw(30) << "chooseRowToTake p50/p99/max"
+            << "Timeouts" << std::endl;
+        out << std::string(90 + extraWidth, '-') << std::endl;
+
+        auto percentiles = [](const LatencyHistogram& histogram) {
+            std::ostringstream text;
+            text << std::fixed << std::setprecision(1) << microseconds(histogram.percentile(50)) << " / "
+                 << microseconds(histogram.percentile(99)) << " / " << microseconds(histogram.max());
+            return text.str();
+        };
+        for (int agent : rankAgents(result)) {
+            const DecisionStats& decisions = result.decisions[agent];
+            out << std::left << std::setw(nameWidth) << result.agentNames[agent]
+                << std::setw(30) << percentiles(decisions.chooseCard)
+                << std::setw(30) << percentiles(decisions.chooseRowToTake)
+                << decisions.timeouts << std::endl;
+        }
+    }
+}
+
+// Latency columns are filled in on the standings rows of timed runs, and
+// rating columns on those of runs with detailed statistics
+void writeCsvRow(std::ostream& out, const std::string& table, const std::string& agent, const AgentStats& stats,
+                 const std::string& decision, const DecisionStats* decisions, const std::string& ratingColumns) {
+    out << table << "," << agent << "," << stats.games << "," << stats.wins << ","
+        << std::fixed << std::setprecision(4) << stats.winRate() << "," << stats.averageScore() << ","
+        << stats.averageRank() << "," << stats.deals << "," << stats.averageMargin() << ","
+        << stats.marginStandardError() << "," << decision;
+    if (decisions) {
+        for (const LatencyHistogram* histogram : {&decisions->chooseCard, &decisions->chooseRowToTake}) {
+            out << "," << std::setprecision(3) << microseconds(histogram->percentile(50)) << ","
+                << microseconds(histogram->percentile(99)) << "," << microseconds(histogram->max());
+        }
+        out << "," << decisions->timeouts;
+    } else {
+        out << ",,,,,,,";
+    }
+    out << "," << ratingColumns << "\n";
+}
+
+void writeCsv(std::ostream& out, const TournamentResult& result) {
+    out << "table,agent,games,wins,win_rate,avg_score,avg_rank,deals,avg_margin,margin_se,decision,"
+           "card_p50_us,card_p99_us,card_max_us,row_p50_us,row_p99_us,row_max_us,timeouts,"
+           "score_sd,elo,elo_low,elo_high\n";
+    for (size_t t = 0; t < result.tables.size(); ++t) {
+        const TableResult& table = result.tables[t];
+        for (size_t position = 0; position < table.lineup.size(); ++position) {
+            writeCsvRow(out, std::to_string(t), result.agentNames[table.lineup[position]], table.stats[position],
+                        decision(result, table, position), nullptr, ",,,");
+        }
+    }
+    Ratings ratings(result);
+    for (int agent : rankAgents(result)) {
+        std::ostringstream ratingColumns;
+        if (result.detailedStats) {
+            ratingColumns << std::fixed << std::setprecision(4) << result.statistics.getScores(agent).stddev() << ","
+                          << std::setprecision(1) << ratings.elo[agent] << "," << ratings.eloInterval[agent].low
+                          << "," << ratings.eloInterval[agent].high;
+        } else {
+            ratingColumns << ",,,";
+        }
+        writeCsvRow(out, "all", result.agentNames[agent], result.standings[agent], "",
+                    result.timed ? &result.decisions[agent] : nullptr, ratingColumns.str());
+    }
+    out.flush();
+}
+
+void writeJsonLatency(std::ostream& out, const LatencyHistogram& histogram) {
+    out << "{\"count\": " << histogram.count() << std::fixed << std::setprecision(3)
+        << ", \"p50_us\": " << microseconds(histogram.percentile(50))
+        << ", \"p99_us\": " << microseconds(histogram.percentile(99))
+        << ", \"max_us\": " << microseconds(histogram.max()) << "}";
+}
+
+void writeJsonRating(std::ostream& out, const TournamentResult& result, const Ratings& ratings, int agent) {
+    const ScoreHistogram& scores = result.statistics.getScores(agent);
+    out << "{\"elo\": " << std::fixed << std::setprecision(1) << ratings.elo[agent]
+        << ", \"elo_low\": " << ratings.eloInterval[agent].low << ", \"elo_high\": " << ratings.eloInterval[agent].high
+        << std::setprecision(4) << ", \"score_low\": " << ratings.scoreInterval[agent].low
+        << ", \"score_high\": " << ratings.scoreInterval[agent].high << ", \"score_sd\": " << scores.stddev()
+        << ", \"score_p10\": " << scores.percentile(10) << ", \"score_p50\": " << scores.percentile(50)
+        << ", \"score_p90\": " << scores.percentile(90) << "}";
+}
+
+void writeJsonStats(std::ostream& out, const std::string& agent, const AgentStats& stats,
+                    const DecisionStats* decisions = nullptr, const std::string& rating = "") {
+    out << "{\"agent\": " << jsonString(agent) << ", \"games\": " << stats.games << ", \"wins\": " << stats.wins
+        << std::fixed << std::setprecision(4) << ", \"win_rate\": " << stats.winRate()
+        << ", \"avg_score\": " << stats.averageScore() << ", \"avg_rank\": " << stats.averageRank();
+    if (stats.deals) {
+        out << ", \"deals\": " << stats.deals << ", \"avg_margin\": " << stats.averageMargin()
+            << ", \"margin_se\": " << stats.marginStandardError();
+    }
+    if (decisions) {
+        out << ", \"latency\": {\"choose_card\": ";
+        writeJsonLatency(out, decisions->chooseCard);
+        out << ", \"choose_row_to_take\": ";
+        writeJsonLatency(out, decisions->chooseRowToTake);
+        out << ", \"timeouts\": " << decisions->timeouts << "}";
+    }
+    if (!rating.empty()) {
+        out << ", \"rating\": " << rating;
+    }
+    out << "}";
+}
+
+void writeJson(std::ostream& out, const TournamentResult& result) {
+    out << "{\n";
+    out << "  \"seed\": " << result.seed << ",\n";
+    out << "  \"seats\": " << result.numSeats << ",\n";
+    out << "  \"games_per_table\": " << result.gamesPerTable << ",\n";
+    out << "  \"threads\": " << result.numThreads << ",\n";
+    out << "  \"early_stopping\": " << (result.earlyStopping ? "true" : "false") << ",\n";
+    out << "  \"duplicate\": " << (result.duplicate ? "true" : "false") << ",\n";
+    if (result.timed) {
+        out << "  \"move_time_limit_us\": " << std::fixed << std::setprecision(3)
+            << microseconds(result.moveTimeLimit.count()) << ",\n";
+    }
+
+    out << "  \"tables\": [";
+    for (size_t t = 0; t < result.tables.size(); ++t) {
+        const TableResult& table = result.tables[t];
+        out << (t ? ",\n" : "\n") << "    {\"games\": " << table.games << ", \"deals\": " << table.deals;
+        if (result.earlyStopping) {
+            out << ", \"outcome\": " << jsonString(outcome(table)) << ", \"llr\": [" << std::fixed
+                << std::setprecision(4) << table.llr[0] << ", " << table.llr[1] << "], \"stronger\": "
+                << (table.leader < 0 ? "null" : jsonString(result.agentNames[table.lineup[table.leader]]));
+        }
+        out << ", \"results\": [";
+        for (size_t position = 0; position < table.lineup.size(); ++position) {
+            out << (position ? ", " : "");
+            writeJsonStats(out, result.agentNames[table.lineup[position]], table.stats[position]);
+        }
+        out << "]}";
+    }
+    out << "\n  ],\n";
+
+    Ratings ratings(result);
+    out << "  \"standings\": [";
+    const char* separator = "\n    ";
+    for (int agent : rankAgents(result)) {
+        out << separator;
+        std::ostringstream rating;
+        if (result.detailedStats) writeJsonRating(rating, result, ratings, agent);
+        writeJsonStats(out, result.agentNames[agent], result.standings[agent],
+                       result.timed ? &result.decisions[agent] : nullptr, rating.str());
+        separator = ",\n    ";
+    }
+    out << "\n  ]";
+
+    if (result.detailedStats) {
+        // Share of the head-to-head points, agents in input order
+        const PairwiseMatrix& pairwise = result.statistics.getPairwise();
+        out << ",\n  \"bootstrap_replicates\": " << result.statistics.getReplicates();
+        out << ",\n  \"head_to_head\": [";
+        for (int agent = 0; agent < pairwise.size(); ++agent) {
+            out << (agent ? ",\n    [" : "\n    [");
+            for (int opponent = 0; opponent < pairwise.size(); ++opponent) {
+                out << (opponent ? ", " : "");
+                if (opponent == agent || pairwise.games(agent, opponent) == 0) {
+                    out << "null";
+                } else {
+                    out << std::fixed << std::setprecision(4) << pairwise.score(agent, opponent);
+                }
+            }
+            out << "]";
+        }
+        out << "\n  ]";
+    }
+    out << "\n}" << std::endl;
+}
+
+void writeShard(std::ostream& out, const TournamentResult& result) {
+    out << "6NSHARD " << SHARD_FORMAT_VERSION << "\n";
+    out << "seed " << result.seed << " seats " << result.numSeats << " games_per_table " << result.gamesPerTable
+        << " duplicate " << (result.duplicate ? 1 : 0) << "\n";
+    out << "deals " << result.firstDeal << " " << result.endDeal << " " << result.scheduleDeals << "\n";
+    out << "agents " << result.agentNames.size() << "\n";
+    // One name per line, read back whole, so names may hold spaces
+    for (const std::string& name : result.agentNames) {
+        if (name.find('\n') != std::string::npos) {
+            throw std::invalid_argument("agent name " + name + " cannot go into a shard file");
+        }
+        out << name << "\n";
+    }
+    out << "tables " << result.tables.size() << "\n";
+    for (const TableResult& table : result.tables) {
+        out << "table " << table.games << " " << table.deals << " " << table.lineup.size();
+        for (int agent : table.lineup) {
+            out << " " << agent;
+        }
+        out << "\n";
+        for (const AgentStats& stats : table.stats) {
+            out << stats.games << " " << stats.wins << " " << stats.totalScore << " " << stats.totalRank << " "
+                << stats.deals << " " << stats.marginSum << " " << stats.marginSquares << "\n";
+        }
+    }
+    out << "statistics " << (result.detailedStats ? 1 : 0) << "\n";
+    if (result.detailedStats) {
+        result.statistics.write(out);
+    }
+    out.flush();
+}
+
+// Reads the next token, which must be label
+void expectToken(std::istream& in, const std::string& label) {
+    std::string token;
+    if (!(in >> token) || token != label) {
+        throw std::invalid_argument("shard file: expected \"" + label + "\"");
+    }
+}
+
+template <typename T>
+T readValue(std::istream& in, const std::string& field) {
+    T value;
+    if (!(in >> value)) throw std::invalid_argument("shard file: bad " + field);
+    return value;
+}
+
+} // namespace
+
+TournamentResult readShard(std::istream& in) {
+    TournamentResult result;
+    expectToken(in, "6NSHARD");
+    int version = readValue<int>(in, "version");
+    if (version < 1 || version > SHARD_FORMAT_VERSION) {
+        throw std::invalid_argument("shard file: unsupported version");
+    }
+
+    expectToken(in, "seed");
+    result.seed = readValue<uint64_t>(in, "seed");
+    expectToken(in, "seats");
+    result.numSeats = readValue<int>(in, "seats");
+    expectToken(in, "games_per_table");
+    result.gamesPerTable = readValue<int>(in, "games per table");
+    expectToken(in, "duplicate");
+    result.duplicate = readValue<int>(in, "duplicate flag") != 0;
+
+    expectToken(in, "deals");
+    result.firstDeal = readValue<long>(in, "deal range");
+    result.endDeal = readValue<long>(in, "deal range");
+    result.scheduleDeals = readValue<long>(in, "deal range");
+    if (result.firstDeal < 0 || result.endDeal < result.firstDeal || result.scheduleDeals < result.endDeal) {
+        throw std::invalid_argument("shard file: bad deal range");
+    }
+
+    expectToken(in, "agents");
+    size_t numAgents = readValue<size_t>(in, "agent count");
+    if (numAgents < 2 || numAgents > 1000) throw std::invalid_argument("shard file: bad agent count");
+    in.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+    for (size_t i = 0; i < numAgents; ++i) {
+        std::string name;
+        if (!std::getline(in, name) || name.empty()) throw std::invalid_argument("shard file: bad agent name");
+        result.agentNames.push_back(name);
+    }
+
+    expectToken(in, "tables");
+    size_t numTables = readValue<size_t>(in, "table count");
+    if (numTables > numAgents * numAgents) throw std::invalid_argument("shard file: bad table count");
+    for (size_t t = 0; t < numTables; ++t) {
+        TableResult table;
+        expectToken(in, "table");
+        table.games = readValue<int>(in, "table games");
+        table.deals = readValue<int>(in, "table deals");
+        size_t lineupSize = readValue<size_t>(in, "lineup size");
+        if (lineupSize < 2 || lineupSize > numAgents) throw std::invalid_argument("shard file: bad lineup size");
+        for (size_t position = 0; position < lineupSize; ++position) {
+            int agent = readValue<int>(in, "lineup");
+            if (agent < 0 || agent >= static_cast<int>(numAgents)) throw std::invalid_argument("shard file: bad lineup");
+            table.lineup.push_back(agent);
+        }
+        table.stats.resize(lineupSize);
+        for (AgentStats& stats : table.stats) {
+            stats.games = readValue<long>(in, "statistics");
+            stats.wins = readValue<long>(in, "statistics");
+            stats.totalScore = readValue<long>(in, "statistics");
+            stats.totalRank = readValue<long>(in, "statistics");
+            stats.deals = readValue<long>(in, "statistics");
+            stats.marginSum = readValue<long>(in, "statistics");
+            stats.marginSquares = readValue<long>(in, "statistics");
+        }
+        result.tables.push_back(table);
+    }
+
+    if (version >= 2) {
+        expectToken(in, "statistics");
+        result.detailedStats = readValue<int>(in, "statistics flag") != 0;
+        if (result.detailedStats) {
+            try {
+                result.statistics = TournamentStats::read(in);
+            } catch (const std::invalid_argument& e) {
+                throw std::invalid_argument(std::string("shard file: ") + e.what());
+            }
+            if (result.statistics.numAgents() != static_cast<int>(numAgents)) {
+                throw std::invalid_argument("shard file: statistics do not match the agents");
+            }
+        }
+    }
+
+    result.standings.resize(numAgents);
+    for (const TableResult& table : result.tables) {
+        for (size_t position = 0; position < table.lineup.size(); ++position) {
+            result.standings[table.lineup[position]].add(table.stats[position]);
+        }
+    }
+    return result;
+}
+
+TournamentResult mergeShards(const std::vector<TournamentResult>& shards) {
+    if (shards.empty()) throw std::invalid_argument("no shards to merge");
+
+    std::vector<const TournamentResult*> order;
+    for (const TournamentResult& shard : shards) {
+        order.push_back(&shard);
+    }
+    std::sort(order.begin(), order.end(), [](const TournamentResult* a, const TournamentResult* b) {
+        return a->firstDeal < b->firstDeal;
+    });
+
+    const TournamentResult& first = *order[0];
+    TournamentResult merged = first;
+    merged.numThreads = 0;
+    for (TableResult& table : merged.tables) {
+        table.games = table.deals = 0;
+        std::fill(table.stats.begin(), table.stats.end(), AgentStats());
+    }
+    merged.statistics = TournamentStats(first.statistics.numAgents(), first.statistics.getReplicates());
+
+    long covered = 0;
+    for (const TournamentResult* shard : order) {
+        if (shard->seed != first.seed || shard->numSeats != first.numSeats ||
+            shard->gamesPerTable != first.gamesPerTable || shard->duplicate != first.duplicate ||
+            shard->earlyStopping || shard->timed || shard->scheduleDeals != first.scheduleDeals ||
+            shard->agentNames != first.agentNames || shard->tables.size() != first.tables.size() ||
+            shard->detailedStats != first.detailedStats ||
+            shard->statistics.getReplicates() != first.statistics.getReplicates()) {
+            throw std::invalid_argument("shards come from different tournaments");
+        }
+        if (shard->firstDeal != covered) {
+            throw std::invalid_argument(shard->firstDeal > covered
+                                            ? "deals " + std::to_string(covered) + " to " +
+                                                  std::to_string(shard->firstDeal) + " are missing"
+                                            : "shards overlap at deal " + std::to_string(shard->firstDeal));
+        }
+        covered = shard->endDeal;
+
+        merged.numThreads += shard->numThreads;
+        merged.statistics.add(shard->statistics);
+        for (size_t t = 0; t < merged.tables.size(); ++t) {
+            TableResult& table = merged.tables[t];
+            const TableResult& part = shard->tables[t];
+            if (part.lineup != table.lineup) throw std::invalid_argument("shards come from different tournaments");
+            table.games += part.games;
+            table.deals += part.deals;
+            for (size_t position = 0; position < table.lineup.size(); ++position) {
+                table.stats[position].add(part.stats[position]);
+            }
+        }
+    }
+    if (covered != first.scheduleDeals) {
+        throw std::invalid_argument("deals " + std::to_string(covered) + " to " +
+                                    std::to_string(first.scheduleDeals) + " are missing");
+    }
+
+    merged.firstDeal = 0;
+    merged.endDeal = merged.scheduleDeals;
+    merged.standings.assign(merged.agentNames.size(), AgentStats());
+    for (const TableResult& table : merged.tables) {
+        for (size_t position = 0; position < table.lineup.size(); ++position) {
+            merged.standings[table.lineup[position]].add(table.stats[position]);
+        }
+    }
+    return merged;
+}
+
+void writeResults(std::ostream& out, const TournamentResult& result, OutputFormat format) {
+    switch (format) {
+    case OutputFormat::Table:
+        writeTable(out, result);
+        break;
+    case OutputFormat::Csv:
+        writeCsv(out, result);
+        break;
+    case OutputFormat::Json:
+        writeJson(out, result);
+        break;
+    case OutputFormat::Shard:
+        writeShard(out, result);
+        break;
+    }
+}
+
+} // namespace SixNimmt